@@ -20,13 +20,68 @@
 #include "framework/mlt_version.h"
 #include "mlt++/Mlt.h"
 #include "renderjob.h"
+#include "segmentrenderjob.h"
 #include <QApplication>
 #include <QDir>
 #include <QDomDocument>
 #include <QString>
 #include <QStringList>
 #include <QObject>
+#include <atomic>
 #include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+std::mutex outputMutex;
+
+// Progress protocol read by the timeline preview manager
+void reportChunk(const char *state, int frame)
+{
+    std::lock_guard<std::mutex> lock(outputMutex);
+    fprintf(stderr, "%s:%d \n", state, frame);
+    fflush(stderr);
+}
+
+/** @brief Render chunks of the playlist until all are done. Chunks are taken in list order from a counter shared by all workers.
+ *  Returns false if a consumer could not be created */
+bool renderChunks(Mlt::Profile &profile, Mlt::Producer &prod, const QStringList &chunks, std::atomic<int> &nextChunk, int chunkSize, const QDir &baseFolder,
+                  const QString &extension, const QStringList &consumerParams)
+{
+    int ix;
+    while ((ix = nextChunk++) < chunks.count()) {
+        const QString &frame = chunks.at(ix);
+        reportChunk("START", frame.toInt());
+        QString fileName = QStringLiteral("%1.%2").arg(frame).arg(extension);
+        if (baseFolder.exists(fileName)) {
+            // Don't overwrite an existing file
+            reportChunk("DONE", frame.toInt());
+            continue;
+        }
+        QScopedPointer<Mlt::Producer> playlst(prod.cut(frame.toInt(), frame.toInt() + chunkSize));
+        QScopedPointer<Mlt::Consumer> cons(
+            new Mlt::Consumer(profile, QString("avformat:%1").arg(baseFolder.absoluteFilePath(fileName)).toUtf8().constData()));
+        for (const QString &param : consumerParams) {
+            if (param.contains(QLatin1Char('='))) {
+                cons->set(param.section(QLatin1Char('='), 0, 0).toUtf8().constData(), param.section(QLatin1Char('='), 1).toUtf8().constData());
+            }
+        }
+        if (!cons->is_valid()) {
+            fprintf(stderr, " = =  = INVALID CONSUMER\n\n");
+            return false;
+        }
+        cons->set("terminate_on_pause", 1);
+        cons->connect(*playlst);
+        playlst.reset();
+        cons->run();
+        cons->stop();
+        cons->purge();
+        reportChunk("DONE", frame.toInt());
+    }
+    return true;
+}
+} // namespace
 
 int main(int argc, char **argv)
 {
@@ -52,6 +107,23 @@ int main(int argc, char **argv)
             pid = args.at(0).section(QLatin1Char(':'), 1).toInt();
             args.removeFirst();
         }
+        // number of chunks rendered at the same time in split mode
+        int workers = 1;
+        if (args.count() > 0 && args.at(0).startsWith(QLatin1String("-workers:"))) {
+            workers = qMax(1, args.at(0).section(QLatin1Char(':'), 1).toInt());
+            args.removeFirst();
+        }
+        // number of segments rendered in parallel and joined with ffmpeg
+        int segments = 1;
+        if (args.count() > 0 && args.at(0).startsWith(QLatin1String("-segments:"))) {
+            segments = qMax(1, args.at(0).section(QLatin1Char(':'), 1).toInt());
+            args.removeFirst();
+        }
+        QString ffmpeg = QStringLiteral("ffmpeg");
+        if (args.count() > 0 && args.at(0).startsWith(QLatin1String("-ffmpeg:"))) {
+            ffmpeg = args.at(0).section(QLatin1Char(':'), 1);
+            args.removeFirst();
+        }
         // Do we want a split render
         if (args.count() > 0 && args.at(0) == QLatin1String("-split")) {
             args.removeFirst();
@@ -81,33 +153,34 @@ int main(int argc, char **argv)
             }
             const char *localename = prod.get_lcnumeric();
             QLocale::setDefault(QLocale(localename));
-            for (const QString &frame : chunks) {
-                fprintf(stderr, "START:%d \n", frame.toInt());
-                QString fileName = QStringLiteral("%1.%2").arg(frame).arg(extension);
-                if (baseFolder.exists(fileName)) {
-                    // Don't overwrite an existing file
-                    fprintf(stderr, "DONE:%d \n", frame.toInt());
-                    continue;
-                }
-                QScopedPointer<Mlt::Producer> playlst(prod.cut(frame.toInt(), frame.toInt() + chunkSize));
-                QScopedPointer<Mlt::Consumer> cons(
-                    new Mlt::Consumer(profile, QString("avformat:%1").arg(baseFolder.absoluteFilePath(fileName)).toUtf8().constData()));
-                for (const QString &param : consumerParams) {
-                    if (param.contains(QLatin1Char('='))) {
-                        cons->set(param.section(QLatin1Char('='), 0, 0).toUtf8().constData(), param.section(QLatin1Char('='), 1).toUtf8().constData());
+            if (consumerParams.contains(QStringLiteral("glsl.=1"))) {
+                // Movit consumers share the GPU context, render one chunk at a time
+                workers = 1;
+            }
+            workers = qMin(workers, chunks.count());
+            // Each worker has its own producer, MLT services are not shared between threads
+            std::atomic<int> nextChunk(0);
+            std::atomic<bool> failed(false);
+            std::vector<std::thread> threads;
+            for (int i = 1; i < workers; ++i) {
+                threads.emplace_back([&]() {
+                    Mlt::Profile workerProfile(profilePath.toUtf8().constData());
+                    workerProfile.set_explicit(1);
+                    Mlt::Producer workerProd(workerProfile, nullptr, playlist.toUtf8().constData());
+                    if (!workerProd.is_valid() ||
+                        !renderChunks(workerProfile, workerProd, chunks, nextChunk, chunkSize, baseFolder, extension, consumerParams)) {
+                        failed = true;
                     }
-                }
-                if (!cons->is_valid()) {
-                    fprintf(stderr, " = =  = INVALID CONSUMER\n\n");
-                    return 1;
-                }
-                cons->set("terminate_on_pause", 1);
-                cons->connect(*playlst);
-                playlst.reset();
-                cons->run();
-                cons->stop();
-                cons->purge();
-                fprintf(stderr, "DONE:%d \n", frame.toInt());
+                });
+            }
+            if (!renderChunks(profile, prod, chunks, nextChunk, chunkSize, baseFolder, extension, consumerParams)) {
+                failed = true;
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            if (failed) {
+                return 1;
             }
             // Mlt::Factory::close();
             fprintf(stderr, "+ + + RENDERING FINSHED + + + \n");
@@ -123,6 +196,15 @@ int main(int argc, char **argv)
         doc.setContent(&f, false);
         f.close();
         QDomElement consumer = doc.documentElement().firstChildElement(QStringLiteral("consumer"));
+        if (segments > 1) {
+            auto *sJob = new SegmentRenderJob(render, playlist, target, pid, segments, ffmpeg, qApp);
+            QObject::connect(sJob, &SegmentRenderJob::renderingFinished, [&, sJob]() {
+                sJob->deleteLater();
+                app.quit();
+            });
+            QMetaObject::invokeMethod(sJob, "start", Qt::QueuedConnection);
+            return app.exec();
+        }
         if (!consumer.isNull()) {
             if (consumer.hasAttribute(QLatin1String("s")) || consumer.hasAttribute(QLatin1String("r"))) {
                 // Workaround MLT embedded consumer resize (MLT issue #453)
@@ -146,6 +228,8 @@ int main(int argc, char **argv)
                 "  -erase: if that parameter is present, src file will be erased at the end\n"
                 "  -kuiserver: if that parameter is present, use KDE job tracker\n"
                 "  -locale:LOCALE : set a locale for rendering. For example, -locale:fr_FR.UTF-8 will use a french locale (comma as numeric separator)\n"
+                "  -segments:N : render N parts of the playlist in parallel and join them with ffmpeg\n"
+                "  -ffmpeg:PATH : path to the ffmpeg executable used to join the segments\n"
                 "  in=pos: start rendering at frame pos\n"
                 "  out=pos: end rendering at frame pos\n"
                 "  render: path to MLT melt renderer\n"
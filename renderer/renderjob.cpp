@@ -49,6 +49,7 @@ RenderJob::RenderJob(const QString &render, const QString &scenelist, const QStr
     , m_frame(0)
     , m_pid(pid)
     , m_dualpass(false)
+    , m_failed(false)
 {
     m_renderProcess = new QProcess;
     m_renderProcess->setReadChannel(QProcess::StandardError);
@@ -74,6 +75,8 @@ RenderJob::RenderJob(const QString &render, const QString &scenelist, const QStr
 
 RenderJob::~RenderJob()
 {
+    // Deleting the process kills it, we don't want to handle that as a render crash
+    disconnect(m_renderProcess, nullptr, this, nullptr);
     delete m_jobUiserver;
     delete m_kdenliveinterface;
     delete m_renderProcess;
@@ -85,6 +88,21 @@ void RenderJob::setLocale(const QString &locale)
     qputenv("LC_NUMERIC", locale.toUtf8().constData());
 }
 
+void RenderJob::setUseKuiserver(bool use)
+{
+    m_usekuiserver = use;
+}
+
+bool RenderJob::hasFailed() const
+{
+    return m_failed;
+}
+
+const QString &RenderJob::errorMessage() const
+{
+    return m_errorMessage;
+}
+
 void RenderJob::slotAbort(const QString &url)
 {
     if (m_dest == url) {
@@ -133,6 +151,7 @@ void RenderJob::receivedStderr()
             m_progress = 50 + m_progress / 2.0;
         }
         int frame = result.section(QLatin1Char(','), 1).section(QLatin1Char(' '), -1).toInt();
+        emit renderingProgress(m_progress);
         if ((m_kdenliveinterface != nullptr) && m_kdenliveinterface->isValid()) {
             m_dbusargs[1] = m_progress;
             m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), m_dbusargs);
@@ -215,12 +234,10 @@ void RenderJob::start()
     m_logstream.flush();
 }
 
-void RenderJob::initKdenliveDbusInterface()
+QString RenderJob::kdenliveService(int pid)
 {
-    QString kdenliveId;
-    QDBusConnection connection = QDBusConnection::sessionBus();
-    QDBusConnectionInterface *ibus = connection.interface();
-    kdenliveId = QStringLiteral("org.kde.kdenlive-%1").arg(m_pid);
+    QDBusConnectionInterface *ibus = QDBusConnection::sessionBus().interface();
+    QString kdenliveId = QStringLiteral("org.kde.kdenlive-%1").arg(pid);
     if (!ibus->isServiceRegistered(kdenliveId)) {
         kdenliveId.clear();
         const QStringList services = ibus->registeredServiceNames();
@@ -232,6 +249,13 @@ void RenderJob::initKdenliveDbusInterface()
             break;
         }
     }
+    return kdenliveId;
+}
+
+void RenderJob::initKdenliveDbusInterface()
+{
+    QDBusConnection connection = QDBusConnection::sessionBus();
+    QString kdenliveId = kdenliveService(m_pid);
     m_dbusargs.clear();
     if (kdenliveId.isEmpty()) {
         return;
@@ -279,6 +303,7 @@ void RenderJob::slotIsOver(QProcess::ExitStatus status, bool isWritable)
     }
     if (status == QProcess::CrashExit || m_renderProcess->error() != QProcess::UnknownError || m_renderProcess->exitCode() != 0) {
         // rendering crashed
+        m_failed = true;
         if (m_kdenliveinterface) {
             m_dbusargs[1] = (int)-2;
             m_dbusargs.append(m_errorMessage);
@@ -36,6 +36,13 @@ public:
     RenderJob(const QString &render, const QString &scenelist, const QString &target, int pid = -1, int in = -1, int out = -1, QObject *parent = nullptr);
     ~RenderJob();
     void setLocale(const QString &locale);
+    /** @brief Enable or disable the KDE job tracker, segments of a render are not shown there */
+    void setUseKuiserver(bool use);
+    /** @brief True if the render process crashed or exited with an error */
+    bool hasFailed() const;
+    const QString &errorMessage() const;
+    /** @brief Returns the dbus service of the Kdenlive instance with process id pid, or of any running instance */
+    static QString kdenliveService(int pid);
 
 public slots:
     void start();
@@ -64,6 +71,7 @@ private:
     /** @brief The process id of the Kdenlive instance, used to get the dbus service. */
     int m_pid;
     bool m_dualpass;
+    bool m_failed;
     QProcess *m_renderProcess;
     QString m_errorMessage;
     QList<QVariant> m_dbusargs;
@@ -75,6 +83,8 @@ private:
 
 signals:
     void renderingFinished();
+    /** @brief Progress of the melt process, in percent */
+    void renderingProgress(int progress);
 };
 
 #endif
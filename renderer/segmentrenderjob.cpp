@@ -0,0 +1,380 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Kdenlive contributors                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#include "segmentrenderjob.h"
+#include "renderjob.h"
+
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QtDBus>
+#include <cmath>
+
+SegmentRenderJob::SegmentRenderJob(const QString &render, const QString &scenelist, const QString &target, int pid, int segments, const QString &ffmpeg,
+                                   QObject *parent)
+    : QObject(parent)
+    , m_prog(render)
+    , m_scenelist(scenelist)
+    , m_dest(target)
+    , m_ffmpeg(ffmpeg)
+    , m_pid(pid)
+    , m_segmentCount(qMax(1, segments))
+    , m_frames(0)
+    , m_checkFrames(true)
+    , m_fps(25.)
+    , m_separateAudio(false)
+    , m_checkingAudio(false)
+    , m_kdenliveinterface(nullptr)
+    , m_progress(0)
+    , m_finished(false)
+{
+    m_concatProcess.setReadChannel(QProcess::StandardError);
+    m_checkProcess.setReadChannel(QProcess::StandardError);
+    connect(&m_concatProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), [this](int exitCode, QProcess::ExitStatus status) {
+        if (m_finished) {
+            return;
+        }
+        if (status != QProcess::NormalExit || exitCode != 0) {
+            finish(-2, tr("Cannot join the rendered segments: %1").arg(QString::fromLocal8Bit(m_concatProcess.readAllStandardError())), true);
+            return;
+        }
+        m_progress = 98;
+        if (m_kdenliveinterface) {
+            m_kdenliveinterface->call(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), m_dest, m_progress);
+        }
+        validateResult();
+    });
+    connect(&m_checkProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), [this](int exitCode, QProcess::ExitStatus status) {
+        if (m_finished) {
+            return;
+        }
+        const QString output = QString::fromLocal8Bit(m_checkProcess.readAllStandardError());
+        if (status != QProcess::NormalExit || exitCode != 0) {
+            finish(-2, tr("Rendered file %1 is not readable: %2").arg(m_dest, output), true);
+            return;
+        }
+        if (m_checkingAudio) {
+            // Last stats line of the audio stream copy: time=HH:MM:SS.ss
+            QRegularExpressionMatchIterator it = QRegularExpression(QStringLiteral("time=\\s*(\\d+):(\\d+):(\\d+\\.?\\d*)")).globalMatch(output);
+            double duration = -1;
+            while (it.hasNext()) {
+                QRegularExpressionMatch match = it.next();
+                duration = match.captured(1).toInt() * 3600 + match.captured(2).toInt() * 60 + match.captured(3).toDouble();
+            }
+            // One frame of rounding, plus the padding of the last audio packet
+            double expected = m_frames / m_fps;
+            if (duration < 0 || qAbs(duration - expected) > 1. / m_fps + 0.05) {
+                finish(-2, tr("Rendered file %1 has %2 seconds of audio instead of %3").arg(m_dest).arg(duration).arg(expected), true);
+                return;
+            }
+            finish(-1);
+            return;
+        }
+        // The stats line is refreshed with a carriage return, the last one has the total
+        QRegularExpressionMatchIterator it = QRegularExpression(QStringLiteral("frame=\\s*(\\d+)")).globalMatch(output);
+        int frames = -1;
+        while (it.hasNext()) {
+            frames = it.next().captured(1).toInt();
+        }
+        // Allow one frame of rounding per segment, no frame count for audio only files
+        int videoSegments = m_segments.count() - (m_separateAudio ? 1 : 0);
+        if (m_checkFrames && frames >= 0 && qAbs(frames - m_frames) > videoSegments) {
+            finish(-2, tr("Rendered file %1 has %2 frames instead of %3").arg(m_dest).arg(frames).arg(m_frames), true);
+            return;
+        }
+        if (m_separateAudio) {
+            validateAudio();
+            return;
+        }
+        finish(-1);
+    });
+}
+
+SegmentRenderJob::~SegmentRenderJob()
+{
+    for (auto &segment : m_segments) {
+        delete segment.job;
+    }
+    delete m_kdenliveinterface;
+}
+
+void SegmentRenderJob::start()
+{
+    if (m_pid > -1) {
+        QString kdenliveId = RenderJob::kdenliveService(m_pid);
+        if (!kdenliveId.isEmpty()) {
+            m_kdenliveinterface = new QDBusInterface(kdenliveId, QStringLiteral("/kdenlive/MainWindow_1"), QStringLiteral("org.kde.kdenlive.rendering"),
+                                                     QDBusConnection::sessionBus(), this);
+            m_kdenliveinterface->call(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), m_dest, 0);
+            connect(m_kdenliveinterface, SIGNAL(abortRenderJob(QString)), this, SLOT(slotAbort(QString)));
+        }
+    }
+    QString error;
+    if (!prepareSegments(error)) {
+        finish(-2, error, true);
+        return;
+    }
+    for (int i = 0; i < m_segments.count(); ++i) {
+        Segment &segment = m_segments[i];
+        segment.job = new RenderJob(m_prog, segment.playlist, segment.target, -1, -1, -1);
+        segment.job->setUseKuiserver(false);
+        connect(segment.job, &RenderJob::renderingProgress, this, [this, i](int progress) {
+            m_segments[i].progress = progress;
+            updateProgress();
+        });
+        connect(segment.job, &RenderJob::renderingFinished, this, [this, i]() { segmentFinished(i); });
+        segment.job->start();
+    }
+}
+
+bool SegmentRenderJob::prepareSegments(QString &error)
+{
+    QFile file(m_scenelist);
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file, false)) {
+        error = tr("Cannot read playlist %1").arg(m_scenelist);
+        return false;
+    }
+    file.close();
+    QDomElement consumer = doc.documentElement().firstChildElement(QStringLiteral("consumer"));
+    if (consumer.isNull()) {
+        error = tr("No consumer in playlist %1").arg(m_scenelist);
+        return false;
+    }
+    int in = consumer.attribute(QStringLiteral("in")).toInt();
+    int out = consumer.attribute(QStringLiteral("out"), QStringLiteral("-1")).toInt();
+    if (out < in) {
+        error = tr("Invalid render range in playlist %1").arg(m_scenelist);
+        return false;
+    }
+    // Workaround MLT embedded consumer resize (MLT issue #453), see kdenlive_render.cpp
+    bool multi = consumer.hasAttribute(QLatin1String("s")) || consumer.hasAttribute(QLatin1String("r"));
+    m_checkFrames = !consumer.hasAttribute(QLatin1String("r"));
+    bool hasVideo = consumer.attribute(QStringLiteral("vn")) != QLatin1String("1") && consumer.attribute(QStringLiteral("video_off")) != QLatin1String("1");
+    bool hasAudio = consumer.attribute(QStringLiteral("an")) != QLatin1String("1") && consumer.attribute(QStringLiteral("audio_off")) != QLatin1String("1");
+
+    QDomElement profile = doc.documentElement().firstChildElement(QStringLiteral("profile"));
+    double num = profile.attribute(QStringLiteral("frame_rate_num")).toDouble();
+    double den = profile.attribute(QStringLiteral("frame_rate_den")).toDouble();
+    m_fps = den > 0 && num > 0 ? num / den : 25.;
+    // Segments start on a keyframe of the full length encoding: use the GOP size, or one second of video
+    int gop = consumer.attribute(QStringLiteral("g")).toInt();
+    if (gop <= 0) {
+        gop = qMax(1, int(std::lround(m_fps)));
+    }
+    m_frames = out - in + 1;
+    int segmentLength = int(std::ceil(double(m_frames) / m_segmentCount));
+    segmentLength = qMax(gop, (segmentLength + gop - 1) / gop * gop);
+    if (!hasVideo) {
+        // Audio only, splitting would only add gaps
+        segmentLength = m_frames;
+    }
+    m_separateAudio = hasVideo && hasAudio;
+
+    const QString extension = QFileInfo(m_dest).suffix();
+    const QString playlistBase = m_scenelist.section(QLatin1Char('.'), 0, -2);
+    auto writeSegment = [&](Segment &segment) {
+        consumer.setAttribute(QStringLiteral("in"), segment.in);
+        consumer.setAttribute(QStringLiteral("out"), segment.out);
+        consumer.setAttribute(QStringLiteral("target"), segment.target);
+        QFile segmentFile(segment.playlist);
+        if (!segmentFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            error = tr("Cannot write to file %1").arg(segment.playlist);
+            return false;
+        }
+        segmentFile.write(doc.toString().toUtf8());
+        segmentFile.close();
+        if (multi) {
+            segment.playlist = QStringLiteral("xml:%1?multi=1").arg(segment.playlist);
+        }
+        m_segments << segment;
+        return true;
+    };
+    if (m_separateAudio) {
+        consumer.setAttribute(QStringLiteral("an"), 1);
+    }
+    for (int start = in, ix = 0; start <= out; start += segmentLength, ++ix) {
+        Segment segment;
+        segment.in = start;
+        segment.out = qMin(out, start + segmentLength - 1);
+        segment.playlist = QStringLiteral("%1-segment%2.mlt").arg(playlistBase).arg(ix);
+        segment.target = QStringLiteral("%1.segment%2.%3").arg(m_dest).arg(ix).arg(extension);
+        if (!writeSegment(segment)) {
+            return false;
+        }
+    }
+    if (m_separateAudio) {
+        // The audio of the whole range, encoded in one pass
+        consumer.removeAttribute(QStringLiteral("an"));
+        consumer.setAttribute(QStringLiteral("vn"), 1);
+        Segment segment;
+        segment.in = in;
+        segment.out = out;
+        segment.audio = true;
+        segment.playlist = QStringLiteral("%1-audio.mlt").arg(playlistBase);
+        segment.target = QStringLiteral("%1.audio.%2").arg(m_dest, extension);
+        if (!writeSegment(segment)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SegmentRenderJob::segmentFinished(int ix)
+{
+    Segment &segment = m_segments[ix];
+    if (m_finished || segment.finished) {
+        return;
+    }
+    segment.finished = true;
+    if (segment.job->hasFailed()) {
+        // The segment job already displayed the error
+        finish(-2, segment.job->errorMessage());
+        return;
+    }
+    segment.progress = 100;
+    updateProgress();
+    for (const auto &s : m_segments) {
+        if (!s.finished) {
+            return;
+        }
+    }
+    concatSegments();
+}
+
+void SegmentRenderJob::updateProgress()
+{
+    qint64 done = 0;
+    qint64 total = 0;
+    for (const auto &segment : m_segments) {
+        done += qint64(segment.progress) * (segment.out - segment.in + 1);
+        total += segment.out - segment.in + 1;
+    }
+    // Keep the last percents for joining and checking the segments
+    int progress = int(95 * done / (100 * qMax(qint64(1), total)));
+    if (progress <= m_progress) {
+        return;
+    }
+    m_progress = progress;
+    if (m_kdenliveinterface) {
+        m_kdenliveinterface->call(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), m_dest, m_progress);
+    }
+}
+
+void SegmentRenderJob::concatSegments()
+{
+    QFile list(m_dest + QStringLiteral(".segments.txt"));
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        finish(-2, tr("Cannot write to file %1").arg(list.fileName()), true);
+        return;
+    }
+    QTextStream stream(&list);
+    QString audioTarget;
+    for (const auto &segment : m_segments) {
+        if (segment.audio) {
+            audioTarget = segment.target;
+            continue;
+        }
+        QString path = segment.target;
+        stream << "file '" << path.replace(QLatin1Char('\''), QStringLiteral("'\\''")) << "'\n";
+    }
+    stream.flush();
+    list.close();
+    QStringList args = {QStringLiteral("-y"), QStringLiteral("-nostdin"), QStringLiteral("-v"), QStringLiteral("error"), QStringLiteral("-f"),
+                        QStringLiteral("concat"), QStringLiteral("-safe"), QStringLiteral("0"), QStringLiteral("-i"), list.fileName()};
+    if (audioTarget.isEmpty()) {
+        args << QStringLiteral("-map") << QStringLiteral("0");
+    } else {
+        // Mux the audio rendered in one pass with the joined video
+        args << QStringLiteral("-i") << audioTarget << QStringLiteral("-map") << QStringLiteral("0:v") << QStringLiteral("-map") << QStringLiteral("1:a");
+    }
+    args << QStringLiteral("-c") << QStringLiteral("copy") << m_dest;
+    m_concatProcess.start(m_ffmpeg, args);
+}
+
+void SegmentRenderJob::validateResult()
+{
+    // Stream copy of the video track, only counts the packets
+    m_checkingAudio = false;
+    m_checkProcess.start(m_ffmpeg, {QStringLiteral("-nostdin"), QStringLiteral("-v"), QStringLiteral("error"), QStringLiteral("-stats"), QStringLiteral("-i"),
+                                    m_dest, QStringLiteral("-map"), QStringLiteral("0:v:0?"), QStringLiteral("-c"), QStringLiteral("copy"),
+                                    QStringLiteral("-f"), QStringLiteral("null"), QStringLiteral("-")});
+}
+
+void SegmentRenderJob::validateAudio()
+{
+    // Stream copy of the audio track, the last stats line gives its duration
+    m_checkingAudio = true;
+    m_checkProcess.start(m_ffmpeg, {QStringLiteral("-nostdin"), QStringLiteral("-v"), QStringLiteral("error"), QStringLiteral("-stats"), QStringLiteral("-i"),
+                                    m_dest, QStringLiteral("-map"), QStringLiteral("0:a:0"), QStringLiteral("-c"), QStringLiteral("copy"),
+                                    QStringLiteral("-f"), QStringLiteral("null"), QStringLiteral("-")});
+}
+
+void SegmentRenderJob::slotAbort(const QString &url)
+{
+    if (url != m_dest || m_finished) {
+        return;
+    }
+    qWarning() << "Job aborted by user...";
+    m_concatProcess.kill();
+    m_checkProcess.kill();
+    finish(-3);
+}
+
+void SegmentRenderJob::finish(int status, const QString &error, bool showError)
+{
+    m_finished = true;
+    cleanup(status != -1);
+    if (m_kdenliveinterface) {
+        m_kdenliveinterface->call(QDBus::NoBlock, QStringLiteral("setRenderingFinished"), m_dest, status, error);
+    }
+    if (showError) {
+        QProcess::startDetached(QStringLiteral("kdialog"), {QStringLiteral("--error"), tr("Rendering of %1 failed.\n%2").arg(m_dest, error)});
+    }
+    emit renderingFinished();
+}
+
+void SegmentRenderJob::cleanup(bool removeTarget)
+{
+    for (auto &segment : m_segments) {
+        if (segment.job) {
+            if (segment.finished) {
+                // We may be called from the job's signal
+                segment.job->disconnect(this);
+                segment.job->deleteLater();
+            } else {
+                // Deleting the job kills its render process
+                delete segment.job;
+            }
+            segment.job = nullptr;
+        }
+        QFile::remove(segment.target);
+        QFile::remove(segment.playlist.startsWith(QLatin1String("xml:")) ? segment.playlist.section(QLatin1Char(':'), 1).section(QLatin1Char('?'), 0, -2)
+                                                                          : segment.playlist);
+    }
+    QFile::remove(m_dest + QStringLiteral(".segments.txt"));
+    if (m_scenelist.startsWith(QDir::tempPath())) {
+        QFile::remove(m_scenelist);
+    }
+    if (removeTarget) {
+        QFile::remove(m_dest);
+    }
+}
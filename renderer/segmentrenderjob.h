@@ -0,0 +1,106 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Kdenlive contributors                           *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#ifndef SEGMENTRENDERJOB_H
+#define SEGMENTRENDERJOB_H
+
+#include <QDBusInterface>
+#include <QObject>
+#include <QProcess>
+#include <QVector>
+
+class RenderJob;
+
+/** @class SegmentRenderJob
+    @brief Renders a playlist as several segments in parallel, each one in its own melt process.
+    The video segments are aligned on the encoder GOP size and joined with the ffmpeg concat demuxer
+    without re-encoding. The audio is rendered in one pass by another process and muxed with the joined
+    video, independently encoded audio parts would have encoder priming gaps at each boundary.
+    The resulting file is then checked for the expected number of frames and audio duration.
+    Progress is reported to Kdenlive as a single job for the final file.
+ */
+class SegmentRenderJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    SegmentRenderJob(const QString &render, const QString &scenelist, const QString &target, int pid, int segments, const QString &ffmpeg,
+                     QObject *parent = nullptr);
+    ~SegmentRenderJob() override;
+
+public slots:
+    void start();
+
+private slots:
+    void slotAbort(const QString &url);
+
+private:
+    struct Segment
+    {
+        int in;
+        int out;
+        QString playlist;
+        QString target;
+        RenderJob *job = nullptr;
+        int progress = 0;
+        bool finished = false;
+        /** @brief The audio of the whole range, not part of the concatenation */
+        bool audio = false;
+    };
+    QString m_prog;
+    QString m_scenelist;
+    QString m_dest;
+    QString m_ffmpeg;
+    int m_pid;
+    int m_segmentCount;
+    int m_frames;
+    /** @brief False if the frame rate is changed by the consumer, the frame count cannot be checked */
+    bool m_checkFrames;
+    /** @brief Frame rate of the profile, to check the audio duration */
+    double m_fps;
+    /** @brief The audio is rendered separately from the video segments */
+    bool m_separateAudio;
+    /** @brief The check process counts the audio duration, after the video frames */
+    bool m_checkingAudio;
+    QVector<Segment> m_segments;
+    QProcess m_concatProcess;
+    QProcess m_checkProcess;
+    QDBusInterface *m_kdenliveinterface;
+    int m_progress;
+    bool m_finished;
+
+    /** @brief Write one playlist per segment, returns false on error */
+    bool prepareSegments(QString &error);
+    void segmentFinished(int ix);
+    void updateProgress();
+    /** @brief Join the rendered segments in the final file */
+    void concatSegments();
+    /** @brief Count the video frames of the final file */
+    void validateResult();
+    /** @brief Measure the audio duration of the final file */
+    void validateAudio();
+    /** @brief Report the end of the job to Kdenlive, status is -1 on success, -2 on error and -3 when aborted */
+    void finish(int status, const QString &error = QString(), bool showError = false);
+    void cleanup(bool removeTarget);
+
+signals:
+    void renderingFinished();
+};
+
+#endif
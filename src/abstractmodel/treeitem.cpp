@@ -86,9 +86,8 @@ bool TreeItem::appendChild(const std::shared_ptr<TreeItem> &child)
     if (auto ptr = m_model.lock()) {
         ptr->notifyRowAboutToAppend(shared_from_this());
         child->updateParent(shared_from_this());
-        int id = child->getId();
-        auto it = m_childItems.insert(m_childItems.end(), child);
-        m_iteratorTable[id] = it;
+        child->m_row = (int)m_childItems.size();
+        m_childItems.push_back(child);
         registerSelf(child);
         ptr->notifyRowAppended(child);
         return true;
@@ -104,18 +103,16 @@ void TreeItem::moveChild(int ix, const std::shared_ptr<TreeItem> &child)
         auto parentPtr = child->m_parentItem.lock();
         if (parentPtr && parentPtr->getId() != m_id) {
             parentPtr->removeChild(child);
-        } else {
+        } else if (parentPtr) {
             // deletion of child
-            auto it = m_iteratorTable[child->getId()];
-            m_childItems.erase(it);
+            int row = child->row();
+            m_childItems.erase(m_childItems.begin() + row);
+            invalidateRows(row);
         }
         ptr->notifyRowAboutToAppend(shared_from_this());
         child->updateParent(shared_from_this());
-        int id = child->getId();
-        auto pos = m_childItems.begin();
-        std::advance(pos, ix);
-        auto it = m_childItems.insert(pos, child);
-        m_iteratorTable[id] = it;
+        m_childItems.insert(m_childItems.begin() + ix, child);
+        invalidateRows(ix);
         ptr->notifyRowAppended(child);
         m_isInModel = true;
     } else {
@@ -127,14 +124,13 @@ void TreeItem::moveChild(int ix, const std::shared_ptr<TreeItem> &child)
 void TreeItem::removeChild(const std::shared_ptr<TreeItem> &child)
 {
     if (auto ptr = m_model.lock()) {
-        ptr->notifyRowAboutToDelete(shared_from_this(), child->row());
-        // get iterator corresponding to child
-        Q_ASSERT(m_iteratorTable.count(child->getId()) > 0);
-        auto it = m_iteratorTable[child->getId()];
+        int row = child->row();
+        ptr->notifyRowAboutToDelete(shared_from_this(), row);
+        Q_ASSERT(row >= 0 && row < (int)m_childItems.size() && m_childItems[size_t(row)] == child);
         // deletion of child
-        m_childItems.erase(it);
-        // clean iterator table
-        m_iteratorTable.erase(child->getId());
+        m_childItems.erase(m_childItems.begin() + row);
+        invalidateRows(row);
+        child->m_row = -1;
         child->m_depth = 0;
         child->m_parentItem.reset();
         child->deregisterSelf();
@@ -170,9 +166,7 @@ bool TreeItem::changeParent(std::shared_ptr<TreeItem> newParent)
 std::shared_ptr<TreeItem> TreeItem::child(int row) const
 {
     Q_ASSERT(row >= 0 && row < (int)m_childItems.size());
-    auto it = m_childItems.cbegin();
-    std::advance(it, row);
-    return (*it);
+    return m_childItems[size_t(row)];
 }
 
 int TreeItem::childCount() const
@@ -203,13 +197,27 @@ std::weak_ptr<TreeItem> TreeItem::parentItem() const
 int TreeItem::row() const
 {
     if (auto ptr = m_parentItem.lock()) {
-        // we compute the distance in the parent's children list
-        auto it = ptr->m_childItems.begin();
-        return (int)std::distance(it, (decltype(it))ptr->m_iteratorTable.at(m_id));
+        int row = m_row;
+        if (row >= 0 && row < ptr->m_firstDirtyRow) {
+            return row;
+        }
+        // repair the outdated rows of the parent's children
+        for (size_t i = size_t(ptr->m_firstDirtyRow.load()); i < ptr->m_childItems.size(); ++i) {
+            ptr->m_childItems[i]->m_row = (int)i;
+        }
+        ptr->m_firstDirtyRow = INT_MAX;
+        return m_row;
     }
     return -1;
 }
 
+void TreeItem::invalidateRows(int row)
+{
+    if (row < m_firstDirtyRow) {
+        m_firstDirtyRow = row;
+    }
+}
+
 int TreeItem::depth() const
 {
     return m_depth;
@@ -25,8 +25,11 @@
 #include "definitions.h"
 #include <QList>
 #include <QVariant>
+#include <atomic>
+#include <climits>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 /* @brief This class is a generic class to represent items of a tree-like model
    It works in tandem with AbstractTreeModel or one of its derived classes.
@@ -40,6 +43,9 @@
 
    Note that the root is a special object. In particular, it must stay at the root and
    must not be declared as the child of any other item.
+
+   Children are stored in a vector, and each child caches its row. When children are inserted or
+   removed, the cached rows after the modified one are only recomputed on the next row() query.
  */
 
 class AbstractTreeModel;
@@ -155,9 +161,14 @@ protected:
     */
     virtual void updateParent(std::shared_ptr<TreeItem> parent);
 
-    std::list<std::shared_ptr<TreeItem>> m_childItems;
-    std::unordered_map<int, std::list<std::shared_ptr<TreeItem>>::iterator>
-        m_iteratorTable; // this logs the iterator associated which each child id. This allows easy access of a child based on its id.
+    /* @brief Mark the cached rows of the children starting at given row as outdated */
+    void invalidateRows(int row);
+
+    std::vector<std::shared_ptr<TreeItem>> m_childItems;
+    // cached index of this item in its parent's children. Only valid if lower than the parent's m_firstDirtyRow
+    mutable std::atomic<int> m_row{-1};
+    // the children starting at this row have an outdated row cache, INT_MAX if all rows are valid
+    mutable std::atomic<int> m_firstDirtyRow{INT_MAX};
 
     QList<QVariant> m_itemData;
     std::weak_ptr<TreeItem> m_parentItem;
@@ -66,7 +66,9 @@ protected:
         QString mltId; //"tag" of the asset, that is the name of the mlt service
         QString name, description, author, version_str;
         int version{};
-        QDomElement xml;
+        mutable QDomElement xml;
+        // Serialized xml of an asset restored from the cache, parsed on first use
+        mutable QString xmlData;
         AssetType type;
     };
 
@@ -108,11 +110,28 @@ protected:
     /* @brief Returns the path to the assets' preferred list*/
     virtual QString assetPreferredListPath() const = 0;
 
+    /* @brief Returns the name of the assets' metadata cache file*/
+    virtual QString assetCacheName() const = 0;
+
+    /* @brief Returns the xml of an asset, parsing it if it was restored from the cache */
+    QDomElement assetXml(const Info &info) const;
+
+    /* @brief Returns a hash of everything the parsed assets depend on: versions, locale, available MLT services and asset files */
+    QByteArray cacheKey(Mlt::Properties *mltAssets) const;
+
+    /* @brief Restore the parsed assets from the cache
+       @return false if the cache is missing or outdated
+    */
+    bool loadCache(const QByteArray &key);
+    void saveCache(const QByteArray &key) const;
+
     std::unordered_map<QString, Info> m_assets;
 
     QSet<QString> m_blacklist;
 
     QSet<QString> m_preferred_list;
+
+    mutable std::mutex m_xmlMutex;
 };
 
 #include "abstractassetsrepository.ipp"
@@ -20,14 +20,22 @@
  ***************************************************************************/
 
 #include "xml/xml.hpp"
+#include "config-kdenlive.h"
+#include "kdenlive_debug.h"
 #include "kdenlivesettings.h"
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QString>
 #include <QTextStream>
 #include <KLocalizedString>
+#include <framework/mlt_version.h>
 
 #include <locale>
 #ifdef Q_OS_MAC
@@ -51,8 +59,15 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
     // Parse preferred list
     parseAssetList(assetPreferredListPath(), m_preferred_list);
 
+    QElapsedTimer timer;
+    timer.start();
     // Retrieve the list of MLT's available assets.
     QScopedPointer<Mlt::Properties> assets(retrieveListFromMlt());
+    const QByteArray key = cacheKey(assets.data());
+    if (loadCache(key)) {
+        qCDebug(KDENLIVE_LOG) << "Startup timing:" << assetCacheName() << m_assets.size() << "assets restored from cache in" << timer.elapsed() << "ms";
+        return;
+    }
     int max = assets->count();
     QString sox = QStringLiteral("sox.");
     for (int i = 0; i < max; ++i) {
@@ -75,6 +90,8 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
         }
     }
 
+    qint64 mltTime = timer.elapsed();
+
     // We now parse custom effect xml
 
     // Set the directories to look into for effects.
@@ -111,6 +128,107 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
             qDebug() << "Error: conflicting asset name " << custom.first;
         }*/
     }
+    qCDebug(KDENLIVE_LOG) << "Startup timing:" << assetCacheName() << "MLT metadata" << mltTime << "ms, custom xml" << timer.elapsed() - mltTime << "ms";
+    saveCache(key);
+}
+
+template <typename AssetType> QByteArray AbstractAssetsRepository<AssetType>::cacheKey(Mlt::Properties *mltAssets) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArrayLiteral(KDENLIVE_VERSION));
+    hash.addData(mlt_version_get_string());
+    // Names, descriptions and float values are localized
+    hash.addData(QLocale().name().toUtf8());
+    hash.addData(KLocalizedString::languages().join(QLatin1Char(',')).toUtf8());
+    QStringList lists = m_blacklist.values() + QStringList{QStringLiteral("|")} + m_preferred_list.values();
+    std::sort(lists.begin(), lists.end());
+    hash.addData(lists.join(QLatin1Char(',')).toUtf8());
+    // Installing a plugin does not always change the MLT version
+    for (int i = 0; i < mltAssets->count(); ++i) {
+        hash.addData(mltAssets->get_name(i));
+        hash.addData("\n", 1);
+    }
+    // Any added, removed or edited custom asset file invalidates the cache
+    for (const QString &dir : assetDirs()) {
+        QDir current_dir(dir);
+        hash.addData(current_dir.absolutePath().toUtf8());
+        const QFileInfoList files = current_dir.entryInfoList({QStringLiteral("*.xml")}, QDir::Files, QDir::Name);
+        for (const QFileInfo &file : files) {
+            hash.addData(QStringLiteral("%1:%2:%3").arg(file.fileName()).arg(file.size()).arg(file.lastModified().toMSecsSinceEpoch()).toUtf8());
+        }
+    }
+    return hash.result();
+}
+
+template <typename AssetType> bool AbstractAssetsRepository<AssetType>::loadCache(const QByteArray &key)
+{
+    QFile file(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/assets/%1.cache").arg(assetCacheName()));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_11);
+    qint32 format;
+    QByteArray storedKey;
+    stream >> format >> storedKey;
+    // Increase the format when Info changes
+    if (format != 1 || storedKey != key) {
+        return false;
+    }
+    qint32 count;
+    stream >> count;
+    std::unordered_map<QString, Info> assets;
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Info info;
+        QString assetId;
+        qint32 version, type;
+        stream >> assetId >> info.id >> info.mltId >> info.name >> info.description >> info.author >> info.version_str >> version >> type >> info.xmlData;
+        info.version = version;
+        info.type = AssetType(type);
+        assets[assetId] = info;
+    }
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+    m_assets = std::move(assets);
+    return true;
+}
+
+template <typename AssetType> void AbstractAssetsRepository<AssetType>::saveCache(const QByteArray &key) const
+{
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    if (!dir.mkpath(QStringLiteral("assets"))) {
+        return;
+    }
+    QSaveFile file(dir.absoluteFilePath(QStringLiteral("assets/%1.cache").arg(assetCacheName())));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_11);
+    stream << qint32(1) << key << qint32(m_assets.size());
+    for (const auto &asset : m_assets) {
+        const Info &info = asset.second;
+        QString xml;
+        QTextStream xmlStream(&xml);
+        assetXml(info).save(xmlStream, 0);
+        xmlStream.flush();
+        stream << asset.first << info.id << info.mltId << info.name << info.description << info.author << info.version_str << qint32(info.version) << qint32(info.type)
+               << xml;
+    }
+    file.commit();
+}
+
+template <typename AssetType> QDomElement AbstractAssetsRepository<AssetType>::assetXml(const Info &info) const
+{
+    std::lock_guard<std::mutex> lock(m_xmlMutex);
+    if (info.xml.isNull() && !info.xmlData.isEmpty()) {
+        QDomDocument doc;
+        doc.setContent(info.xmlData, false);
+        info.xml = doc.documentElement();
+        info.xmlData.clear();
+    }
+    return info.xml;
 }
 
 template <typename AssetType> void AbstractAssetsRepository<AssetType>::parseAssetList(const QString &filePath, QSet<QString> &destination)
@@ -347,5 +465,5 @@ template <typename AssetType> QDomElement AbstractAssetsRepository<AssetType>::g
         qDebug() << "Error : Requesting info on unknown transition " << assetId;
         return QDomElement();
     }
-    return m_assets.at(assetId).xml.cloneNode().toElement();
+    return assetXml(m_assets.at(assetId)).cloneNode().toElement();
 }
@@ -40,11 +40,16 @@ KeyframeModel::KeyframeModel(std::weak_ptr<AssetParameterModel> model, const QMo
     , m_undoStack(std::move(undo_stack))
     , m_index(index)
     , m_lastData()
+    , m_changedRange(-1, -1)
     , m_lock(QReadWriteLock::Recursive)
+    , m_useOpacity(true)
 {
     qDebug() << "Construct keyframemodel. Checking model:" << m_model.expired();
     if (auto ptr = m_model.lock()) {
         m_paramType = ptr->data(m_index, AssetParameterModel::TypeRole).value<ParamType>();
+        if (m_paramType == ParamType::AnimatedRect) {
+            m_useOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
+        }
     }
     setup();
     refresh();
@@ -373,7 +378,11 @@ Fun KeyframeModel::updateKeyframe_lambda(GenTime pos, KeyframeType type, const Q
         int row = static_cast<int>(std::distance(m_keyframeList.begin(), m_keyframeList.find(pos)));
         m_keyframeList[pos].first = type;
         m_keyframeList[pos].second = value;
-        if (notify) emit dataChanged(index(row), index(row), {ValueRole, NormalizedValueRole, TypeRole});
+        updateCache(pos);
+        if (notify) {
+            m_changedRange = changedRange(pos);
+            emit dataChanged(index(row), index(row), {ValueRole, NormalizedValueRole, TypeRole});
+        }
         return true;
     };
 }
@@ -393,6 +402,7 @@ Fun KeyframeModel::addKeyframe_lambda(GenTime pos, KeyframeType type, const QVar
         if (notify) beginInsertRows(QModelIndex(), insertionRow, insertionRow);
         m_keyframeList[pos].first = type;
         m_keyframeList[pos].second = value;
+        updateCache(pos);
         if (notify) endInsertRows();
         return true;
     };
@@ -409,6 +419,7 @@ Fun KeyframeModel::deleteKeyframe_lambda(GenTime pos, bool notify)
         int row = static_cast<int>(std::distance(m_keyframeList.begin(), m_keyframeList.find(pos)));
         if (notify) beginRemoveRows(QModelIndex(), row, row);
         m_keyframeList.erase(pos);
+        updateCache(pos);
         if (notify) endRemoveRows();
         qDebug() << "after" << getAnimProperty();
         return true;
@@ -651,42 +662,11 @@ QString KeyframeModel::getAnimProperty() const
     if (m_paramType == ParamType::Roto_spline) {
         return getRotoProperty();
     }
-    Mlt::Properties mlt_prop;
-    if (auto ptr = m_model.lock()) {
-        ptr->passProperties(mlt_prop);
-    }
-    int ix = 0;
-    bool first = true;
-    std::shared_ptr<Mlt::Animation> anim(nullptr);
-    for (const auto &keyframe : m_keyframeList) {
-        if (first) {
-            switch (m_paramType) {
-            case ParamType::AnimatedRect:
-                mlt_prop.anim_set("key", keyframe.second.second.toString().toUtf8().constData(), keyframe.first.frames(pCore->getCurrentFps()));
-                break;
-            default:
-                mlt_prop.anim_set("key", keyframe.second.second.toDouble(), keyframe.first.frames(pCore->getCurrentFps()));
-                break;
-            }
-            anim.reset(mlt_prop.get_anim("key"));
-            anim->key_set_type(ix, convertToMltType(keyframe.second.first));
-            first = false;
-            ix++;
-            continue;
-        }
-        switch (m_paramType) {
-        case ParamType::AnimatedRect:
-            mlt_prop.anim_set("key", keyframe.second.second.toString().toUtf8().constData(), keyframe.first.frames(pCore->getCurrentFps()));
-            break;
-        default:
-            mlt_prop.anim_set("key", keyframe.second.second.toDouble(), keyframe.first.frames(pCore->getCurrentFps()));
-            break;
-        }
-        anim->key_set_type(ix, convertToMltType(keyframe.second.first));
-        ix++;
-    }
+    // The parsed animation is kept up to date by the keyframe operations, so we only have to serialize it
+    QMutexLocker locker(&m_cacheMutex);
+    std::unique_ptr<Mlt::Animation> anim(cachedAnimation()->get_anim("key"));
     QString ret;
-    if (anim) {
+    if (anim->is_valid()) {
         char *cut = anim->serialize_cut();
         ret = QString(cut);
         free(cut);
@@ -911,6 +891,7 @@ QVariant KeyframeModel::getNormalizedValue(double newVal) const
 
 QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
 {
+    READ_LOCK();
     if (m_keyframeList.count(pos) > 0) {
         return m_keyframeList.at(pos).second;
     }
@@ -927,69 +908,113 @@ QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
     }
     auto prev = next;
     --prev;
-    // We now have surrounding keyframes, we use mlt to compute the value
-    Mlt::Properties prop;
-    bool useOpacity = true;
-    if (auto ptr = m_model.lock()) {
-        ptr->passProperties(prop);
-        if (m_paramType == ParamType::AnimatedRect) {
-            useOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
+    QMutexLocker locker(&m_cacheMutex);
+    return interpolate(pos.frames(pCore->getCurrentFps()), prev, next);
+}
+
+namespace {
+mlt_rect stringToRect(const QString &value, bool useOpacity)
+{
+    QLocale locale;
+    QStringList vals = value.split(QLatin1Char(' '));
+    mlt_rect rect;
+    rect.x = rect.y = rect.w = rect.h = 0;
+    rect.o = 1;
+    if (vals.count() >= 4) {
+        rect.x = locale.toDouble(vals.at(0));
+        rect.y = locale.toDouble(vals.at(1));
+        rect.w = locale.toDouble(vals.at(2));
+        rect.h = locale.toDouble(vals.at(3));
+        if (useOpacity && vals.count() > 4) {
+            rect.o = locale.toDouble(vals.at(4));
         }
     }
-    QLocale locale;
-    int p = pos.frames(pCore->getCurrentFps());
-    if (m_paramType == ParamType::KeyframeParam) {
-        prop.anim_set("keyframe", prev->second.second.toDouble(), prev->first.frames(pCore->getCurrentFps()), next->first.frames(pCore->getCurrentFps()),
-                      convertToMltType(prev->second.first));
-        prop.anim_set("keyframe", next->second.second.toDouble(), next->first.frames(pCore->getCurrentFps()), next->first.frames(pCore->getCurrentFps()),
-                      convertToMltType(next->second.first));
-        return QVariant(prop.anim_get_double("keyframe", p));
-    } else if (m_paramType == ParamType::AnimatedRect) {
-        QStringList vals = prev->second.second.toString().split(QLatin1Char(' '));
-        if (vals.count() >= 4) {
-            mlt_rect rect;
-            rect.x = vals.at(0).toInt();
-            rect.y = vals.at(1).toInt();
-            rect.w = vals.at(2).toInt();
-            rect.h = vals.at(3).toInt();
-            if (useOpacity) {
-                if (vals.count()) {
-                    rect.o = locale.toDouble(vals.at(4));
-                } else {
-                    rect.o = 1;
-                }
-            }
-            prop.anim_set("keyframe", rect, prev->first.frames(pCore->getCurrentFps()), next->first.frames(pCore->getCurrentFps()),
-                          convertToMltType(prev->second.first));
+    return rect;
+}
+} // namespace
+
+Mlt::Properties *KeyframeModel::cachedAnimation() const
+{
+    if (!m_animation) {
+        m_animation.reset(new Mlt::Properties());
+        if (auto ptr = m_model.lock()) {
+            ptr->passProperties(*m_animation.get());
         }
-        vals = next->second.second.toString().split(QLatin1Char(' '));
-        if (vals.count() >= 4) {
-            mlt_rect rect;
-            rect.x = vals.at(0).toInt();
-            rect.y = vals.at(1).toInt();
-            rect.w = vals.at(2).toInt();
-            rect.h = vals.at(3).toInt();
-            if (useOpacity) {
-                if (vals.count() > 4) {
-                    rect.o = locale.toDouble(vals.at(4));
-                } else {
-                    rect.o = 1;
-                }
+        int ix = 0;
+        for (auto it = m_keyframeList.cbegin(); it != m_keyframeList.cend(); ++it) {
+            setAnimationKey(it, ix++);
+        }
+    }
+    return m_animation.get();
+}
+
+void KeyframeModel::setAnimationKey(std::map<GenTime, std::pair<KeyframeType, QVariant>>::const_iterator keyframe, int index) const
+{
+    int frame = keyframe->first.frames(pCore->getCurrentFps());
+    mlt_keyframe_type type = convertToMltType(keyframe->second.first);
+    if (m_paramType == ParamType::AnimatedRect) {
+        // The string is kept as is for serialization, the parsed rect is used for interpolation
+        const QString value = keyframe->second.second.toString();
+        m_animation->anim_set("key", value.toUtf8().constData(), frame);
+        std::unique_ptr<Mlt::Animation> anim(m_animation->get_anim("key"));
+        anim->key_set_type(index, type);
+        m_animation->anim_set("rect", stringToRect(value, m_useOpacity), frame, 0, type);
+    } else {
+        m_animation->anim_set("key", keyframe->second.second.toDouble(), frame, 0, type);
+    }
+}
+
+const QList<BPoint> &KeyframeModel::cachedSpline(std::map<GenTime, std::pair<KeyframeType, QVariant>>::const_iterator keyframe) const
+{
+    auto it = m_splines.find(keyframe->first);
+    if (it == m_splines.end()) {
+        it = m_splines.emplace(keyframe->first, RotoHelper::getPoints(keyframe->second.second, QSize(1, 1))).first;
+    }
+    return it->second;
+}
+
+void KeyframeModel::updateCache(GenTime pos)
+{
+    QMutexLocker locker(&m_cacheMutex);
+    m_splines.erase(pos);
+    if (!m_animation) {
+        // Nothing parsed yet
+        return;
+    }
+    if (m_keyframeList.empty()) {
+        m_animation.reset();
+        return;
+    }
+    auto it = m_keyframeList.find(pos);
+    if (it == m_keyframeList.end()) {
+        int frame = pos.frames(pCore->getCurrentFps());
+        for (const char *name : {"key", "rect"}) {
+            std::unique_ptr<Mlt::Animation> anim(m_animation->get_anim(name));
+            if (anim->is_valid()) {
+                anim->remove(frame);
             }
-            prop.anim_set("keyframe", rect, next->first.frames(pCore->getCurrentFps()), next->first.frames(pCore->getCurrentFps()),
-                          convertToMltType(next->second.first));
         }
-        mlt_rect rect = prop.anim_get_rect("keyframe", p);
+        return;
+    }
+    setAnimationKey(it, static_cast<int>(std::distance(m_keyframeList.begin(), it)));
+}
+
+QVariant KeyframeModel::interpolate(int p, std::map<GenTime, std::pair<KeyframeType, QVariant>>::const_iterator prev,
+                                    std::map<GenTime, std::pair<KeyframeType, QVariant>>::const_iterator next) const
+{
+    if (m_paramType == ParamType::KeyframeParam) {
+        return QVariant(cachedAnimation()->anim_get_double("key", p));
+    } else if (m_paramType == ParamType::AnimatedRect) {
+        mlt_rect rect = cachedAnimation()->anim_get_rect("rect", p);
         QString res = QStringLiteral("%1 %2 %3 %4").arg((int)rect.x).arg((int)rect.y).arg((int)rect.w).arg((int)rect.h);
-        if (useOpacity) {
+        if (m_useOpacity) {
+            QLocale locale;
             res.append(QStringLiteral(" %1").arg(locale.toString(rect.o)));
         }
         return QVariant(res);
     } else if (m_paramType == ParamType::Roto_spline) {
-        // interpolate
-        QSize frame = pCore->getCurrentFrameSize();
-        QList<BPoint> p1 = RotoHelper::getPoints(prev->second.second, frame);
-        QList<BPoint> p2 = RotoHelper::getPoints(next->second.second, frame);
+        const QList<BPoint> &p1 = cachedSpline(prev);
+        const QList<BPoint> &p2 = cachedSpline(next);
         // relPos should be in [0,1]:
         // - equal to 0 on prev keyframe
         // - equal to 1 on next keyframe
@@ -1008,7 +1033,7 @@ QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
                 } else {
                     bp[j] = p1.at(i)[j];
                 }
-                pl << QVariant(QList<QVariant>() << QVariant(bp[j].x() / frame.width()) << QVariant(bp[j].y() / frame.height()));
+                pl << QVariant(QList<QVariant>() << QVariant(bp[j].x()) << QVariant(bp[j].y()));
             }
             vlist << QVariant(pl);
         }
@@ -1024,6 +1049,8 @@ void KeyframeModel::sendModification()
         QString name = ptr->data(m_index, AssetParameterModel::NameRole).toString();
         if (m_paramType == ParamType::KeyframeParam || m_paramType == ParamType::AnimatedRect || m_paramType == ParamType::Roto_spline) {
             m_lastData = getAnimProperty();
+            ptr->setChangedRange(m_changedRange.first, m_changedRange.second);
+            m_changedRange = {-1, -1};
             ptr->setParameter(name, m_lastData, false);
         } else {
             Q_ASSERT(false); // Not implemented, TODO
@@ -1031,6 +1058,27 @@ void KeyframeModel::sendModification()
     }
 }
 
+QPair<int, int> KeyframeModel::changedRange(GenTime pos) const
+{
+    // A keyframe value is interpolated up to the neighbour keyframes, smooth interpolation also uses the keyframes after them
+    auto it = m_keyframeList.find(pos);
+    int depth = 1;
+    auto first = it;
+    auto last = std::next(it);
+    if (it->second.first == KeyframeType::Curve || (first != m_keyframeList.begin() && std::prev(first)->second.first == KeyframeType::Curve)) {
+        depth = 2;
+    }
+    for (int i = 0; i < depth && first != m_keyframeList.begin(); ++i) {
+        --first;
+    }
+    for (int i = 1; i < depth && last != m_keyframeList.end(); ++i) {
+        ++last;
+    }
+    int in = first == it ? -1 : first->first.frames(pCore->getCurrentFps());
+    int out = last == m_keyframeList.end() ? -1 : last->first.frames(pCore->getCurrentFps());
+    return {in, out};
+}
+
 void KeyframeModel::refresh()
 {
     Q_ASSERT(m_index.isValid());
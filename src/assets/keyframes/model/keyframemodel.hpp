@@ -23,11 +23,13 @@
 #define KEYFRAMELISTMODEL_H
 
 #include "assets/model/assetparametermodel.hpp"
+#include "assets/keyframes/model/rotoscoping/bpoint.h"
 #include "definitions.h"
 #include "gentime.h"
 #include "undohelper.hpp"
 
 #include <QAbstractListModel>
+#include <QMutex>
 #include <QReadWriteLock>
 
 #include <map>
@@ -198,17 +200,40 @@ protected:
     /* @brief this function does the opposite of getAnimProperty: given a MLT representation of an animation, build the corresponding model */
     void parseAnimProperty(const QString &prop);
     void parseRotoProperty(const QString &prop);
+    /* @brief Returns the frames whose value depends on the keyframe at pos */
+    QPair<int, int> changedRange(GenTime pos) const;
+
+    /* @brief Returns the parsed animation of the keyframes, building it if needed. m_cacheMutex must be locked */
+    Mlt::Properties *cachedAnimation() const;
+    /* @brief Set the given keyframe, of rank index, in the parsed animation. m_cacheMutex must be locked */
+    void setAnimationKey(std::map<GenTime, std::pair<KeyframeType, QVariant>>::const_iterator keyframe, int index) const;
+    /* @brief Returns the parsed spline of a roto keyframe, in normalized coordinates. m_cacheMutex must be locked */
+    const QList<BPoint> &cachedSpline(std::map<GenTime, std::pair<KeyframeType, QVariant>>::const_iterator keyframe) const;
+    /* @brief Reflect the change of the keyframe at pos in the parsed keyframes */
+    void updateCache(GenTime pos);
+    /* @brief Interpolate the value at frame p between the keyframes prev and next. m_cacheMutex must be locked */
+    QVariant interpolate(int p, std::map<GenTime, std::pair<KeyframeType, QVariant>>::const_iterator prev,
+                         std::map<GenTime, std::pair<KeyframeType, QVariant>>::const_iterator next) const;
 
 private:
     std::weak_ptr<AssetParameterModel> m_model;
     std::weak_ptr<DocUndoStack> m_undoStack;
     QPersistentModelIndex m_index;
     QString m_lastData;
+    // frames affected by the last keyframe value change, -1 if open on that side
+    QPair<int, int> m_changedRange;
     ParamType m_paramType;
     mutable QReadWriteLock m_lock; // This is a lock that ensures safety in case of concurrent access
 
     std::map<GenTime, std::pair<KeyframeType, QVariant>> m_keyframeList;
 
+    /* The keyframes parsed once to their typed values, kept in sync with m_keyframeList:
+       an MLT animation for doubles and rects, point lists for roto splines */
+    mutable QMutex m_cacheMutex;
+    mutable std::unique_ptr<Mlt::Properties> m_animation;
+    mutable std::map<GenTime, QList<BPoint>> m_splines;
+    bool m_useOpacity;
+
 signals:
     void modelChanged();
 
@@ -25,6 +25,18 @@
 #include "transitions/transitionsrepository.hpp"
 #include <memory>
 #include <utility>
+
+namespace {
+// Commands of an interactive edit (slider drag) are merged together, other ones when they are close in time
+bool canMergeAssetCommands(int gesture, const QTime &stamp, int otherGesture, const QTime &otherStamp, int maxDelay)
+{
+    if (gesture > 0 || otherGesture > 0) {
+        return gesture == otherGesture;
+    }
+    return stamp.msecsTo(otherStamp) <= maxDelay;
+}
+} // namespace
+
 AssetCommand::AssetCommand(const std::shared_ptr<AssetParameterModel> &model, const QModelIndex &index, QString value, QUndoCommand *parent)
     : QUndoCommand(parent)
     , m_model(model)
@@ -32,6 +44,7 @@ AssetCommand::AssetCommand(const std::shared_ptr<AssetParameterModel> &model, co
     , m_value(std::move(value))
     , m_updateView(false)
     , m_stamp(QTime::currentTime())
+    , m_gesture(model->gestureId())
 {
     QLocale locale;
     locale.setNumberOptions(QLocale::OmitGroupSeparator);
@@ -66,7 +79,7 @@ int AssetCommand::id() const
 bool AssetCommand::mergeWith(const QUndoCommand *other)
 {
     if (other->id() != id() || static_cast<const AssetCommand *>(other)->m_index != m_index ||
-        m_stamp.msecsTo(static_cast<const AssetCommand *>(other)->m_stamp) > 3000) {
+        !canMergeAssetCommands(m_gesture, m_stamp, static_cast<const AssetCommand *>(other)->m_gesture, static_cast<const AssetCommand *>(other)->m_stamp, 3000)) {
         return false;
     }
     m_value = static_cast<const AssetCommand *>(other)->m_value;
@@ -145,6 +158,7 @@ AssetKeyframeCommand::AssetKeyframeCommand(const std::shared_ptr<AssetParameterM
     , m_pos(pos)
     , m_updateView(false)
     , m_stamp(QTime::currentTime())
+    , m_gesture(model->gestureId())
 {
     const QString id = model->getAssetId();
     if (EffectsRepository::get()->exists(id)) {
@@ -175,7 +189,8 @@ int AssetKeyframeCommand::id() const
 bool AssetKeyframeCommand::mergeWith(const QUndoCommand *other)
 {
     if (other->id() != id() || static_cast<const AssetKeyframeCommand *>(other)->m_index != m_index ||
-        m_stamp.msecsTo(static_cast<const AssetKeyframeCommand *>(other)->m_stamp) > 1000) {
+        !canMergeAssetCommands(m_gesture, m_stamp, static_cast<const AssetKeyframeCommand *>(other)->m_gesture,
+                               static_cast<const AssetKeyframeCommand *>(other)->m_stamp, 1000)) {
         return false;
     }
     m_value = static_cast<const AssetKeyframeCommand *>(other)->m_value;
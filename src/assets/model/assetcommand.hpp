@@ -44,6 +44,7 @@ private:
     QString m_oldValue;
     bool m_updateView;
     QTime m_stamp;
+    int m_gesture;
 };
 
 class AssetMultiCommand : public QUndoCommand
@@ -83,6 +84,7 @@ private:
     GenTime m_pos;
     bool m_updateView;
     QTime m_stamp;
+    int m_gesture;
 };
 
 class AssetUpdateCommand : public QUndoCommand
@@ -31,6 +31,9 @@
 #include <QJsonObject>
 #include <QLocale>
 #include <QString>
+#include <QThread>
+
+int AssetParameterModel::s_lastGesture = 0;
 
 AssetParameterModel::AssetParameterModel(std::unique_ptr<Mlt::Properties> asset, const QDomElement &assetXml, const QString &assetId, ObjectId ownerId,
                                          QObject *parent)
@@ -40,8 +43,17 @@ AssetParameterModel::AssetParameterModel(std::unique_ptr<Mlt::Properties> asset,
     , m_ownerId(ownerId)
     , m_asset(std::move(asset))
     , m_keyframes(nullptr)
+    , m_gesture(0)
+    , m_pendingModelChanged(false)
+    , m_pendingRefresh(false)
+    , m_pendingRange(-1, -1)
+    , m_nextRange(-1, -1)
 {
     Q_ASSERT(m_asset->is_valid());
+    // Parameter changes are notified at most once per displayed frame
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(16);
+    connect(&m_updateTimer, &QTimer::timeout, this, &AssetParameterModel::flushUpdates);
     QDomNodeList nodeList = assetXml.elementsByTagName(QStringLiteral("parameter"));
     m_hideKeyframesByDefault = assetXml.hasAttribute(QStringLiteral("hideKeyframes"));
     m_isAudio = assetXml.attribute(QStringLiteral("type")) == QLatin1String("audio");
@@ -186,16 +198,8 @@ void AssetParameterModel::setParameter(const QString &name, int value, bool upda
         emit replugEffect(shared_from_this());
     }
     if (update) {
-        emit modelChanged();
         emit dataChanged(index(0, 0), index(m_rows.count() - 1, 0), {});
-        // Update fades in timeline
-        pCore->updateItemModel(m_ownerId, m_assetId);
-        if (!m_isAudio) {
-            // Trigger monitor refresh
-            pCore->refreshProjectItem(m_ownerId);
-            // Invalidate timeline preview
-            pCore->invalidateItem(m_ownerId);
-        }
+        scheduleUpdate(true, true);
     }
 }
 
@@ -272,25 +276,88 @@ void AssetParameterModel::setParameter(const QString &name, const QString &param
             QModelIndex ix = index(m_rows.indexOf(name), 0);
             emit dataChanged(ix, ix);
         }
-        emit modelChanged();
     }
     if (updateChildRequired) {
         emit updateChildren(name);
     }
-    // Update timeline view if necessary
-    if (m_ownerId.first == ObjectType::NoItem) {
-        // Used for generator clips
-        if (!update) emit modelChanged();
-    } else {
-        // Update fades in timeline
-        pCore->updateItemModel(m_ownerId, m_assetId);
-        if (!m_isAudio) {
-            // Trigger monitor refresh
-            pCore->refreshProjectItem(m_ownerId);
-            // Invalidate timeline preview
-            pCore->invalidateItem(m_ownerId);
+    // Update timeline view if necessary. Generator clips have no owner and only need modelChanged
+    scheduleUpdate((update && updateChildRequired) || m_ownerId.first == ObjectType::NoItem, m_ownerId.first != ObjectType::NoItem);
+}
+
+void AssetParameterModel::setChangedRange(int in, int out)
+{
+    m_nextRange = {in, out};
+}
+
+void AssetParameterModel::scheduleUpdate(bool notifyModel, bool refreshItem)
+{
+    m_pendingModelChanged = m_pendingModelChanged || notifyModel;
+    if (refreshItem) {
+        if (!m_pendingRefresh) {
+            m_pendingRefresh = true;
+            m_pendingRange = m_nextRange;
+        } else {
+            // -1 means the range is open on that side
+            m_pendingRange.first = (m_pendingRange.first == -1 || m_nextRange.first == -1) ? -1 : qMin(m_pendingRange.first, m_nextRange.first);
+            m_pendingRange.second = (m_pendingRange.second == -1 || m_nextRange.second == -1) ? -1 : qMax(m_pendingRange.second, m_nextRange.second);
         }
     }
+    m_nextRange = {-1, -1};
+    if (QThread::currentThread() != thread()) {
+        // Timers can only be started from the model's thread
+        flushUpdates();
+    } else if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
+
+void AssetParameterModel::flushUpdates()
+{
+    m_updateTimer.stop();
+    if (m_pendingModelChanged) {
+        m_pendingModelChanged = false;
+        emit modelChanged();
+    }
+    if (!m_pendingRefresh) {
+        return;
+    }
+    m_pendingRefresh = false;
+    // Update fades in timeline
+    pCore->updateItemModel(m_ownerId, m_assetId);
+    if (m_isAudio) {
+        return;
+    }
+    // Trigger monitor refresh
+    pCore->refreshProjectItem(m_ownerId);
+    // Invalidate timeline preview, only on the frames affected by the changes if they are known
+    if (m_pendingRange == QPair<int, int>(-1, -1) || (m_ownerId.first != ObjectType::TimelineClip && m_ownerId.first != ObjectType::TimelineComposition)) {
+        pCore->invalidateItem(m_ownerId);
+        return;
+    }
+    int position = pCore->getItemPosition(m_ownerId);
+    int duration = pCore->getItemDuration(m_ownerId);
+    int offset = position - pCore->getItemIn(m_ownerId);
+    int start = m_pendingRange.first == -1 ? position : qMax(position, m_pendingRange.first + offset);
+    int end = m_pendingRange.second == -1 ? position + duration : qMin(position + duration, m_pendingRange.second + offset);
+    if (end > start) {
+        pCore->invalidateRange(QSize(start, end));
+    }
+}
+
+void AssetParameterModel::beginGesture()
+{
+    m_gesture = ++s_lastGesture;
+}
+
+void AssetParameterModel::endGesture()
+{
+    m_gesture = 0;
+    flushUpdates();
+}
+
+int AssetParameterModel::gestureId() const
+{
+    return m_gesture;
 }
 
 AssetParameterModel::~AssetParameterModel() = default;
@@ -27,6 +27,7 @@
 #include <QAbstractListModel>
 #include <QDomElement>
 #include <QJsonDocument>
+#include <QTimer>
 #include <unordered_map>
 
 #include <memory>
@@ -171,6 +172,18 @@ public:
     void passProperties(Mlt::Properties &target);
     /* @brief Returns a list of the parameter names that are keyframable */
     QStringList getKeyframableParameters() const;
+    /* @brief Restricts the timeline preview invalidation of the next parameter change to a frame range, in keyframe positions.
+       -1 leaves the range open on that side */
+    void setChangedRange(int in, int out);
+    /* @brief Marks the start and end of an interactive edit, like a slider drag. Its changes are merged in a single undo entry */
+    void beginGesture();
+    void endGesture();
+    /* @brief Returns the id of the current interactive edit, 0 if there is none */
+    int gestureId() const;
+
+public slots:
+    /* @brief Send the pending change notifications now instead of waiting for the next displayed frame */
+    void flushUpdates();
 
 protected:
     /* @brief Helper function to retrieve the type of a parameter given the string corresponding to it*/
@@ -218,6 +231,17 @@ protected:
      *  building an effect in the constructor, so that we don't call shared_from_this
      */
     void internalSetParameter(const QString &name, const QString &paramValue, const QModelIndex &paramIndex = QModelIndex());
+    /* @brief Schedule the notifications of a parameter change. Changes are grouped and notified once per displayed frame */
+    void scheduleUpdate(bool notifyModel, bool refreshItem);
+
+    static int s_lastGesture;
+    int m_gesture;
+    QTimer m_updateTimer;
+    bool m_pendingModelChanged;
+    bool m_pendingRefresh;
+    // frame range of the pending preview invalidation, -1 if open on that side
+    QPair<int, int> m_pendingRange;
+    QPair<int, int> m_nextRange;
 
 signals:
     void modelChanged();
@@ -52,6 +52,9 @@ DoubleParamWidget::DoubleParamWidget(std::shared_ptr<AssetParameterModel> model,
 
     // Connect signal
     connect(m_doubleWidget, &DoubleWidget::valueChanged, [this, locale](double val) { emit valueChanged(m_index, locale.toString(val), true); });
+    // All the changes of a drag are merged in a single undo entry
+    connect(m_doubleWidget, &DoubleWidget::dragStarted, [this]() { m_model->beginGesture(); });
+    connect(m_doubleWidget, &DoubleWidget::dragFinished, [this]() { m_model->endGesture(); });
     slotRefresh();
 }
 
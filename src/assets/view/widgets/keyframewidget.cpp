@@ -393,6 +393,8 @@ void KeyframeWidget::addParameter(const QPersistentModelIndex &index)
             activateEffect();
             m_keyframes->updateKeyframe(GenTime(getPosition(), pCore->getCurrentFps()), QVariant(v), index);
         });
+        connect(doubleWidget, &DoubleWidget::dragStarted, [this]() { m_model->beginGesture(); });
+        connect(doubleWidget, &DoubleWidget::dragFinished, [this]() { m_model->endGesture(); });
         paramWidget = doubleWidget;
     }
     if (paramWidget) {
@@ -0,0 +1,118 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "audiolevelanalyzer.hpp"
+
+#include <QtGlobal>
+#include <cmath>
+
+AudioLevelAnalyzer::AudioLevelAnalyzer(double fps)
+    // 300ms for the RMS and 3 seconds for the short-term loudness, as in EBU R 128
+    : m_rmsFrames(qMax(1, qRound(fps * 0.3)))
+    , m_loudnessFrames(qMax(1, qRound(fps * 3)))
+    , m_holdFrames(qMax(1, qRound(fps)))
+    // Peaks fall over the whole scale in 2 seconds once the hold time elapsed
+    , m_peakDecay(0.5 / qMax(1., fps))
+{
+}
+
+void AudioLevelAnalyzer::reset()
+{
+    m_channels = 0;
+    m_lastPosition = -1;
+}
+
+AudioLevelRecord AudioLevelAnalyzer::process(int position, const QVector<double> &amplitudes)
+{
+    const int channels = amplitudes.size();
+    if (position == m_lastPosition && channels == m_channels) {
+        return m_lastRecord;
+    }
+    if (channels != m_channels || m_lastPosition < 0 || position != m_lastPosition + 1) {
+        m_channels = channels;
+        m_frames = 0;
+        m_history.assign(size_t(m_loudnessFrames * channels), 0.);
+        m_peaks.fill(0., channels);
+        m_peakAge.fill(0, channels);
+    }
+    m_lastPosition = position;
+    double *current = m_history.data() + (m_frames % m_loudnessFrames) * channels;
+    m_frames++;
+
+    AudioLevelRecord record;
+    record.position = position;
+    record.levels.resize(channels);
+    record.rms.resize(channels);
+    double loudnessSum = 0.;
+    const int loudnessCount = qMin(m_frames, m_loudnessFrames);
+    const int rmsCount = qMin(m_frames, m_rmsFrames);
+    for (int i = 0; i < channels; ++i) {
+        current[i] = amplitudes.at(i) * amplitudes.at(i);
+        double level = iecScale(amplitudes.at(i));
+        record.levels[i] = level;
+        if (level >= m_peaks.at(i)) {
+            m_peaks[i] = level;
+            m_peakAge[i] = 0;
+        } else if (++m_peakAge[i] > m_holdFrames) {
+            m_peaks[i] = qMax(level, m_peaks.at(i) - m_peakDecay);
+        }
+        double squares = 0.;
+        for (int frame = 0; frame < loudnessCount; ++frame) {
+            // Walk the history backwards from the current frame
+            double value = m_history[size_t(((m_frames - 1 - frame) % m_loudnessFrames) * channels + i)];
+            if (frame < rmsCount) {
+                squares += value;
+            }
+            loudnessSum += value;
+        }
+        record.rms[i] = iecScale(std::sqrt(squares / rmsCount));
+    }
+    record.peaks = m_peaks;
+    if (channels > 0 && loudnessSum > 0.) {
+        record.loudness = qMax(-100., 10. * std::log10(loudnessSum / (loudnessCount * channels)));
+    }
+    m_lastRecord = record;
+    return record;
+}
+
+// static
+double AudioLevelAnalyzer::iecScale(double amplitude)
+{
+    double dB = log10(amplitude) * 20.0;
+    double fScale = 1.0f;
+
+    if (dB < -70.0f)
+        fScale = 0.0f;
+    else if (dB < -60.0f)
+        fScale = (dB + 70.0f) * 0.0025f;
+    else if (dB < -50.0f)
+        fScale = (dB + 60.0f) * 0.005f + 0.025f;
+    else if (dB < -40.0)
+        fScale = (dB + 50.0f) * 0.0075f + 0.075f;
+    else if (dB < -30.0f)
+        fScale = (dB + 40.0f) * 0.015f + 0.15f;
+    else if (dB < -20.0f)
+        fScale = (dB + 30.0f) * 0.02f + 0.3f;
+    else if (dB < -0.001f || dB > 0.001f)  /* if (dB < 0.0f) */
+        fScale = (dB + 20.0f) * 0.025f + 0.5f;
+
+    return fScale;
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef AUDIOLEVELANALYZER_H
+#define AUDIOLEVELANALYZER_H
+
+#include <QVector>
+#include <vector>
+
+/** @brief Levels of one frame of a track, meter values are between 0 and 1 on the IEC scale */
+struct AudioLevelRecord
+{
+    int position{-1};
+    QVector<double> levels;
+    QVector<double> peaks;
+    QVector<double> rms;
+    /** @brief Short-term loudness of all channels, in dB */
+    double loudness{-100.};
+};
+
+/**
+ * @class AudioLevelAnalyzer
+ * @brief Turns the per channel amplitudes of consecutive frames into meter values.
+ * Peak hold, RMS and short-term loudness need a few seconds of history, they are computed here on the thread
+ * producing the levels so that the GUI only has to draw them. Seeking or changing the channel count restarts the history.
+ */
+class AudioLevelAnalyzer
+{
+public:
+    explicit AudioLevelAnalyzer(double fps);
+
+    /** @brief Returns the meter values at @param position, given the amplitude (0 to 1) of each channel.
+        A repeated position, as when the playback is paused, returns the previous values */
+    AudioLevelRecord process(int position, const QVector<double> &amplitudes);
+    /** @brief Forget the history */
+    void reset();
+
+    /** @brief Converts an amplitude to the IEC 268-18 meter scale */
+    static double iecScale(double amplitude);
+
+private:
+    int m_rmsFrames;
+    int m_loudnessFrames;
+    int m_holdFrames;
+    double m_peakDecay;
+    int m_channels{0};
+    int m_lastPosition{-1};
+    int m_frames{0};
+    /** @brief Squared amplitudes of the last m_loudnessFrames frames, interleaved by channel */
+    std::vector<double> m_history;
+    QVector<double> m_peaks;
+    QVector<int> m_peakAge;
+    AudioLevelRecord m_lastRecord;
+};
+
+#endif
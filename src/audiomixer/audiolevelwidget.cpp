@@ -20,12 +20,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "audiolevelwidget.hpp"
+#include "audiolevelanalyzer.hpp"
 #include "core.h"
 #include "profiles/profilemodel.hpp"
 
 #include "mlt++/Mlt.h"
 
 #include <cmath>
+#include <klocalizedstring.h>
 
 #include <QFont>
 #include <QPaintEvent>
@@ -36,6 +38,7 @@ AudioLevelWidget::AudioLevelWidget(int width, QWidget *parent)
     : QWidget(parent)
     , audioChannels(2)
     , m_width(width)
+    , m_loudness(-100.)
     , m_channelWidth(width / 2)
     , m_channelDistance(2)
     , m_channelFillWidth(m_channelWidth)
@@ -45,6 +48,13 @@ AudioLevelWidget::AudioLevelWidget(int width, QWidget *parent)
     ft.setPointSizeF(ft.pointSize() * 0.8);
     setFont(ft);
     setMinimumWidth(4);
+    // Levels arrive with each displayed frame, 25 repaints per second are enough for a meter
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(40);
+    connect(&m_refreshTimer, &QTimer::timeout, this, [this]() {
+        setToolTip(m_loudness > -100. ? i18n("Short-term loudness: %1 dB", QString::number(m_loudness, 'f', 1)) : QString());
+        update();
+    });
 }
 
 AudioLevelWidget::~AudioLevelWidget()
@@ -156,6 +166,8 @@ void AudioLevelWidget::drawBackground(int channels)
 void AudioLevelWidget::setAudioValues(const QVector<double> &values)
 {
     m_values = values;
+    m_rms.clear();
+    m_loudness = -100.;
     if (m_peaks.size() != m_values.size()) {
         m_peaks = values;
         drawBackground(values.size());
@@ -167,7 +179,27 @@ void AudioLevelWidget::setAudioValues(const QVector<double> &values)
             }
         }
     }
-    update();
+    scheduleRefresh();
+}
+
+void AudioLevelWidget::setAudioLevels(const AudioLevelRecord &record)
+{
+    bool channelsChanged = m_peaks.size() != record.levels.size();
+    m_values = record.levels;
+    m_peaks = record.peaks;
+    m_rms = record.rms;
+    m_loudness = record.loudness;
+    if (channelsChanged) {
+        drawBackground(m_values.size());
+    }
+    scheduleRefresh();
+}
+
+void AudioLevelWidget::scheduleRefresh()
+{
+    if (!m_refreshTimer.isActive()) {
+        m_refreshTimer.start();
+    }
 }
 
 void AudioLevelWidget::setVisibility(bool enable)
@@ -205,5 +237,8 @@ void AudioLevelWidget::paintEvent(QPaintEvent *pe)
         //int val = (50 + m_values.at(i)) / 150.0 * rect.height();
         p.fillRect(m_offset + i * (m_channelWidth + m_channelDistance) + 1, 0, m_channelFillWidth, height() - (m_values.at(i) * rect.height()), palette().dark());
         p.fillRect(m_offset + i * (m_channelWidth + m_channelDistance) + 1, height() - (m_peaks.at(i) * rect.height()), m_channelFillWidth, 1, palette().text());
+        if (i < m_rms.count()) {
+            p.fillRect(m_offset + i * (m_channelWidth + m_channelDistance) + 1, height() - (m_rms.at(i) * rect.height()), m_channelFillWidth, 2, palette().highlight());
+        }
     }
 }
@@ -22,9 +22,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef AUDIOLEVELWIDGET_H
 #define AUDIOLEVELWIDGET_H
 
+#include <QTimer>
 #include <QWidget>
 #include <memory>
 
+struct AudioLevelRecord;
 namespace Mlt {
 class Filter;
 } // namespace Mlt
@@ -52,13 +54,20 @@ private:
     QPixmap m_pixmap;
     QVector<double> m_peaks;
     QVector<double> m_values;
+    QVector<double> m_rms;
+    double m_loudness;
+    /** @brief Coalesces the level changes, so that we don't repaint on every frame */
+    QTimer m_refreshTimer;
     int m_channelWidth;
     int m_channelDistance;
     int m_channelFillWidth;
     void drawBackground(int channels = 2);
+    void scheduleRefresh();
 
 public slots:
     void setAudioValues(const QVector<double> &values);
+    /** @brief Display levels with their peak hold, RMS and loudness already computed */
+    void setAudioLevels(const AudioLevelRecord &record);
 };
 
 #endif
@@ -45,29 +45,6 @@
 #include <QStyle>
 #include <QFontDatabase>
 
-static inline double IEC_Scale(double dB)
-{
-    dB = log10(dB) * 20.0;
-    double fScale = 1.0f;
-
-    if (dB < -70.0f)
-        fScale = 0.0f;
-    else if (dB < -60.0f)
-        fScale = (dB + 70.0f) * 0.0025f;
-    else if (dB < -50.0f)
-        fScale = (dB + 60.0f) * 0.005f + 0.025f;
-    else if (dB < -40.0)
-        fScale = (dB + 50.0f) * 0.0075f + 0.075f;
-    else if (dB < -30.0f)
-        fScale = (dB + 40.0f) * 0.015f + 0.15f;
-    else if (dB < -20.0f)
-        fScale = (dB + 30.0f) * 0.02f + 0.3f;
-    else if (dB < -0.001f || dB > 0.001f)  /* if (dB < 0.0f) */
-        fScale = (dB + 20.0f) * 0.025f + 0.5f;
-
-    return fScale;
-}
-
 static inline int fromDB(double level)
 {
     int value = 60;
@@ -83,14 +60,25 @@ static inline int fromDB(double level)
 void MixerWidget::property_changed( mlt_service , MixerWidget *widget, char *name )
 {
     if (widget && !strcmp(name, "_position")) {
+        if (widget->m_storing.exchange(true)) {
+            return;
+        }
         mlt_properties filter_props = MLT_FILTER_PROPERTIES( widget->m_monitorFilter->get_filter());
         int pos = mlt_properties_get_int(filter_props, "_position");
-        if (!widget->m_levels.contains(pos)) {
-            widget->m_levels[pos] = {IEC_Scale(mlt_properties_get_double(filter_props, "_audio_level.0")), IEC_Scale(mlt_properties_get_double(filter_props, "_audio_level.1"))};
-            if (widget->m_levels.size() > widget->m_maxLevels) {
-                widget->m_levels.erase(widget->m_levels.begin());
+        // The audiolevel filter sets one level per channel
+        QVector<double> amplitudes;
+        for (int i = 0;; i++) {
+            const QByteArray property = QByteArrayLiteral("_audio_level.") + QByteArray::number(i);
+            if (mlt_properties_get(filter_props, property.constData()) == nullptr) {
+                break;
             }
+            amplitudes << mlt_properties_get_double(filter_props, property.constData());
+        }
+        if (widget->m_resetAnalyzer.exchange(false)) {
+            widget->m_analyzer.reset();
         }
+        widget->m_pendingLevels.push(widget->m_analyzer.process(pos, amplitudes));
+        widget->m_storing = false;
     }
 }
 
@@ -108,6 +96,11 @@ MixerWidget::MixerWidget(bool alternateBackground, int tid, std::shared_ptr<Mlt:
     , m_lastVolume(0)
     , m_listener(nullptr)
     , m_recording(false)
+    , m_channels(2)
+    , m_analyzer(service->get_fps())
+    , m_pendingLevels(m_maxLevels, DataQueue<AudioLevelRecord>::OverflowModeDiscardOldest)
+    , m_storing(false)
+    , m_resetAnalyzer(false)
 {
     buildUI(alternateBackground, service.get(), trackTag);
 }
@@ -126,6 +119,11 @@ MixerWidget::MixerWidget(bool alternateBackground, int tid, Mlt::Tractor *servic
     , m_lastVolume(0)
     , m_listener(nullptr)
     , m_recording(false)
+    , m_channels(2)
+    , m_analyzer(service->get_fps())
+    , m_pendingLevels(m_maxLevels, DataQueue<AudioLevelRecord>::OverflowModeDiscardOldest)
+    , m_storing(false)
+    , m_resetAnalyzer(false)
 {
     buildUI(alternateBackground, service, trackTag);
 }
@@ -309,7 +307,7 @@ void MixerWidget::buildUI(bool alternateBackground, Mlt::Tractor *service, const
             m_volumeSpin->setValue(dbValue);
             m_levelFilter->set("level", dbValue);
             m_levelFilter->set("disable", value == 60 ? 1 : 0);
-            m_levels.clear();
+            clear();
             m_manager->purgeCache();
             pCore->setDocumentModified();
         }
@@ -320,7 +318,7 @@ void MixerWidget::buildUI(bool alternateBackground, Mlt::Tractor *service, const
         if (m_balanceFilter != nullptr) {
             m_balanceFilter->set("start", (value + 50) / 100.);
             m_balanceFilter->set("disable", value == 0 ? 1 : 0);
-            m_levels.clear();
+            clear();
             m_manager->purgeCache();
             pCore->setDocumentModified();
         }
@@ -404,27 +402,36 @@ void MixerWidget::updateLabel()
 
 void MixerWidget::updateAudioLevel(int pos)
 {
-    QMutexLocker lk(&m_storeMutex);
-    if (m_levels.contains(pos)) {
-        m_audioMeterWidget->setAudioValues({m_levels.value(pos).first, m_levels.value(pos).second});
-        //m_levels.remove(pos);
+    AudioLevelRecord record;
+    while (m_pendingLevels.tryPop(record)) {
+        m_levels.insert(record.position, record);
+    }
+    while (m_levels.size() > m_maxLevels) {
+        m_levels.erase(m_levels.begin());
+    }
+    auto it = m_levels.constFind(pos);
+    if (it != m_levels.constEnd()) {
+        m_channels = it->levels.size();
+        m_audioMeterWidget->setAudioLevels(*it);
     } else {
-        m_audioMeterWidget->setAudioValues({-100, -100});
+        m_audioMeterWidget->setAudioValues(QVector<double>(m_channels, -100));
     }
 }
 
 
 void MixerWidget::reset()
 {
-    QMutexLocker lk(&m_storeMutex);
-    m_levels.clear();
-    m_audioMeterWidget->setAudioValues({-100, -100});
+    clear();
+    m_audioMeterWidget->setAudioValues(QVector<double>(m_channels, -100));
 }
 
 void MixerWidget::clear()
 {
-    QMutexLocker lk(&m_storeMutex);
+    AudioLevelRecord record;
+    while (m_pendingLevels.tryPop(record)) {
+    }
     m_levels.clear();
+    m_resetAnalyzer = true;
 }
 
 
@@ -448,10 +455,10 @@ void MixerWidget::gotRecLevels(QVector<qreal>levels)
             m_audioMeterWidget->setAudioValues({-100, -100});
             break;
         case 1:
-            m_audioMeterWidget->setAudioValues({IEC_Scale(levels[0]), -100});
+            m_audioMeterWidget->setAudioValues({AudioLevelAnalyzer::iecScale(levels[0]), -100});
             break;
         default:
-            m_audioMeterWidget->setAudioValues({IEC_Scale(levels[0]), IEC_Scale(levels[1])});
+            m_audioMeterWidget->setAudioValues({AudioLevelAnalyzer::iecScale(levels[0]), AudioLevelAnalyzer::iecScale(levels[1])});
             break;
     }
 }
@@ -22,13 +22,15 @@
 #ifndef MIXERWIDGET_H
 #define MIXERWIDGET_H
 
+#include "audiolevelanalyzer.hpp"
 #include "definitions.h"
+#include "monitor/scopes/dataqueue.h"
 #include "mlt++/MltService.h"
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 #include <QWidget>
-#include <QMutex>
 
 class KDualAction;
 class AudioLevelWidget;
@@ -87,7 +89,8 @@ protected:
     std::shared_ptr<Mlt::Filter> m_levelFilter;
     std::shared_ptr<Mlt::Filter> m_monitorFilter;
     std::shared_ptr<Mlt::Filter> m_balanceFilter;
-    QMap<int, QPair<double, double>> m_levels;
+    /** @brief Levels of the last frames by position, only used in the GUI thread */
+    QMap<int, AudioLevelRecord> m_levels;
     KDualAction *m_muteAction;
     QSpinBox *m_balanceSpin;
     QDial *m_balanceDial;
@@ -101,10 +104,19 @@ private:
     QToolButton *m_record;
     QToolButton *m_collapse;
     QLabel *m_trackLabel;
-    QMutex m_storeMutex;
     int m_lastVolume;
     Mlt::Event *m_listener;
     bool m_recording;
+    /** @brief Number of channels of the last displayed levels */
+    int m_channels;
+    /** @brief Only used from the MLT thread */
+    AudioLevelAnalyzer m_analyzer;
+    /** @brief Levels computed in the MLT thread, waiting to be moved to m_levels */
+    DataQueue<AudioLevelRecord> m_pendingLevels;
+    /** @brief Set when the MLT thread is storing levels, a frame processed concurrently is not metered */
+    std::atomic<bool> m_storing;
+    /** @brief Set from the GUI thread to make the MLT thread restart its level history */
+    std::atomic<bool> m_resetAnalyzer;
     /** @Update track label to reflect state */
     void updateLabel();
 
@@ -1352,12 +1352,20 @@ void Bin::slotDeleteClip()
     if (usedFolder && (KMessageBox::warningContinueCancel(this, i18n("This will delete all folder content")) != KMessageBox::Continue)) {
         return;
     }
+    // The undo function keeps the deleted items alive, their description gives an idea of what they hold
+    QDomDocument doc;
+    QDomElement deleted = doc.createElement(QStringLiteral("deleted"));
+    doc.appendChild(deleted);
+    for (const auto &item : items) {
+        deleted.appendChild(item->toXml(doc));
+    }
+    const qint64 size = doc.toString(0).size() * (qint64)sizeof(QChar);
     Fun undo = []() { return true; };
     Fun redo = []() { return true; };
     for (const auto &item : items) {
         m_itemModel->requestBinClipDeletion(item, undo, redo);
     }
-    pCore->pushUndo(undo, redo, i18n("Delete bin Clips"));
+    pCore->pushUndo(undo, redo, i18n("Delete bin Clips"), size);
 }
 
 void Bin::slotReloadClip()
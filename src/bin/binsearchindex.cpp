@@ -0,0 +1,232 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "binsearchindex.hpp"
+
+#include <QAbstractItemModel>
+#include <QVector>
+
+namespace {
+quint64 trigramKey(const QString &text, int pos)
+{
+    return (quint64(text.at(pos).unicode()) << 32) | (quint64(text.at(pos + 1).unicode()) << 16) | quint64(text.at(pos + 2).unicode());
+}
+
+QSet<quint64> trigrams(const QString &text)
+{
+    QSet<quint64> result;
+    for (int i = 0; i + 2 < text.size(); ++i) {
+        result.insert(trigramKey(text, i));
+    }
+    return result;
+}
+} // namespace
+
+void BinSearchIndex::build(const QAbstractItemModel *model)
+{
+    clear();
+    int count = model->rowCount();
+    for (int i = 0; i < count; ++i) {
+        addItems(model, model->index(i, 0));
+    }
+    m_built = true;
+}
+
+void BinSearchIndex::clear()
+{
+    m_items.clear();
+    m_trigrams.clear();
+    m_types.clear();
+    m_ratings.clear();
+    m_built = false;
+}
+
+bool BinSearchIndex::isBuilt() const
+{
+    return m_built;
+}
+
+BinSearchIndex::Item BinSearchIndex::readItem(const QAbstractItemModel *model, const QModelIndex &index)
+{
+    // Same columns as ProjectItemModel::mapToColumn: name, date, description, type, tag and rating
+    auto columnData = [model, &index](int column) {
+        QModelIndex ix = model->index(index.row(), column, index.parent());
+        return ix.isValid() ? model->data(ix) : QVariant();
+    };
+    Item item;
+    QModelIndex parent = index.parent();
+    item.hasParent = parent.isValid();
+    item.parent = item.hasParent ? parent.internalId() : 0;
+    QStringList text;
+    for (int i = 0; i < 3; ++i) {
+        text << columnData(i).toString().toCaseFolded();
+    }
+    item.text = text.join(QLatin1Char('\n'));
+    item.type = columnData(3).toInt();
+    item.tags = columnData(4).toString().toCaseFolded();
+    item.rating = columnData(7).toInt();
+    return item;
+}
+
+void BinSearchIndex::insertItem(quintptr id, const Item &item)
+{
+    m_items.insert(id, item);
+    for (quint64 key : trigrams(item.text)) {
+        m_trigrams[key].insert(id);
+    }
+    m_types[item.type].insert(id);
+    m_ratings[item.rating].insert(id);
+}
+
+void BinSearchIndex::eraseItem(quintptr id)
+{
+    auto it = m_items.find(id);
+    if (it == m_items.end()) {
+        return;
+    }
+    auto removeFrom = [id](QSet<quintptr> &set) {
+        set.remove(id);
+        return set.isEmpty();
+    };
+    for (quint64 key : trigrams(it->text)) {
+        auto posting = m_trigrams.find(key);
+        if (posting != m_trigrams.end() && removeFrom(*posting)) {
+            m_trigrams.erase(posting);
+        }
+    }
+    if (removeFrom(m_types[it->type])) {
+        m_types.remove(it->type);
+    }
+    if (removeFrom(m_ratings[it->rating])) {
+        m_ratings.remove(it->rating);
+    }
+    m_items.erase(it);
+}
+
+void BinSearchIndex::addItems(const QAbstractItemModel *model, const QModelIndex &index)
+{
+    if (!index.isValid()) {
+        return;
+    }
+    eraseItem(index.internalId());
+    insertItem(index.internalId(), readItem(model, index));
+    int count = model->rowCount(index);
+    for (int i = 0; i < count; ++i) {
+        addItems(model, model->index(i, 0, index));
+    }
+}
+
+void BinSearchIndex::removeItems(const QAbstractItemModel *model, const QModelIndex &index)
+{
+    if (!index.isValid()) {
+        return;
+    }
+    int count = model->rowCount(index);
+    for (int i = 0; i < count; ++i) {
+        removeItems(model, model->index(i, 0, index));
+    }
+    eraseItem(index.internalId());
+}
+
+void BinSearchIndex::updateItem(const QAbstractItemModel *model, const QModelIndex &index)
+{
+    if (!index.isValid()) {
+        return;
+    }
+    eraseItem(index.internalId());
+    insertItem(index.internalId(), readItem(model, index));
+}
+
+QSet<quintptr> BinSearchIndex::matches(const QString &search, const QStringList &tags, int type, int rating) const
+{
+    // Collect the posting lists restricting the candidates, and start from the smallest one
+    QVector<const QSet<quintptr> *> postings;
+    const QSet<quintptr> empty;
+    if (rating > 0) {
+        auto it = m_ratings.constFind(rating);
+        postings << (it == m_ratings.constEnd() ? &empty : &it.value());
+    }
+    if (type > 0) {
+        auto it = m_types.constFind(type);
+        postings << (it == m_types.constEnd() ? &empty : &it.value());
+    }
+    const QString folded = search.toCaseFolded();
+    for (quint64 key : trigrams(folded)) {
+        auto it = m_trigrams.constFind(key);
+        postings << (it == m_trigrams.constEnd() ? &empty : &it.value());
+    }
+    QStringList foldedTags;
+    for (const QString &tag : tags) {
+        foldedTags << tag.toCaseFolded();
+    }
+    auto accept = [&](quintptr id, const Item &item) {
+        if ((rating > 0 && item.rating != rating) || (type > 0 && item.type != type)) {
+            return false;
+        }
+        for (const QString &tag : foldedTags) {
+            if (!item.tags.contains(tag)) {
+                return false;
+            }
+        }
+        for (const QSet<quintptr> *posting : postings) {
+            if (!posting->contains(id)) {
+                return false;
+            }
+        }
+        // Trigrams do not guarantee the order of the characters, check the string itself
+        return item.text.contains(folded);
+    };
+
+    QSet<quintptr> result;
+    auto addMatch = [&](quintptr id, const Item &item) {
+        result.insert(id);
+        const Item *current = &item;
+        while (current->hasParent && !result.contains(current->parent)) {
+            result.insert(current->parent);
+            auto parent = m_items.constFind(current->parent);
+            if (parent == m_items.constEnd()) {
+                break;
+            }
+            current = &parent.value();
+        }
+    };
+    if (postings.isEmpty()) {
+        for (auto it = m_items.constBegin(); it != m_items.constEnd(); ++it) {
+            if (accept(it.key(), it.value())) {
+                addMatch(it.key(), it.value());
+            }
+        }
+        return result;
+    }
+    const QSet<quintptr> *smallest = postings.first();
+    for (const QSet<quintptr> *posting : postings) {
+        if (posting->size() < smallest->size()) {
+            smallest = posting;
+        }
+    }
+    for (quintptr id : *smallest) {
+        auto it = m_items.constFind(id);
+        if (it != m_items.constEnd() && accept(id, it.value())) {
+            addMatch(id, it.value());
+        }
+    }
+    return result;
+}
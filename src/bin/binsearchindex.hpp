@@ -0,0 +1,79 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BINSEARCHINDEX_H
+#define BINSEARCHINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QAbstractItemModel;
+class QModelIndex;
+
+/**
+ * @class BinSearchIndex
+ * @brief Inverted index over the searchable data of the bin items (name, date, description, tags, type and rating).
+ * Items are identified by the internal id of their model index, which is unique and stable in the ProjectItemModel.
+ * Text lookups use trigram posting lists, so that a search only verifies the items that contain all the trigrams of the searched string.
+ */
+class BinSearchIndex
+{
+public:
+    /** @brief Index all the items of the model */
+    void build(const QAbstractItemModel *model);
+    void clear();
+    bool isBuilt() const;
+    /** @brief Index the item and all its children */
+    void addItems(const QAbstractItemModel *model, const QModelIndex &index);
+    /** @brief Remove the item and all its children */
+    void removeItems(const QAbstractItemModel *model, const QModelIndex &index);
+    /** @brief Read again the data of an item */
+    void updateItem(const QAbstractItemModel *model, const QModelIndex &index);
+    /** @brief Returns the ids of the items matching all the criteria, along with their ancestors so that they stay reachable.
+     *  An empty string, empty tag list, or 0 type / rating does not filter on that criteria */
+    QSet<quintptr> matches(const QString &search, const QStringList &tags, int type, int rating) const;
+
+private:
+    struct Item
+    {
+        bool hasParent;
+        quintptr parent;
+        // Case folded name, date and description
+        QString text;
+        // Case folded tags
+        QString tags;
+        int type;
+        int rating;
+    };
+    bool m_built = false;
+    QHash<quintptr, Item> m_items;
+    QHash<quint64, QSet<quintptr>> m_trigrams;
+    QHash<int, QSet<quintptr>> m_types;
+    QHash<int, QSet<quintptr>> m_ratings;
+
+    void insertItem(quintptr id, const Item &item);
+    void eraseItem(quintptr id);
+    static Item readItem(const QAbstractItemModel *model, const QModelIndex &index);
+};
+
+#endif
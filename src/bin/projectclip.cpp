@@ -33,6 +33,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "jobs/thumbjob.hpp"
 #include "jobs/cachejob.hpp"
 #include "kdenlivesettings.h"
+#include "lib/audio/audioPeakFile.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "mltcontroller/clipcontroller.h"
 #include "mltcontroller/clippropertiescontroller.h"
@@ -47,6 +48,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "timeline2/model/snapmodel.hpp"
 
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 #include "xml/xml.hpp"
 #include <QPainter>
 #include <jobs/proxyclipjob.h>
@@ -80,7 +82,6 @@ RTTR_REGISTRATION
 ProjectClip::ProjectClip(const QString &id, const QIcon &thumb, const std::shared_ptr<ProjectItemModel> &model, std::shared_ptr<Mlt::Producer> producer)
     : AbstractProjectItem(AbstractProjectItem::ClipItem, id, model)
     , ClipController(id, std::move(producer))
-    , m_thumbsProducer(nullptr)
 {
     m_markerModel = std::make_shared<MarkerListModel>(id, pCore->projectManager()->undoStack());
     m_clipStatus = StatusReady;
@@ -128,7 +129,6 @@ void ProjectClip::importEffects(const std::shared_ptr<Mlt::Producer> &producer)
 ProjectClip::ProjectClip(const QString &id, const QDomElement &description, const QIcon &thumb, const std::shared_ptr<ProjectItemModel> &model)
     : AbstractProjectItem(AbstractProjectItem::ClipItem, id, model)
     , ClipController(id)
-    , m_thumbsProducer(nullptr)
 {
     m_clipStatus = StatusWaiting;
     m_thumbnail = thumb;
@@ -166,6 +166,7 @@ ProjectClip::~ProjectClip()
     m_requestedThumbs.clear();
     m_thumbMutex.unlock();
     m_thumbThread.waitForFinished();
+    ThumbnailProducerPool::get()->invalidateClip(m_binId);
     audioFrameCache.clear();
 }
 
@@ -197,10 +198,16 @@ QString ProjectClip::getXmlProperty(const QDomElement &producer, const QString &
     return value;
 }
 
-void ProjectClip::updateAudioThumbnail(const QVector<uint8_t> audioLevels)
+void ProjectClip::updateAudioThumbnail(const QVector<uint8_t> audioLevels, bool complete)
 {
-    audioFrameCache = audioLevels;
-    m_audioThumbCreated = true;
+    m_audioPeaks = complete ? AudioPeakFile::open(getAudioThumbPath()) : nullptr;
+    if (m_audioPeaks) {
+        // Levels are read from the mapped peak file, no need to keep them in memory
+        audioFrameCache.clear();
+    } else {
+        audioFrameCache = audioLevels;
+    }
+    m_audioThumbCreated = complete;
     updateTimelineClips({TimelineModel::ReloadThumbRole});
 }
 
@@ -209,6 +216,11 @@ bool ProjectClip::audioThumbCreated() const
     return (m_audioThumbCreated);
 }
 
+std::shared_ptr<AudioPeakFile> ProjectClip::audioPeaks() const
+{
+    return m_audioPeaks;
+}
+
 ClipType::ProducerType ProjectClip::clipType() const
 {
     return m_clipType;
@@ -312,7 +324,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool audioStreamChanged, bool
         // Clear cache first
         ThumbnailCache::get()->invalidateThumbsForClip(clipId(), false);
         pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::THUMBJOB);
-        m_thumbsProducer.reset();
+        ThumbnailProducerPool::get()->invalidateClip(clipId());
         pCore->jobManager()->startJob<ThumbJob>({clipId()}, loadjobId, QString(), -1, true, true);
     } else {
         // If another load job is running?
@@ -326,7 +338,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool audioStreamChanged, bool
         QDomElement xml = toXml(doc);
         if (!xml.isNull()) {
             pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::THUMBJOB);
-            m_thumbsProducer.reset();
+            ThumbnailProducerPool::get()->invalidateClip(clipId());
             ClipType::ProducerType type = clipType();
             if (type != ClipType::Color && type != ClipType::Image && type != ClipType::SlideShow) {
                 xml.removeAttribute("out");
@@ -408,7 +420,7 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool repl
     qDebug() << "################### ProjectClip::setproducer";
     QMutexLocker locker(&m_producerMutex);
     updateProducer(producer);
-    m_thumbsProducer.reset();
+    ThumbnailProducerPool::get()->invalidateClip(clipId());
     connectEffectStack();
 
     // Update info
@@ -510,47 +522,51 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool repl
     return true;
 }
 
-std::shared_ptr<Mlt::Producer> ProjectClip::thumbProducer()
+std::shared_ptr<Mlt::Producer> ProjectClip::thumbProducer(int position)
 {
-    if (m_thumbsProducer) {
-        return m_thumbsProducer;
-    }
     if (clipType() == ClipType::Unknown) {
         return nullptr;
     }
+    return ThumbnailProducerPool::get()->checkout(clipId(), position, [this]() { return createThumbProducer(); });
+}
+
+Mlt::Producer *ProjectClip::createThumbProducer()
+{
     QMutexLocker lock(&m_thumbMutex);
     std::shared_ptr<Mlt::Producer> prod = originalProducer();
     if (!prod->is_valid()) {
         return nullptr;
     }
+    Mlt::Producer *thumbsProducer = nullptr;
     if (KdenliveSettings::gpu_accel()) {
         // TODO: when the original producer changes, we must reload this thumb producer
-        m_thumbsProducer = softClone(ClipController::getPassPropertiesList());
+        std::shared_ptr<Mlt::Producer> clone = softClone(ClipController::getPassPropertiesList());
+        thumbsProducer = new Mlt::Producer(*clone.get());
         Mlt::Filter converter(*prod->profile(), "avcolor_space");
-        m_thumbsProducer->attach(converter);
+        thumbsProducer->attach(converter);
     } else {
         QString mltService = m_masterProducer->get("mlt_service");
         const QString mltResource = m_masterProducer->get("resource");
         if (mltService == QLatin1String("avformat")) {
             mltService = QStringLiteral("avformat-novalidate");
         }
-        m_thumbsProducer.reset(new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
-        if (m_thumbsProducer->is_valid()) {
+        thumbsProducer = new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData());
+        if (thumbsProducer->is_valid()) {
             Mlt::Properties original(m_masterProducer->get_properties());
-            Mlt::Properties cloneProps(m_thumbsProducer->get_properties());
+            Mlt::Properties cloneProps(thumbsProducer->get_properties());
             cloneProps.pass_list(original, ClipController::getPassPropertiesList());
             Mlt::Filter scaler(*pCore->thumbProfile(), "swscale");
             Mlt::Filter padder(*pCore->thumbProfile(), "resize");
             Mlt::Filter converter(*pCore->thumbProfile(), "avcolor_space");
-            m_thumbsProducer->set("audio_index", -1);
+            thumbsProducer->set("audio_index", -1);
             // Required to make get_playtime() return > 1
-            m_thumbsProducer->set("out", m_thumbsProducer->get_length() -1);
-            m_thumbsProducer->attach(scaler);
-            m_thumbsProducer->attach(padder);
-            m_thumbsProducer->attach(converter);
+            thumbsProducer->set("out", thumbsProducer->get_length() -1);
+            thumbsProducer->attach(scaler);
+            thumbsProducer->attach(padder);
+            thumbsProducer->attach(converter);
         }
     }
-    return m_thumbsProducer;
+    return thumbsProducer;
 }
 
 void ProjectClip::createDisabledMasterProducer()
@@ -772,31 +788,12 @@ std::shared_ptr<Mlt::Producer> ProjectClip::timelineProducer(PlaylistState::Clip
 
 std::shared_ptr<Mlt::Producer> ProjectClip::cloneProducer(bool removeEffects)
 {
-    Mlt::Consumer c(pCore->getCurrentProfile()->profile(), "xml", "string");
-    Mlt::Service s(m_masterProducer->get_service());
-    int ignore = s.get_int("ignore_points");
-    if (ignore) {
-        s.set("ignore_points", 0);
-    }
-    c.connect(s);
-    c.set("time_format", "frames");
-    c.set("no_meta", 1);
-    c.set("no_root", 1);
-    c.set("no_profile", 1);
-    c.set("root", "/");
-    c.set("store", "kdenlive");
-    c.run();
-    if (ignore) {
-        s.set("ignore_points", ignore);
-    }
-    const QByteArray clipXml = c.get("string");
-    std::shared_ptr<Mlt::Producer> prod;
-    prod.reset(new Mlt::Producer(pCore->getCurrentProfile()->profile(), "xml-string", clipXml.constData()));
-
-    if (strcmp(prod->get("mlt_service"), "avformat") == 0) {
-        prod->set("mlt_service", "avformat-novalidate");
-        prod->set("mute_on_pause", 0);
+    std::shared_ptr<Mlt::Producer> prod = cloneProducerStructure(pCore->getCurrentProfile()->profile(), *m_masterProducer.get(), removeEffects);
+    if (prod) {
+        prod->set("id", (char *)nullptr);
+        return prod;
     }
+    prod = cloneProducerXml(pCore->getCurrentProfile()->profile(), *m_masterProducer.get());
 
     // we pass some properties that wouldn't be passed because of the novalidate
     const char *prefix = "meta.";
@@ -833,8 +830,86 @@ std::shared_ptr<Mlt::Producer> ProjectClip::cloneProducer(bool removeEffects)
 
 std::shared_ptr<Mlt::Producer> ProjectClip::cloneProducer(const std::shared_ptr<Mlt::Producer> &producer)
 {
-    Mlt::Consumer c(*producer->profile(), "xml", "string");
-    Mlt::Service s(producer->get_service());
+    std::shared_ptr<Mlt::Producer> prod = cloneProducerStructure(*producer->profile(), *producer.get(), false);
+    if (prod) {
+        return prod;
+    }
+    return cloneProducerXml(*producer->profile(), *producer.get());
+}
+
+namespace {
+// Copy the serializable properties of a service, like MLT's xml consumer would do. Returns false if a property holds data that cannot be copied as a string
+bool copyServiceProperties(Mlt::Properties &source, Mlt::Properties &dest)
+{
+    for (int i = 0; i < source.count(); ++i) {
+        const char *name = source.get_name(i);
+        if (name == nullptr || name[0] == '_' || strcmp(name, "mlt_type") == 0 || strcmp(name, "mlt_service") == 0 || strcmp(name, "id") == 0 ||
+            strcmp(name, "ignore_points") == 0) {
+            continue;
+        }
+        const char *value = source.get(i);
+        if (value == nullptr) {
+            // Data property (for example an embedded service), only the xml path can handle it
+            return false;
+        }
+        dest.set(name, value);
+    }
+    return true;
+}
+} // namespace
+
+std::shared_ptr<Mlt::Producer> ProjectClip::cloneProducerStructure(Mlt::Profile &profile, Mlt::Producer &producer, bool removeEffects)
+{
+    // Only plain services are cloned directly, others (playlists, tractors, timewarp, xml, ...) embed other services and need the xml round trip
+    static const QStringList simpleServices{QStringLiteral("avformat"), QStringLiteral("avformat-novalidate"), QStringLiteral("color"),
+                                            QStringLiteral("colour"), QStringLiteral("qimage"), QStringLiteral("pixbuf"), QStringLiteral("kdenlivetitle"),
+                                            QStringLiteral("qtext"), QStringLiteral("blipflash")};
+    QString service = QString::fromLatin1(producer.get("mlt_service"));
+    if (!simpleServices.contains(service) || producer.type() != mlt_service_producer_type) {
+        return nullptr;
+    }
+    if (service == QLatin1String("avformat")) {
+        service = QStringLiteral("avformat-novalidate");
+    }
+    std::shared_ptr<Mlt::Producer> prod(new Mlt::Producer(profile, service.toUtf8().constData(), producer.get("resource")));
+    if (!prod->is_valid()) {
+        return nullptr;
+    }
+    Mlt::Properties sourceProps(producer.get_properties());
+    Mlt::Properties cloneProps(prod->get_properties());
+    if (!copyServiceProperties(sourceProps, cloneProps)) {
+        return nullptr;
+    }
+    if (service == QLatin1String("avformat-novalidate")) {
+        prod->set("mute_on_pause", 0);
+    }
+    // Filters, the loader normalizers are not copied, like in MLT's xml consumer
+    for (int i = 0; i < producer.filter_count(); ++i) {
+        std::unique_ptr<Mlt::Filter> filter(producer.filter(i));
+        if (!filter || !filter->is_valid() || filter->get_int("_loader") == 1) {
+            continue;
+        }
+        if (removeEffects && !QString::fromLatin1(filter->get("kdenlive_id")).isEmpty()) {
+            continue;
+        }
+        Mlt::Filter copy(profile, filter->get("mlt_service"));
+        if (!copy.is_valid()) {
+            return nullptr;
+        }
+        Mlt::Properties filterProps(filter->get_properties());
+        Mlt::Properties copyProps(copy.get_properties());
+        if (!copyServiceProperties(filterProps, copyProps)) {
+            return nullptr;
+        }
+        prod->attach(copy);
+    }
+    return prod;
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::cloneProducerXml(Mlt::Profile &profile, Mlt::Producer &producer)
+{
+    Mlt::Consumer c(profile, "xml", "string");
+    Mlt::Service s(producer.get_service());
     int ignore = s.get_int("ignore_points");
     if (ignore) {
         s.set("ignore_points", 0);
@@ -846,12 +921,12 @@ std::shared_ptr<Mlt::Producer> ProjectClip::cloneProducer(const std::shared_ptr<
     c.set("no_profile", 1);
     c.set("root", "/");
     c.set("store", "kdenlive");
-    c.start();
+    c.run();
     if (ignore) {
         s.set("ignore_points", ignore);
     }
     const QByteArray clipXml = c.get("string");
-    std::shared_ptr<Mlt::Producer> prod(new Mlt::Producer(*producer->profile(), "xml-string", clipXml.constData()));
+    std::shared_ptr<Mlt::Producer> prod(new Mlt::Producer(profile, "xml-string", clipXml.constData()));
     if (strcmp(prod->get("mlt_service"), "avformat") == 0) {
         prod->set("mlt_service", "avformat-novalidate");
         prod->set("mute_on_pause", 0);
@@ -1243,6 +1318,8 @@ int ProjectClip::audioChannels() const
 
 void ProjectClip::discardAudioThumb()
 {
+    // Release the mapping before deleting the file
+    m_audioPeaks.reset();
     QString audioThumbPath = getAudioThumbPath();
     if (!audioThumbPath.isEmpty()) {
         QFile::remove(audioThumbPath);
@@ -1278,7 +1355,7 @@ const QString ProjectClip::getAudioThumbPath(bool miniThumb)
         audioPath.append(QLatin1Char('_') + QString::number(audioInfo()->audio_index()));
     }
     int roundedFps = (int)pCore->getCurrentFps();
-    audioPath.append(QStringLiteral("_%1_audio.png").arg(roundedFps));
+    audioPath.append(QStringLiteral("_%1_audio.peaks").arg(roundedFps));
     return audioPath;
 }
 
@@ -32,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMutex>
 #include <memory>
 
+class AudioPeakFile;
 class ClipPropertiesController;
 class ProjectFolder;
 class ProjectSubClip;
@@ -149,8 +150,9 @@ public:
     /** @brief Returns true if this clip already has a producer. */
     bool isReady() const;
 
-    /** @brief Returns this clip's producer. */
-    std::shared_ptr<Mlt::Producer> thumbProducer();
+    /** @brief Returns a producer for thumbnail extraction, taken from the thumbnail producer pool and returned to it when released.
+     *  @param position the first frame that will be extracted, used to pick the producer that can reach it without seeking */
+    std::shared_ptr<Mlt::Producer> thumbProducer(int position = -1);
 
     /** @brief Recursively disable/enable bin effects. */
     void setBinEffectsEnabled(bool enabled) override;
@@ -171,8 +173,11 @@ public:
 
     /** Cache for every audio Frame with 10 Bytes */
     /** format is frame -> channel ->bytes */
+    /** Only filled while the audio thumbnail is computed or if its peak file could not be written, see audioPeaks() */
     QVector<uint8_t> audioFrameCache;
     bool audioThumbCreated() const;
+    /** @brief Returns the memory mapped multi resolution audio levels of this clip, or nullptr if they are not available */
+    std::shared_ptr<AudioPeakFile> audioPeaks() const;
 
     void setWaitingStatus(const QString &id);
     /** @brief Returns true if the clip matched a condition, for example vcodec=mpeg1video. */
@@ -249,8 +254,8 @@ protected:
 
 public slots:
     /* @brief Store the audio thumbnails once computed. Note that the parameter is a value and not a reference, fill free to use it as a sink (use std::move to
-     * avoid copy). */
-    void updateAudioThumbnail(const QVector<uint8_t> audioLevels);
+     * avoid copy). If @param complete is false, the levels only cover the beginning of the clip and the thumbnail job is still running. */
+    void updateAudioThumbnail(const QVector<uint8_t> audioLevels, bool complete = true);
     /** @brief Delete the proxy file */
     void deleteProxy();
 
@@ -260,16 +265,25 @@ public slots:
 private:
     /** @brief Generate and store file hash if not available. */
     const QString getFileHash();
-    std::shared_ptr<Mlt::Producer> m_thumbsProducer;
+    std::shared_ptr<AudioPeakFile> m_audioPeaks;
     QMutex m_producerMutex;
     QMutex m_thumbMutex;
     QFuture<void> m_thumbThread;
     QList<int> m_requestedThumbs;
     const QString geometryWithOffset(const QString &data, int offset);
+    /** @brief Build a new producer for thumbnail extraction */
+    Mlt::Producer *createThumbProducer();
 
     // This is a helper function that creates the disabled producer. This is a clone of the original one, with audio and video disabled
     void createDisabledMasterProducer();
 
+    /** @brief Clones a producer by creating the same service and copying its properties and filters, without going through MLT's xml serialization.
+        Returns nullptr if the producer uses a service that cannot be safely cloned this way, in which case cloneProducerXml should be used.
+        @param removeEffects if true, the filters added by Kdenlive (with a kdenlive_id) are not copied */
+    static std::shared_ptr<Mlt::Producer> cloneProducerStructure(Mlt::Profile &profile, Mlt::Producer &producer, bool removeEffects);
+    /** @brief Clones a producer by serializing it with MLT's xml consumer and loading it back */
+    static std::shared_ptr<Mlt::Producer> cloneProducerXml(Mlt::Profile &profile, Mlt::Producer &producer);
+
     std::map<int, std::weak_ptr<TimelineModel>> m_registeredClips;
 
     // the following holds a producer for each audio clip in the timeline
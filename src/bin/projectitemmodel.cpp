@@ -375,11 +375,9 @@ std::shared_ptr<ProjectClip> ProjectItemModel::getClipByBinID(const QString &bin
     if (binId.contains(QLatin1Char('_'))) {
         return getClipByBinID(binId.section(QLatin1Char('_'), 0, 0));
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c);
-        }
+    auto c = lookupBinId(binId);
+    if (c && c->itemType() == AbstractProjectItem::ClipItem) {
+        return std::static_pointer_cast<ProjectClip>(c);
     }
     return nullptr;
 }
@@ -390,15 +388,26 @@ const QVector<uint8_t> ProjectItemModel::getAudioLevelsByBinID(const QString &bi
     if (binId.contains(QLatin1Char('_'))) {
         return getAudioLevelsByBinID(binId.section(QLatin1Char('_'), 0, 0));
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c)->audioFrameCache;
-        }
+    auto c = lookupBinId(binId);
+    if (c && c->itemType() == AbstractProjectItem::ClipItem) {
+        return std::static_pointer_cast<ProjectClip>(c)->audioFrameCache;
     }
     return QVector<uint8_t>();
 }
 
+std::shared_ptr<AudioPeakFile> ProjectItemModel::getAudioPeaksByBinID(const QString &binId)
+{
+    READ_LOCK();
+    if (binId.contains(QLatin1Char('_'))) {
+        return getAudioPeaksByBinID(binId.section(QLatin1Char('_'), 0, 0));
+    }
+    auto c = lookupBinId(binId);
+    if (c && c->itemType() == AbstractProjectItem::ClipItem) {
+        return std::static_pointer_cast<ProjectClip>(c)->audioPeaks();
+    }
+    return nullptr;
+}
+
 bool ProjectItemModel::hasClip(const QString &binId)
 {
     READ_LOCK();
@@ -408,11 +417,9 @@ bool ProjectItemModel::hasClip(const QString &binId)
 std::shared_ptr<ProjectFolder> ProjectItemModel::getFolderByBinId(const QString &binId)
 {
     READ_LOCK();
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::FolderItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectFolder>(c);
-        }
+    auto c = lookupBinId(binId);
+    if (c && c->itemType() == AbstractProjectItem::FolderItem) {
+        return std::static_pointer_cast<ProjectFolder>(c);
     }
     return nullptr;
 }
@@ -432,13 +439,20 @@ const QString ProjectItemModel::getFolderIdByName(const QString &folderName)
 std::shared_ptr<AbstractProjectItem> ProjectItemModel::getItemByBinId(const QString &binId)
 {
     READ_LOCK();
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->clipId() == binId) {
-            return c;
-        }
+    return lookupBinId(binId);
+}
+
+std::shared_ptr<AbstractProjectItem> ProjectItemModel::lookupBinId(const QString &binId) const
+{
+    auto it = m_binIdIndex.find(binId);
+    if (it == m_binIdIndex.end()) {
+        return nullptr;
     }
-    return nullptr;
+    auto item = m_allItems.find(it->second);
+    if (item == m_allItems.end()) {
+        return nullptr;
+    }
+    return std::static_pointer_cast<AbstractProjectItem>(item->second.lock());
 }
 
 void ProjectItemModel::setBinEffectsEnabled(bool enabled)
@@ -594,6 +608,7 @@ void ProjectItemModel::registerItem(const std::shared_ptr<TreeItem> &item)
     auto clip = std::static_pointer_cast<AbstractProjectItem>(item);
     m_binPlaylist->manageBinItemInsertion(clip);
     AbstractTreeModel::registerItem(item);
+    m_binIdIndex[clip->clipId()] = item->getId();
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = std::static_pointer_cast<ProjectClip>(clip);
         updateWatcher(clipItem);
@@ -606,6 +621,10 @@ void ProjectItemModel::deregisterItem(int id, TreeItem *item)
     m_binPlaylist->manageBinItemDeletion(clip);
     // TODO : here, we should suspend jobs belonging to the item we delete. They can be restarted if the item is reinserted by undo
     AbstractTreeModel::deregisterItem(id, item);
+    auto indexed = m_binIdIndex.find(clip->clipId());
+    if (indexed != m_binIdIndex.end() && indexed->second == id) {
+        m_binIdIndex.erase(indexed);
+    }
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = static_cast<ProjectClip *>(clip);
         m_fileWatcher->removeFile(clipItem->clipId());
@@ -947,13 +966,7 @@ bool ProjectItemModel::isIdFree(const QString &id) const
     if (id.isEmpty()) {
         return false;
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->clipId() == id) {
-            return false;
-        }
-    }
-    return true;
+    return m_binIdIndex.count(id) == 0;
 }
 
 void ProjectItemModel::loadBinPlaylist(Mlt::Tractor *documentTractor, Mlt::Tractor *modelTractor, std::unordered_map<QString, QString> &binIdCorresp, QProgressDialog *progressDialog)
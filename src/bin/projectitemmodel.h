@@ -34,6 +34,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSize>
 
 class AbstractProjectItem;
+class AudioPeakFile;
 class BinPlaylist;
 class FileWatcher;
 class MarkerListModel;
@@ -69,6 +70,8 @@ public:
     std::shared_ptr<ProjectClip> getClipByBinID(const QString &binId);
     /** @brief Returns audio levels for a clip from its id */
     const QVector <uint8_t>getAudioLevelsByBinID(const QString &binId);
+    /** @brief Returns the multi resolution audio levels for a clip from its id, nullptr if not available */
+    std::shared_ptr<AudioPeakFile> getAudioPeaksByBinID(const QString &binId);
 
     /** @brief Returns a list of clips using the given url */
     QStringList getClipByUrl(const QFileInfo &url) const;
@@ -240,6 +243,8 @@ public slots:
 private:
     /** @brief Return reference to column specific data */
     int mapToColumn(int column) const;
+    /** @brief Returns the registered item with the given bin id, or nullptr. Caller must hold m_lock */
+    std::shared_ptr<AbstractProjectItem> lookupBinId(const QString &binId) const;
 
     mutable QReadWriteLock m_lock; // This is a lock that ensures safety in case of concurrent access
 
@@ -247,6 +252,9 @@ private:
 
     std::unique_ptr<FileWatcher> m_fileWatcher;
 
+    /** @brief Index of the registered items, from their bin id to their tree item id. Kept in sync by registerItem / deregisterItem */
+    std::unordered_map<QString, int> m_binIdIndex;
+
     int m_nextId;
     QIcon m_blankThumb;
     PlaylistState::ClipState m_dragType;
@@ -28,6 +28,7 @@ ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
     , m_searchType(0)
     , m_searchRating(0)
+    , m_acceptedDirty(true)
 {
     m_collator.setLocale(QLocale());
     m_collator.setCaseSensitivity(Qt::CaseInsensitive);
@@ -37,80 +38,126 @@ ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
     setDynamicSortFilter(true);
 }
 
-// Responsible for item sorting!
-bool ProjectSortProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+void ProjectSortProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
 {
-    if (filterAcceptsRowItself(sourceRow, sourceParent)) {
-        return true;
+    for (const auto &connection : m_sourceConnections) {
+        disconnect(connection);
     }
-    // accept if any of the children is accepted on it's own merits
-    return hasAcceptedChildren(sourceRow, sourceParent);
+    m_sourceConnections.clear();
+    m_index.clear();
+    m_acceptedDirty = true;
+    // Connect before QSortFilterProxyModel does, so that the index is up to date when the rows are filtered again
+    if (sourceModel) {
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &ProjectSortProxyModel::onRowsInserted);
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &ProjectSortProxyModel::onRowsAboutToBeRemoved);
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::dataChanged, this, &ProjectSortProxyModel::onSourceDataChanged);
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::rowsMoved, this, &ProjectSortProxyModel::onStructureChanged);
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::layoutChanged, this, &ProjectSortProxyModel::onStructureChanged);
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::modelReset, this, &ProjectSortProxyModel::onStructureChanged);
+    }
+    QSortFilterProxyModel::setSourceModel(sourceModel);
 }
 
-bool ProjectSortProxyModel::filterAcceptsRowItself(int sourceRow, const QModelIndex &sourceParent) const
+void ProjectSortProxyModel::onRowsInserted(const QModelIndex &parent, int first, int last)
 {
-    if (m_searchRating > 0) {
-        // Column 7 contains the rating
-        QModelIndex indexTag = sourceModel()->index(sourceRow, 7, sourceParent);
-        if (sourceModel()->data(indexTag).toInt() != m_searchRating) {
-            return false;
-        }
+    if (!m_index.isBuilt()) {
+        m_acceptedDirty = true;
+        return;
     }
-    if (m_searchType > 0) {
-        // Column 3 contains the item type (video, image, title, etc)
-        QModelIndex indexTag = sourceModel()->index(sourceRow, 3, sourceParent);
-        if (sourceModel()->data(indexTag).toInt() != m_searchType) {
-            return false;
-        }
+    QSet<quintptr> ids;
+    for (int i = first; i <= last; ++i) {
+        QModelIndex ix = sourceModel()->index(i, 0, parent);
+        m_index.addItems(sourceModel(), ix);
+        ids.insert(ix.internalId());
     }
-    if (!m_searchTag.isEmpty()) {
-        // Column 4 contains the item tag data
-        QModelIndex indexTag = sourceModel()->index(sourceRow, 4, sourceParent);
-        auto tagData = sourceModel()->data(indexTag);
-        for (const QString &tag : m_searchTag) {
-            if (!tagData.toString().contains(tag, Qt::CaseInsensitive)) {
-                return false;
-            }
-        }
+    updateAccepted(ids);
+}
+
+void ProjectSortProxyModel::onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (!m_index.isBuilt()) {
+        m_acceptedDirty = true;
+        return;
     }
-    
-    for (int i = 0; i < 3; i++) {
-        QModelIndex index0 = sourceModel()->index(sourceRow, i, sourceParent);
-        if (!index0.isValid()) {
-            return false;
-        }
-        auto data = sourceModel()->data(index0);
-        if (data.toString().contains(m_searchString, Qt::CaseInsensitive)) {
-            return true;
-        }
+    QSet<quintptr> ids;
+    for (int i = first; i <= last; ++i) {
+        QModelIndex ix = sourceModel()->index(i, 0, parent);
+        m_index.removeItems(sourceModel(), ix);
+        ids.insert(ix.internalId());
     }
-    
-    return false;
+    updateAccepted(ids);
 }
 
-bool ProjectSortProxyModel::hasAcceptedChildren(int sourceRow, const QModelIndex &source_parent) const
+void ProjectSortProxyModel::onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
 {
-    QModelIndex item = sourceModel()->index(sourceRow, 0, source_parent);
-    if (!item.isValid()) {
-        return false;
+    if (!m_index.isBuilt()) {
+        return;
+    }
+    // Jobs and thumbnails update the items all the time, only the searchable data matters
+    static const QVector<int> searchRoles{Qt::DisplayRole, Qt::EditRole, AbstractProjectItem::DataDate, AbstractProjectItem::DataDescription,
+                                          AbstractProjectItem::DataTag, AbstractProjectItem::DataRating, AbstractProjectItem::ClipType, AbstractProjectItem::ClipStatus};
+    bool relevant = roles.isEmpty();
+    for (int role : roles) {
+        if (searchRoles.contains(role)) {
+            relevant = true;
+            break;
+        }
+    }
+    if (!relevant) {
+        return;
+    }
+    QSet<quintptr> ids;
+    for (int i = topLeft.row(); i <= bottomRight.row(); ++i) {
+        QModelIndex ix = sourceModel()->index(i, 0, topLeft.parent());
+        m_index.updateItem(sourceModel(), ix);
+        ids.insert(ix.internalId());
     }
+    updateAccepted(ids);
+}
 
-    // check if there are children
-    int childCount = item.model()->rowCount(item);
-    if (childCount == 0) {
-        return false;
+void ProjectSortProxyModel::updateAccepted(const QSet<quintptr> &changedIds)
+{
+    if (!isFiltering()) {
+        m_acceptedDirty = true;
+        return;
     }
+    QSet<quintptr> accepted = m_index.matches(m_searchString, m_searchTag, m_searchType, m_searchRating);
+    // QSortFilterProxyModel filters the changed rows again, but not their parent folders
+    QSet<quintptr> changed = (accepted - m_accepted) + (m_accepted - accepted);
+    m_accepted = accepted;
+    m_acceptedDirty = false;
+    if (!(changed - changedIds).isEmpty()) {
+        invalidateFilter();
+    }
+}
 
-    for (int i = 0; i < childCount; ++i) {
-        if (filterAcceptsRowItself(i, item)) {
-            return true;
-        }
-        // recursive call -> NOTICE that this is depth-first searching, you're probably better off with breadth first search...
-        if (hasAcceptedChildren(i, item)) {
-            return true;
+void ProjectSortProxyModel::onStructureChanged()
+{
+    m_index.clear();
+    m_acceptedDirty = true;
+}
+
+bool ProjectSortProxyModel::isFiltering() const
+{
+    return !m_searchString.isEmpty() || !m_searchTag.isEmpty() || m_searchType > 0 || m_searchRating > 0;
+}
+
+// Responsible for item sorting!
+bool ProjectSortProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (!isFiltering()) {
+        return true;
+    }
+    if (m_acceptedDirty) {
+        if (!m_index.isBuilt()) {
+            m_index.build(sourceModel());
         }
+        // Items matching on their own merits and all their parent folders
+        m_accepted = m_index.matches(m_searchString, m_searchTag, m_searchType, m_searchRating);
+        m_acceptedDirty = false;
     }
-    return false;
+    QModelIndex item = sourceModel()->index(sourceRow, 0, sourceParent);
+    return item.isValid() && m_accepted.contains(item.internalId());
 }
 
 bool ProjectSortProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
@@ -141,6 +188,7 @@ QItemSelectionModel *ProjectSortProxyModel::selectionModel()
 void ProjectSortProxyModel::slotSetSearchString(const QString &str)
 {
     m_searchString = str;
+    m_acceptedDirty = true;
     invalidateFilter();
 }
 
@@ -149,6 +197,7 @@ void ProjectSortProxyModel::slotSetFilters(const QStringList tagFilters, const i
     m_searchType = typeFilters;
     m_searchRating = rateFilters;
     m_searchTag = tagFilters;
+    m_acceptedDirty = true;
     invalidateFilter();
 }
 
@@ -157,6 +206,7 @@ void ProjectSortProxyModel::slotClearSearchFilters()
     m_searchTag.clear();
     m_searchRating = 0;
     m_searchType = 0;
+    m_acceptedDirty = true;
     invalidateFilter();
 }
 
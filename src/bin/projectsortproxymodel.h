@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PROJECTSORTPROXYMODEL_H
 #define PROJECTSORTPROXYMODEL_H
 
+#include "binsearchindex.hpp"
+
 #include <QCollator>
 #include <QSortFilterProxyModel>
 
@@ -39,6 +41,8 @@ class ProjectSortProxyModel : public QSortFilterProxyModel
 public:
     explicit ProjectSortProxyModel(QObject *parent = nullptr);
     QItemSelectionModel *selectionModel();
+    /** @brief Reimplemented to keep the search index in sync with the model */
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
 
 public slots:
     /** @brief Set search string that will filter the view */
@@ -62,8 +66,6 @@ protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
     /** @brief Reimplemented to show folders first  */
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
-    bool filterAcceptsRowItself(int source_row, const QModelIndex &source_parent) const;
-    bool hasAcceptedChildren(int source_row, const QModelIndex &source_parent) const;
 
 private:
     QItemSelectionModel *m_selection;
@@ -72,6 +74,20 @@ private:
     int m_searchType;
     int m_searchRating;
     QCollator m_collator;
+    /** @brief Index of the source model items, built on first search and then updated with the model changes */
+    mutable BinSearchIndex m_index;
+    /** @brief Ids of the items accepted by the current filters */
+    mutable QSet<quintptr> m_accepted;
+    mutable bool m_acceptedDirty;
+    QVector<QMetaObject::Connection> m_sourceConnections;
+    bool isFiltering() const;
+    /** @brief Update the search index before the proxy processes the source model changes */
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+    void onStructureChanged();
+    /** @brief Compute the accepted items after a change of the given items, and filter again if a parent folder changed */
+    void updateAccepted(const QSet<quintptr> &changedIds);
 
 signals:
     /** @brief Emitted when the row changes, used to prepare action for selected item  */
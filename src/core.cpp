@@ -36,6 +36,7 @@ the Free Software Foundation, either version 3 of the License, or
 #include <QCoreApplication>
 #include <QInputDialog>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QQuickStyle>
 #include <locale>
 #ifdef Q_OS_MAC
@@ -75,6 +76,8 @@ void Core::build(bool isAppImage, const QString &MltPath)
     if (m_self) {
         return;
     }
+    QElapsedTimer timer;
+    timer.start();
     m_self.reset(new Core());
     m_self->initLocale();
 
@@ -100,9 +103,11 @@ void Core::build(bool isAppImage, const QString &MltPath)
         // Open connection with Mlt
         MltConnection::construct(MltPath);
     }
+    qCDebug(KDENLIVE_LOG) << "Startup timing: MLT initialized in" << timer.restart() << "ms";
 
     // load the profile from disk
     ProfileRepository::get()->refresh();
+    qCDebug(KDENLIVE_LOG) << "Startup timing: profiles loaded in" << timer.restart() << "ms";
     // load default profile
     m_self->m_profile = KdenliveSettings::default_profile();
     if (m_self->m_profile.isEmpty()) {
@@ -118,14 +123,19 @@ void Core::build(bool isAppImage, const QString &MltPath)
     m_self->m_projectItemModel = ProjectItemModel::construct();
     // Job manager must be created before bin to correctly connect
     m_self->m_jobManager.reset(new JobManager(m_self.get()));
+    qCDebug(KDENLIVE_LOG) << "Startup timing: core models built in" << timer.elapsed() << "ms";
 }
 
 void Core::initGUI(const QUrl &Url, const QString &clipsToLoad)
 {
+    QElapsedTimer timer;
+    timer.start();
     m_profile = KdenliveSettings::default_profile();
     m_currentProfile = m_profile;
     profileChanged();
+    // Also loads the effects and transitions repositories
     m_mainWindow = new MainWindow();
+    qCDebug(KDENLIVE_LOG) << "Startup timing: main window created in" << timer.restart() << "ms";
     m_guiConstructed = true;
     QStringList styles = QQuickStyle::availableStyles();
     if (styles.contains(QLatin1String("org.kde.desktop"))) {
@@ -186,6 +196,7 @@ void Core::initGUI(const QUrl &Url, const QString &clipsToLoad)
     connect(m_mixerWidget, &MixerManager::updateRecVolume, m_capture.get(), &MediaCapture::setAudioVolume);
     m_monitorManager = new MonitorManager(this);
     connect(m_monitorManager, &MonitorManager::cleanMixer, m_mixerWidget, &MixerManager::clearMixers);
+    qCDebug(KDENLIVE_LOG) << "Startup timing: bin, library, mixer and monitors created in" << timer.restart() << "ms";
     // Producer queue, creating MLT::Producers on request
     /*
     m_producerQueue = new ProducerQueue(m_binController);
@@ -201,6 +212,7 @@ void Core::initGUI(const QUrl &Url, const QString &clipsToLoad)
     connect(m_producerQueue, SIGNAL(removeInvalidProxy(QString,bool)), m_binWidget, SLOT(slotRemoveInvalidProxy(QString,bool)));*/
 
     m_mainWindow->init();
+    qCDebug(KDENLIVE_LOG) << "Startup timing: main window initialized in" << timer.restart() << "ms";
     projectManager()->init(Url, clipsToLoad);
     if (qApp->isSessionRestored()) {
         // NOTE: we are restoring only one window, because Kdenlive only uses one MainWindow
@@ -208,6 +220,7 @@ void Core::initGUI(const QUrl &Url, const QString &clipsToLoad)
     }
     QMetaObject::invokeMethod(pCore->projectManager(), "slotLoadOnOpen", Qt::QueuedConnection);
     m_mainWindow->show();
+    qCDebug(KDENLIVE_LOG) << "Startup timing: project manager ready and window shown in" << timer.elapsed() << "ms";
     QThreadPool::globalInstance()->setMaxThreadCount(qMin(4, QThreadPool::globalInstance()->maxThreadCount()));
 }
 
@@ -605,9 +618,11 @@ void Core::profileChanged()
     GenTime::setFps(getCurrentFps());
 }
 
-void Core::pushUndo(const Fun &undo, const Fun &redo, const QString &text)
+void Core::pushUndo(const Fun &undo, const Fun &redo, const QString &text, qint64 sizeHint)
 {
-    undoStack()->push(new FunctionalUndoCommand(undo, redo, text));
+    auto *command = new FunctionalUndoCommand(undo, redo, text);
+    command->setSizeHint(sizeHint);
+    undoStack()->push(command);
 }
 
 void Core::pushUndo(QUndoCommand *command)
@@ -151,8 +151,9 @@ public:
     void profileChanged();
 
     /** @brief Create and push and undo object based on the corresponding functions
-        Note that if you class permits and requires it, you should use the macro PUSH_UNDO instead*/
-    void pushUndo(const Fun &undo, const Fun &redo, const QString &text);
+        Note that if you class permits and requires it, you should use the macro PUSH_UNDO instead
+        @param sizeHint is the memory, in bytes, captured by the functions when it is known (0 otherwise) */
+    void pushUndo(const Fun &undo, const Fun &redo, const QString &text, qint64 sizeHint = 0);
     void pushUndo(QUndoCommand *command);
     /** @brief display a user info/warning message in statusbar */
     void displayMessage(const QString &message, MessageType type, int timeout = -1);
@@ -34,10 +34,12 @@
 
 #include "klocalizedstring.h"
 #include <KColorScheme>
+#include <KConfigGroup>
 #include <KIO/DesktopExecParser>
 #include <KMessageBox>
 #include <KNotification>
 #include <KRun>
+#include <KSharedConfig>
 #include <kio_version.h>
 #include <knotifications_version.h>
 #include <kns3/downloaddialog.h>
@@ -50,6 +52,7 @@
 #include <QHeaderView>
 #include <QInputDialog>
 #include <QJsonArray>
+#include <QJsonDocument>
 #include <QJsonObject>
 #include <QKeyEvent>
 #include <QMimeDatabase>
@@ -60,6 +63,7 @@
 #include <QTreeWidgetItem>
 #include <qglobal.h>
 #include <qstring.h>
+#include <QActionGroup>
 #include <QMenu>
 
 #ifdef KF5_USE_PURPOSE
@@ -95,9 +99,10 @@ const int ParametersRole = Qt::UserRole + 1;
 const int TimeRole = Qt::UserRole + 2;
 const int ProgressRole = Qt::UserRole + 3;
 const int ExtraInfoRole = Qt::UserRole + 5;
+const int PriorityRole = Qt::UserRole + 6;
 
-// Running job status
-enum JOBSTATUS { WAITINGJOB = 0, STARTINGJOB, RUNNINGJOB, FINISHEDJOB, FAILEDJOB, ABORTEDJOB };
+// Waiting jobs with a lower value are started first
+enum JOBPRIORITY { HIGHPRIORITY = 0, NORMALPRIORITY, LOWPRIORITY };
 
 static QStringList acodecsList;
 static QStringList vcodecsList;
@@ -108,6 +113,7 @@ RenderJobItem::RenderJobItem(QTreeWidget *parent, const QStringList &strings, in
     , m_status(-1)
 {
     setSizeHint(1, QSize(parent->columnWidth(1), parent->fontMetrics().height() * 3));
+    setData(1, PriorityRole, NORMALPRIORITY);
     setStatus(WAITINGJOB);
 }
 
@@ -356,10 +362,18 @@ RenderWidget::RenderWidget(bool enableProxy, QWidget *parent)
 #endif
     m_view.parallel_process->setChecked(KdenliveSettings::parallelrender());
     connect(m_view.parallel_process, &QCheckBox::stateChanged, [](int state) { KdenliveSettings::setParallelrender(state == Qt::Checked); });
+    m_view.segmented_render->setChecked(KdenliveSettings::segmentedrender());
+    connect(m_view.segmented_render, &QCheckBox::stateChanged, [](int state) { KdenliveSettings::setSegmentedrender(state == Qt::Checked); });
     if (KdenliveSettings::gpu_accel()) {
         // Disable parallel rendering for movit
         m_view.parallel_process->setEnabled(false);
+        m_view.segmented_render->setEnabled(false);
     }
+    m_view.concurrent_jobs->setValue(KdenliveSettings::concurrentrenders());
+    connect(m_view.concurrent_jobs, QOverload<int>::of(&QSpinBox::valueChanged), [this](int value) {
+        KdenliveSettings::setConcurrentrenders(value);
+        checkRenderStatus();
+    });
     m_view.field_order->setEnabled(false);
 #if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
     connect(m_view.scanning_list, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) { m_view.field_order->setEnabled(index == 2); });
@@ -369,6 +383,7 @@ RenderWidget::RenderWidget(bool enableProxy, QWidget *parent)
     refreshView();
     focusFirstVisibleItem();
     adjustSize();
+    loadRenderQueue();
 }
 
 void RenderWidget::slotShareActionFinished(const QJsonObject &output, int error, const QString &message)
@@ -1594,6 +1609,15 @@ void RenderWidget::generateRenderFiles(QDomDocument doc, const QString &playlist
         file.close();
     }
 
+    // Segmented rendering: each melt process renders a GOP aligned part of the range, kdenlive_render joins them with ffmpeg
+    QStringList segmentArgs;
+    // Image sequences cannot be joined
+    if (passes == 1 && m_view.segmented_render->isChecked() && m_view.segmented_render->isEnabled() && !renderedFile.contains(QLatin1Char('%')) &&
+        !KdenliveSettings::ffmpegpath().isEmpty()) {
+        int segments = qBound(2, QThread::idealThreadCount() / qMax(2, threadCount), 8);
+        segmentArgs = {QStringLiteral("-segments:%1").arg(segments), QStringLiteral("-ffmpeg:%1").arg(KdenliveSettings::ffmpegpath())};
+    }
+
     // Create job
     RenderJobItem *renderItem = nullptr;
     QList<QTreeWidgetItem *> existing = m_view.running_jobs->findItems(renderedFile, Qt::MatchExactly, 1);
@@ -1615,6 +1639,7 @@ void RenderWidget::generateRenderFiles(QDomDocument doc, const QString &playlist
             renderItem->setData(1, Qt::UserRole, i18n("Waiting..."));
             QStringList argsJob = {KdenliveSettings::rendererpath(), playlistPath, renderedFile,
                                    QStringLiteral("-pid:%1").arg(QCoreApplication::applicationPid())};
+            argsJob << segmentArgs;
             renderItem->setData(1, ParametersRole, argsJob);
             renderItem->setData(1, TimeRole, QDateTime::currentDateTime());
             if (!exportAudio) {
@@ -1637,6 +1662,7 @@ void RenderWidget::generateRenderFiles(QDomDocument doc, const QString &playlist
         renderItem = new RenderJobItem(m_view.running_jobs, QStringList() << QString() << renderedFile);
         renderItem->setData(1, TimeRole, QDateTime::currentDateTime());
         QStringList argsJob = {KdenliveSettings::rendererpath(), pl, renderedFile, QStringLiteral("-pid:%1").arg(QCoreApplication::applicationPid())};
+        argsJob << segmentArgs;
         renderItem->setData(1, ParametersRole, argsJob);
         qDebug() << "* CREATED JOB WITH ARGS: " << argsJob;
         if (!exportAudio) {
@@ -1690,54 +1716,71 @@ void RenderWidget::checkRenderStatus()
     if (m_blockProcessing) {
         return;
     }
-
-    auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
-
-    // Make sure no other rendering is running
-    while (item != nullptr) {
-        if (item->status() == RUNNINGJOB) {
+    int maxJobs = qMax(1, KdenliveSettings::concurrentrenders());
+    while (true) {
+        // Count running jobs, a job cannot start while a job above it writes the same file (two pass encoding)
+        int running = 0;
+        bool waitingJob = false;
+        QStringList busyFiles;
+        RenderJobItem *next = nullptr;
+        auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
+        while (item != nullptr) {
+            if (item->status() == RUNNINGJOB || item->status() == STARTINGJOB) {
+                running++;
+                busyFiles << item->text(1);
+            }
+            item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
+        }
+        item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
+        while (item != nullptr) {
+            if (item->status() == WAITINGJOB) {
+                waitingJob = true;
+                if (!busyFiles.contains(item->text(1)) && (next == nullptr || item->data(1, PriorityRole).toInt() < next->data(1, PriorityRole).toInt())) {
+                    next = item;
+                }
+                busyFiles << item->text(1);
+            }
+            item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
+        }
+        if (running >= maxJobs || next == nullptr) {
+            // Save once the started jobs left the waiting state, they must not be restored in the next session
+            saveRenderQueue(m_view.running_jobs);
+            if (running == 0 && !waitingJob && m_view.shutdown->isChecked()) {
+                emit shutdown();
+            }
             return;
         }
-        item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
-    }
-    item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
-    bool waitingJob = false;
-
-    // Find first waiting job
-    while (item != nullptr) {
-        if (item->status() == WAITINGJOB) {
-            item->setData(1, TimeRole, QDateTime::currentDateTime());
-            waitingJob = true;
-            startRendering(item);
-            // Check for 2 pass encoding
-            QStringList jobData = item->data(1, ParametersRole).toStringList();
-            if (jobData.size() > 2 && jobData.at(1).endsWith(QStringLiteral("-pass2.mlt"))) {
-                // Find and remove 1st pass job
-                QTreeWidgetItem *above = m_view.running_jobs->itemAbove(item);
-                QString firstPassName = jobData.at(1).section(QLatin1Char('-'), 0, -2) + QStringLiteral(".mlt");
-                while (above) {
-                    QStringList aboveData = above->data(1, ParametersRole).toStringList();
-                    qDebug() << "// GOT  JOB: " << aboveData.at(1);
-                    if (aboveData.size() > 2 && aboveData.at(1) == firstPassName) {
-                        delete above;
-                        break;
-                    }
-                    above = m_view.running_jobs->itemAbove(above);
+        item = next;
+        item->setData(1, TimeRole, QDateTime::currentDateTime());
+        startRendering(item);
+        // Check for 2 pass encoding
+        QStringList jobData = item->data(1, ParametersRole).toStringList();
+        if (jobData.size() > 2 && jobData.at(1).endsWith(QStringLiteral("-pass2.mlt"))) {
+            // Find and remove 1st pass job
+            QTreeWidgetItem *above = m_view.running_jobs->itemAbove(item);
+            QString firstPassName = jobData.at(1).section(QLatin1Char('-'), 0, -2) + QStringLiteral(".mlt");
+            while (above) {
+                QStringList aboveData = above->data(1, ParametersRole).toStringList();
+                qDebug() << "// GOT  JOB: " << aboveData.at(1);
+                if (aboveData.size() > 2 && aboveData.at(1) == firstPassName) {
+                    delete above;
+                    break;
                 }
+                above = m_view.running_jobs->itemAbove(above);
             }
+        }
+        if (item->status() == WAITINGJOB) {
             item->setStatus(STARTINGJOB);
-            break;
         }
-        item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
-    }
-    if (!waitingJob && m_view.shutdown->isChecked()) {
-        emit shutdown();
     }
 }
 
 void RenderWidget::startRendering(RenderJobItem *item)
 {
     auto rendererArgs = item->data(1, ParametersRole).toStringList();
+    if (rendererArgs.size() > 1) {
+        setRenderThreads(rendererArgs.at(1), KdenliveSettings::concurrentrenders());
+    }
     qDebug() << "starting kdenlive_render process using: " << m_renderer;
     if (!QProcess::startDetached(m_renderer, rendererArgs)) {
         item->setStatus(FAILEDJOB);
@@ -1746,6 +1789,90 @@ void RenderWidget::startRendering(RenderJobItem *item)
     }
 }
 
+void RenderWidget::setRenderThreads(const QString &playlist, int concurrentJobs)
+{
+    if (concurrentJobs < 2) {
+        return;
+    }
+    QFile file(playlist);
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file, false)) {
+        return;
+    }
+    file.close();
+    QDomElement consumer = doc.documentElement().firstChildElement(QStringLiteral("consumer"));
+    if (consumer.isNull()) {
+        return;
+    }
+    int budget = qMax(1, QThread::idealThreadCount() / concurrentJobs);
+    int realTime = consumer.attribute(QStringLiteral("real_time")).toInt();
+    if (realTime < -budget) {
+        consumer.setAttribute(QStringLiteral("real_time"), -budget);
+    }
+    // 0 lets the encoder use all cores
+    int threads = consumer.attribute(QStringLiteral("threads")).toInt();
+    if (threads == 0 || threads > budget) {
+        consumer.setAttribute(QStringLiteral("threads"), budget);
+    }
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        file.write(doc.toString().toUtf8());
+        file.close();
+    }
+}
+
+void RenderWidget::saveRenderQueue(QTreeWidget *runningJobs)
+{
+    QJsonArray jobs;
+    auto *item = static_cast<RenderJobItem *>(runningJobs->topLevelItem(0));
+    while (item != nullptr) {
+        if (item->status() == WAITINGJOB) {
+            QJsonObject job;
+            job.insert(QLatin1String("parameters"), QJsonArray::fromStringList(item->data(1, ParametersRole).toStringList()));
+            job.insert(QLatin1String("priority"), item->data(1, PriorityRole).toInt());
+            job.insert(QLatin1String("info"), item->data(1, ExtraInfoRole).toString());
+            jobs.append(job);
+        }
+        item = static_cast<RenderJobItem *>(runningJobs->itemBelow(item));
+    }
+    KConfigGroup group(KSharedConfig::openConfig(), "RenderQueue");
+    group.writeEntry("jobs", QString::fromUtf8(QJsonDocument(jobs).toJson(QJsonDocument::Compact)));
+    group.sync();
+}
+
+void RenderWidget::loadRenderQueue()
+{
+    restoreRenderQueue(m_view.running_jobs);
+    if (m_view.running_jobs->topLevelItemCount() > 0) {
+        checkRenderStatus();
+    }
+}
+
+void RenderWidget::restoreRenderQueue(QTreeWidget *runningJobs)
+{
+    KConfigGroup group(KSharedConfig::openConfig(), "RenderQueue");
+    const QJsonArray jobs = QJsonDocument::fromJson(group.readEntry("jobs", QString()).toUtf8()).array();
+    for (const auto &entry : jobs) {
+        QJsonObject job = entry.toObject();
+        QStringList params;
+        for (const auto &param : job.value(QLatin1String("parameters")).toArray()) {
+            if (param.toString().startsWith(QLatin1String("-pid:"))) {
+                params << QStringLiteral("-pid:%1").arg(QCoreApplication::applicationPid());
+            } else {
+                params << param.toString();
+            }
+        }
+        // The playlist may have been removed by a reboot if it was in the temporary folder
+        if (params.size() < 3 || !QFile::exists(params.at(1)) || !runningJobs->findItems(params.at(2), Qt::MatchExactly, 1).isEmpty()) {
+            continue;
+        }
+        auto *renderItem = new RenderJobItem(runningJobs, QStringList() << QString() << params.at(2));
+        renderItem->setData(1, TimeRole, QDateTime::currentDateTime());
+        renderItem->setData(1, ParametersRole, params);
+        renderItem->setData(1, PriorityRole, job.value(QLatin1String("priority")).toInt(NORMALPRIORITY));
+        renderItem->setData(1, ExtraInfoRole, job.value(QLatin1String("info")).toString());
+    }
+}
+
 int RenderWidget::waitingJobsCount() const
 {
     int count = 0;
@@ -2828,15 +2955,42 @@ bool RenderWidget::startWaitingRenderJobs()
 #ifndef Q_OS_WIN
     outStream << "#! /bin/sh" << '\n' << '\n';
 #endif
+    QList<RenderJobItem *> waitingJobs;
     auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
     while (item != nullptr) {
         if (item->status() == WAITINGJOB) {
-            // Add render process for item
-            const QString params = item->data(1, ParametersRole).toStringList().join(QLatin1Char(' '));
-            outStream << '\"' << m_renderer << "\" " << params << '\n';
+            waitingJobs << item;
         }
         item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
     }
+    std::stable_sort(waitingJobs.begin(), waitingJobs.end(), [](RenderJobItem *a, RenderJobItem *b) {
+        return a->data(1, PriorityRole).toInt() < b->data(1, PriorityRole).toInt();
+    });
+    int maxJobs = qMax(1, KdenliveSettings::concurrentrenders());
+    int count = 0;
+    for (RenderJobItem *job : waitingJobs) {
+        // Add render process for item
+        QStringList jobParams = job->data(1, ParametersRole).toStringList();
+        if (jobParams.size() > 1) {
+            setRenderThreads(jobParams.at(1), maxJobs);
+        }
+        const QString params = jobParams.join(QLatin1Char(' '));
+#ifndef Q_OS_WIN
+        // Run the jobs by batches of concurrent renders, two pass jobs follow each other so they stay in order
+        bool twoPass = jobParams.size() > 1 && jobParams.at(1).endsWith(QStringLiteral("-pass2.mlt"));
+        if (twoPass || count == maxJobs) {
+            outStream << "wait" << '\n';
+            count = 0;
+        }
+        outStream << '\"' << m_renderer << "\" " << params << " &" << '\n';
+        count++;
+#else
+        outStream << '\"' << m_renderer << "\" " << params << '\n';
+#endif
+    }
+#ifndef Q_OS_WIN
+    outStream << "wait" << '\n';
+#endif
 // erase itself when rendering is finished
 #ifndef Q_OS_WIN
     outStream << "rm \"" << autoscriptFile << "\"\n";
@@ -2852,6 +3006,11 @@ bool RenderWidget::startWaitingRenderJobs()
     file.close();
     QFile::setPermissions(autoscriptFile, file.permissions() | QFile::ExeUser);
     QProcess::startDetached(autoscriptFile, QStringList());
+    // The script takes care of the waiting jobs, don't restore them in the next session
+    for (RenderJobItem *job : waitingJobs) {
+        job->setStatus(STARTINGJOB);
+    }
+    saveRenderQueue(m_view.running_jobs);
     return true;
 }
 
@@ -3075,6 +3234,26 @@ void RenderWidget::prepareMenu(const QPoint &pos)
     if (!renderItem) {
         return;
     }
+    if (renderItem->status() == WAITINGJOB) {
+        QMenu menu(this);
+        QMenu *priorityMenu = menu.addMenu(i18n("Priority"));
+        auto *group = new QActionGroup(&menu);
+        const QList<QPair<int, QString>> priorities = {{HIGHPRIORITY, i18n("High")}, {NORMALPRIORITY, i18n("Normal")}, {LOWPRIORITY, i18n("Low")}};
+        for (const auto &priority : priorities) {
+            QAction *act = priorityMenu->addAction(priority.second);
+            act->setCheckable(true);
+            act->setChecked(renderItem->data(1, PriorityRole).toInt() == priority.first);
+            group->addAction(act);
+            int value = priority.first;
+            connect(act, &QAction::triggered, [this, renderItem, value]() {
+                renderItem->setData(1, PriorityRole, value);
+                renderItem->setToolTip(1, value == NORMALPRIORITY ? QString() : i18n("Priority: %1", value == HIGHPRIORITY ? i18n("High") : i18n("Low")));
+                checkRenderStatus();
+            });
+        }
+        menu.exec(m_view.running_jobs->mapToGlobal(pos));
+        return;
+    }
     if (renderItem->status() != FINISHEDJOB) {
         return;
     }
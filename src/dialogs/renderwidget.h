@@ -100,6 +100,9 @@ public:
     }
 };
 
+// Running job status
+enum JOBSTATUS { WAITINGJOB = 0, STARTINGJOB, RUNNINGJOB, FINISHEDJOB, FAILEDJOB, ABORTEDJOB };
+
 class RenderJobItem : public QTreeWidgetItem
 {
 public:
@@ -145,6 +148,10 @@ public:
 
     /** @brief Display warning message in render widget. */
     void errorMessage(RenderError type, const QString &message);
+    /** @brief Store the waiting jobs of the list so that they are restored in the next session. */
+    static void saveRenderQueue(QTreeWidget *runningJobs);
+    /** @brief Add the jobs stored by saveRenderQueue to the list. */
+    static void restoreRenderQueue(QTreeWidget *runningJobs);
 
 protected:
     QSize sizeHint() const override;
@@ -224,9 +231,13 @@ private:
     void parseFile(const QString &exportFile, bool editable);
     void updateButtons();
     QUrl filenameWithExtension(QUrl url, const QString &extension);
-    /** @brief Check if a job needs to be started. */
+    /** @brief Start waiting jobs until the number of concurrent renders is reached. */
     void checkRenderStatus();
     void startRendering(RenderJobItem *item);
+    /** @brief Share the processor between concurrent renders by limiting the threads of the playlist's consumer. */
+    void setRenderThreads(const QString &playlist, int concurrentJobs);
+    /** @brief Restore the jobs of the previous session and start them. */
+    void loadRenderQueue();
     bool saveProfile(QDomElement newprofile);
     /** @brief Create a rendering profile from MLT preset. */
     QTreeWidgetItem *loadFromMltPreset(const QString &groupName, const QString &path, const QString &profileName);
@@ -20,19 +20,131 @@
  ***************************************************************************/
 
 #include "docundostack.hpp"
+#include "undohelper.hpp"
 #include <QUndoCommand>
 #include <QUndoGroup>
 
+namespace {
+// Estimation for the commands that cannot tell what they hold
+const qint64 genericCommandFootprint = 1024;
+
+void discardCommand(QUndoCommand *cmd)
+{
+    if (auto functional = dynamic_cast<FunctionalUndoCommand *>(cmd)) {
+        functional->discard();
+    }
+    for (int i = 0; i < cmd->childCount(); ++i) {
+        discardCommand(const_cast<QUndoCommand *>(cmd->child(i)));
+    }
+}
+} // namespace
+
 DocUndoStack::DocUndoStack(QUndoGroup *parent)
     : QUndoStack(parent)
+    , m_budget(0)
+    , m_usage(0)
+    , m_discarded(0)
 {
+    connect(this, &QUndoStack::indexChanged, this, [this](int ix) {
+        if (count() == 0) {
+            // Stack was cleared
+            m_discarded = 0;
+            m_sizes.clear();
+            if (m_usage > 0) {
+                m_usage = 0;
+                emit memoryUsageChanged(m_usage, m_budget);
+            }
+        } else if (ix < m_discarded) {
+            // Discarded commands do nothing on undo, go back to the oldest state we can restore
+            setIndex(m_discarded);
+        }
+    });
 }
 
 // TODO: custom undostack everywhere do that
 void DocUndoStack::push(QUndoCommand *cmd)
 {
-    if (index() < count()) {
+    const int ix = index();
+    if (ix < count()) {
         emit invalidate();
     }
+    // Only the end of the history changes: the redo branch is deleted and the command is appended, merged with the previous one,
+    // or added to the open macro (which is the last command)
+    const bool inMacro = ix < count() && !canRedo();
+    const int first = inMacro ? count() - 1 : qMax(0, ix - 1);
+    const qint64 usage = m_usage;
     QUndoStack::push(cmd);
+    updateSizes(first);
+    enforceBudget();
+    if (m_usage != usage) {
+        emit memoryUsageChanged(m_usage, m_budget);
+    }
+}
+
+void DocUndoStack::setMemoryBudget(qint64 budget)
+{
+    m_budget = qMax(qint64(0), budget);
+    enforceBudget();
+    emit memoryUsageChanged(m_usage, m_budget);
+}
+
+qint64 DocUndoStack::memoryBudget() const
+{
+    return m_budget;
+}
+
+qint64 DocUndoStack::memoryUsage() const
+{
+    return m_usage;
+}
+
+int DocUndoStack::discardedCount() const
+{
+    return m_discarded;
+}
+
+qint64 DocUndoStack::footprint(const QUndoCommand *cmd)
+{
+    qint64 size = 0;
+    if (auto functional = dynamic_cast<const FunctionalUndoCommand *>(cmd)) {
+        size = functional->footprint();
+    } else {
+        size = genericCommandFootprint + cmd->text().size() * (qint64)sizeof(QChar);
+    }
+    for (int i = 0; i < cmd->childCount(); ++i) {
+        size += footprint(cmd->child(i));
+    }
+    return size;
+}
+
+void DocUndoStack::updateSizes(int first)
+{
+    // Macros are opened without going through push, so the sizes may lag behind
+    first = qMin(first, int(m_sizes.size()));
+    for (int i = first; i < int(m_sizes.size()); ++i) {
+        if (i >= m_discarded) {
+            m_usage -= m_sizes[size_t(i)];
+        }
+    }
+    m_sizes.resize(size_t(first));
+    m_discarded = qMin(m_discarded, count());
+    for (int i = first; i < count(); ++i) {
+        m_sizes.push_back(footprint(command(i)));
+        if (i >= m_discarded) {
+            m_usage += m_sizes.back();
+        }
+    }
+}
+
+void DocUndoStack::enforceBudget()
+{
+    if (m_budget <= 0) {
+        return;
+    }
+    // Discard the oldest commands, but always keep the last one undoable
+    while (m_usage > m_budget && m_discarded < index() - 1 && m_discarded < int(m_sizes.size())) {
+        discardCommand(const_cast<QUndoCommand *>(command(m_discarded)));
+        m_usage -= m_sizes[size_t(m_discarded)];
+        m_discarded++;
+    }
 }
@@ -22,18 +22,47 @@
 #define DOCUNDOSTACK_H
 
 #include <QUndoCommand>
+#include <vector>
 
 class QUndoGroup;
 class QUndoCommand;
 
+/* @brief The undo stack of a document.
+   Each command reports an estimation of the memory it holds, which is measured once when it is pushed. When the total goes
+   over the memory budget, the oldest commands are discarded: they release their data and the history cannot be undone past them anymore.
+   Commands that are not FunctionalUndoCommand cannot release their data, they only leave the usage. Undoing to a state older
+   than the discarded commands is bounced back to the oldest state that can be restored.
+ */
 class DocUndoStack : public QUndoStack
 {
     Q_OBJECT
 public:
     explicit DocUndoStack(QUndoGroup *parent = Q_NULLPTR);
     void push(QUndoCommand *cmd);
+    /* @brief Set the maximum memory, in bytes, used by the undoable commands. 0 means no limit */
+    void setMemoryBudget(qint64 budget);
+    qint64 memoryBudget() const;
+    /* @brief Estimated memory, in bytes, held by the commands that can still be undone or redone */
+    qint64 memoryUsage() const;
+    /* @brief Number of the oldest commands that were discarded to respect the budget */
+    int discardedCount() const;
+    /* @brief Estimated memory, in bytes, held by a command and its children */
+    static qint64 footprint(const QUndoCommand *cmd);
+
+private:
+    qint64 m_budget;
+    qint64 m_usage;
+    int m_discarded;
+    /* @brief Footprint of each command of the history, as measured when it was pushed or last changed */
+    std::vector<qint64> m_sizes;
+    /* @brief Measure again the commands from index @param first, the ones before did not change */
+    void updateSizes(int first);
+    /* @brief Discard the oldest commands while the memory usage is over the budget */
+    void enforceBudget();
+
 signals:
     void invalidate();
+    void memoryUsageChanged(qint64 usage, qint64 budget);
 };
 
 #endif
@@ -58,6 +58,7 @@
 #include <QFileDialog>
 #include <QUndoGroup>
 #include <QUndoStack>
+#include <QtConcurrent>
 
 #include <KJobWidgets/KJobWidgets>
 #include <QStandardPaths>
@@ -87,6 +88,13 @@ KdenliveDoc::KdenliveDoc(const QUrl &url, QString projectFolder, QUndoGroup *und
     bool success = false;
     connect(m_commandStack.get(), &QUndoStack::indexChanged, this, &KdenliveDoc::slotModified);
     connect(m_commandStack.get(), &DocUndoStack::invalidate, this, &KdenliveDoc::checkPreviewStack);
+    m_commandStack->setMemoryBudget(KdenliveSettings::undomemorybudget() * qint64(1024 * 1024));
+    m_autoSavePool.setMaxThreadCount(1);
+    connect(&m_autoSaveWatcher, &QFutureWatcher<bool>::finished, this, [this]() {
+        if (!m_autoSaveWatcher.result() && m_autosave != nullptr) {
+            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
+        }
+    });
     // connect(m_commandStack, SIGNAL(cleanChanged(bool)), this, SLOT(setModified(bool)));
 
     // init default document properties
@@ -281,6 +289,7 @@ KdenliveDoc::KdenliveDoc(const QUrl &url, QString projectFolder, QUndoGroup *und
 
 KdenliveDoc::~KdenliveDoc()
 {
+    waitForAutoSave();
     if (m_url.isEmpty()) {
         // Document was never saved, delete cache folder
         QString documentId = QDir::cleanPath(getDocumentProperty(QStringLiteral("documentid")));
@@ -440,9 +449,13 @@ bool KdenliveDoc::autoGenerateImageProxy(int width) const
            width > m_documentProperties.value(QStringLiteral("proxyimageminsize")).toInt();
 }
 
-void KdenliveDoc::slotAutoSave(const QString &scene)
+void KdenliveDoc::slotAutoSave(const QString &scene, const QMap<QString, QString> &replacementPattern)
 {
     if (m_autosave != nullptr) {
+        if (isAutoSaving()) {
+            // The file must not be written from 2 threads at once, the caller retries later
+            return;
+        }
         if (!m_autosave->isOpen() && !m_autosave->open(QIODevice::ReadWrite)) {
             // show error: could not open the autosave file
             qCDebug(KDENLIVE_LOG) << "ERROR; CANNOT CREATE AUTOSAVE FILE";
@@ -454,14 +467,34 @@ void KdenliveDoc::slotAutoSave(const QString &scene)
             KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", m_autosave->fileName()));
             return;
         }
-        m_autosave->resize(0);
-        if (m_autosave->write(scene.toUtf8()) < 0) {
-            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
-        };
-        m_autosave->flush();
+        QByteArray data = scene.toUtf8();
+        QMapIterator<QString, QString> i(replacementPattern);
+        while (i.hasNext()) {
+            i.next();
+            data.replace(i.key().toUtf8(), i.value().toUtf8());
+        }
+        // The autosave file stays open in this thread to keep its lock, the worker only writes the data to its path
+        const QString path = m_autosave->fileName();
+        m_autoSaveWatcher.setFuture(QtConcurrent::run(&m_autoSavePool, [path, data]() {
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                return false;
+            }
+            return file.write(data) == data.size() && file.flush();
+        }));
     }
 }
 
+void KdenliveDoc::waitForAutoSave()
+{
+    m_autoSaveWatcher.waitForFinished();
+}
+
+bool KdenliveDoc::isAutoSaving() const
+{
+    return m_autoSaveWatcher.isRunning();
+}
+
 void KdenliveDoc::setZoom(int horizontal, int vertical)
 {
     m_documentProperties[QStringLiteral("zoom")] = QString::number(horizontal);
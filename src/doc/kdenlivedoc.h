@@ -27,8 +27,10 @@
 
 #include <QAction>
 #include <QDir>
+#include <QFutureWatcher>
 #include <QList>
 #include <QMap>
+#include <QThreadPool>
 #include <memory>
 #include <qdom.h>
 
@@ -157,6 +159,10 @@ public:
     int clipsCount() const;
     /** @brief Returns a list of project tags (color / description) */
     QMap <QString, QString> getProjectTags();
+    /** @brief Blocks until the autosave file being written in background is complete */
+    void waitForAutoSave();
+    /** @brief Returns true if an autosave file is being written in background */
+    bool isAutoSaving() const;
 
 private:
     QUrl m_url;
@@ -171,6 +177,10 @@ private:
     /** @brief Tells whether the current document has been changed after being saved. */
     bool m_modified;
 
+    /** @brief The autosave file is written in this pool, so that it doesn't wait behind clip jobs in the global pool */
+    QThreadPool m_autoSavePool;
+    QFutureWatcher<bool> m_autoSaveWatcher;
+
     /** @brief The default recommended proxy extension */
     QString m_proxyExtension;
 
@@ -216,8 +226,10 @@ public slots:
     void slotProxyCurrentItem(bool doProxy, QList<std::shared_ptr<ProjectClip>> clipList = QList<std::shared_ptr<ProjectClip>>(), bool force = false,
                               QUndoCommand *masterCommand = nullptr);
     /** @brief Saves the current project at the autosave location.
-     * @description The autosave files are in ~/.kde/data/stalefiles/kdenlive/ */
-    void slotAutoSave(const QString &scene);
+     * @description The autosave files are in ~/.kde/data/stalefiles/kdenlive/
+     * The replacement patterns are applied to the scene and the file is written in a background thread.
+     * Nothing is saved while the previous autosave is still being written */
+    void slotAutoSave(const QString &scene, const QMap<QString, QString> &replacementPattern = QMap<QString, QString>());
     /** @brief Groups were changed, save to MLT. */
     void groupsChanged(const QString &groups);
 
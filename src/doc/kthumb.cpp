@@ -28,6 +28,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QImage>
 #include <QPixmap>
+#include <QScopedPointer>
+#include <algorithm>
+
 // static
 QPixmap KThumb::getImage(const QUrl &url, int width, int height)
 {
@@ -149,3 +152,62 @@ int KThumb::imageVariance(const QImage &image)
     }
     return 0;
 }
+
+// static
+void KThumb::extractFrames(Mlt::Producer &producer, std::vector<int> positions, int maxGap, const std::function<bool(int, Mlt::Frame *)> &callback)
+{
+    // The avformat producer seeks when asked for a frame 12 frames or more after the expected one, stay below
+    const int forwardStep = 10;
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+    QScopedPointer<Mlt::Frame> frame;
+    // Position of the last frame decoded by a previous extraction. If the producer was used in between, the avformat producer
+    // just seeks as it would have done anyway
+    int decoded = producer.get("_kdenlive_decoded") ? producer.get_int("_kdenlive_decoded") : -1;
+    for (int pos : positions) {
+        if (decoded >= 0 && pos > decoded && pos - decoded <= maxGap) {
+            for (int step = decoded + forwardStep; step < pos; step += forwardStep) {
+                producer.seek(step);
+                QScopedPointer<Mlt::Frame> skipped(producer.get_frame());
+                if (skipped != nullptr && skipped->is_valid()) {
+                    // Only decode, the image is not used
+                    mlt_image_format format = mlt_image_yuv422;
+                    int width = 0;
+                    int height = 0;
+                    skipped->get_image(format, width, height);
+                }
+            }
+        }
+        producer.seek(pos);
+        frame.reset(producer.get_frame());
+        if (frame == nullptr || !frame->is_valid()) {
+            frame.reset();
+            decoded = -1;
+            producer.set("_kdenlive_decoded", decoded);
+            continue;
+        }
+        frame->set("deinterlace_method", "onefield");
+        frame->set("top_field_first", -1);
+        frame->set("rescale.interp", "nearest");
+        decoded = pos;
+        producer.set("_kdenlive_decoded", decoded);
+        if (!callback(pos, frame.data())) {
+            return;
+        }
+    }
+}
+
+// static
+int KThumb::sequentialDecodeGap(const QString &videoCodec, double fps)
+{
+    // Every frame of these codecs is a keyframe, seeking is always cheaper
+    static const QStringList intraCodecs = {QStringLiteral("mjpeg"),     QStringLiteral("prores"), QStringLiteral("dnxhd"),    QStringLiteral("ffv1"),
+                                            QStringLiteral("huffyuv"),   QStringLiteral("png"),    QStringLiteral("rawvideo"), QStringLiteral("dvvideo"),
+                                            QStringLiteral("cfhd"),      QStringLiteral("utvideo"), QStringLiteral("qtrle"),   QStringLiteral("v210"),
+                                            QStringLiteral("jpeg2000"), QStringLiteral("magicyuv")};
+    if (intraCodecs.contains(videoCodec)) {
+        return 0;
+    }
+    // Typical camera GOPs are between one and a few seconds long
+    return qMax(12, qRound(2 * fps));
+}
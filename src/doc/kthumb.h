@@ -24,6 +24,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QImage>
 #include <QUrl>
+#include <functional>
+#include <vector>
 
 namespace Mlt {
 class Producer;
@@ -40,6 +42,16 @@ QImage getFrame(Mlt::Frame *frame, int width = 0, int height = 0, int scaledWidt
  *  @return an integer between 0 and 100. 0 means no variance, eg. black image while bigger values mean contrasted image
  * */
 int imageVariance(const QImage &image);
+/** @brief Decode the frames of producer at the given positions, in increasing order.
+ *  Positions closer than maxGap to the previous one are reached by decoding forward instead of seeking, so that long GOP
+ *  footage is not decoded again from the previous keyframe for every frame. The last decoded position is kept in the
+ *  producer so that a following extraction continues from there.
+ *  The callback has to decode the frame's image.
+ *  @param callback called with each requested position and its frame as soon as it is decoded, return false to stop
+ * */
+void extractFrames(Mlt::Producer &producer, std::vector<int> positions, int maxGap, const std::function<bool(int, Mlt::Frame *)> &callback);
+/** @brief Returns the largest gap between two frames that is cheaper to decode forward than to seek, 0 for intra only codecs. */
+int sequentialDecodeGap(const QString &videoCodec, double fps);
 } // namespace KThumb
 
 #endif
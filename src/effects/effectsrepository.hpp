@@ -75,6 +75,8 @@ protected:
     /* @brief Returns the path to the effects' preferred list*/
     QString assetPreferredListPath() const override;
 
+    QString assetCacheName() const override;
+
     QStringList assetDirs() const override;
 
     void parseType(QScopedPointer<Mlt::Properties> &metadata, Info &res) override;
@@ -27,6 +27,7 @@
 #include "effects/effectsrepository.hpp"
 #include "macros.hpp"
 #include "timeline2/model/timelinemodel.hpp"
+#include <QTextStream>
 #include <profiles/profilemodel.hpp>
 #include <stack>
 #include <utility>
@@ -184,7 +185,12 @@ void EffectStackModel::removeEffect(const std::shared_ptr<EffectItemModel> &effe
         update();
         PUSH_LAMBDA(update, redo);
         PUSH_LAMBDA(update2, undo);
-        PUSH_UNDO(undo, redo, i18n("Delete effect %1", effectName));
+        // The undo function keeps the effect and its parameters alive
+        qint64 size = 0;
+        for (const auto &param : effect->getAllParameters()) {
+            size += (param.first.size() + param.second.toString().size()) * (qint64)sizeof(QChar);
+        }
+        PUSH_UNDO_SIZED(undo, redo, i18n("Delete effect %1", effectName), size);
     } else {
         qDebug() << "..........FAILED EFFECT DELETION";
     }
@@ -196,7 +202,11 @@ bool EffectStackModel::copyXmlEffect(QDomElement effect)
     std::function<bool(void)> redo = []() { return true; };
     bool result = fromXml(effect, undo, redo);
     if (result) {
-        PUSH_UNDO(undo, redo, i18n("Copy effect"));
+        QString xml;
+        QTextStream stream(&xml);
+        effect.save(stream, 0);
+        stream.flush();
+        PUSH_UNDO_SIZED(undo, redo, i18n("Copy effect"), xml.size() * (qint64)sizeof(QChar));
     }
     return result;
 }
@@ -27,12 +27,14 @@
 #include "doc/kthumb.h"
 #include "kdenlivesettings.h"
 #include "klocalizedstring.h"
+#include "lib/audio/audioLevelReducer.h"
+#include "lib/audio/audioPeakFile.h"
 #include "lib/audio/audioStreamInfo.h"
-#include "macros.hpp"
 #include "utils/thumbnailcache.hpp"
-#include <QScopedPointer>
-#include <QTemporaryFile>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QProcess>
+#include <QScopedPointer>
 #include <memory>
 #include <mlt++/MltProducer.h>
 
@@ -118,6 +120,16 @@ bool AudioThumbJob::computeWithFFMPEG()
         filePath = m_prod->get("resource");
     }
     m_ffmpegProcess.reset(new QProcess);
+    // Kill the running ffmpeg stage, the process is replaced between the stages
+    connect(this, &AudioThumbJob::jobCanceled, this,
+            [this]() {
+                if (m_ffmpegProcess) {
+                    m_ffmpegProcess->kill();
+                }
+                m_done = true;
+                m_successful = false;
+            },
+            Qt::DirectConnection);
     if (!m_thumbInCache) {
         QStringList args;
         args << QStringLiteral("-hide_banner") << QStringLiteral("-y")<< QStringLiteral("-i") << QUrl::fromLocalFile(filePath).toLocalFile() << QStringLiteral("-filter_complex:a");
@@ -125,13 +137,6 @@ bool AudioThumbJob::computeWithFFMPEG()
         args << QStringLiteral("-frames:v") << QStringLiteral("1");
         args << m_binClip->getAudioThumbPath(true);
         connect(m_ffmpegProcess.get(), &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress, Qt::UniqueConnection);
-        connect(this, &AudioThumbJob::jobCanceled, [&] () {
-            if (m_ffmpegProcess) {
-                m_ffmpegProcess->kill();
-            }
-            m_done = true;
-            m_successful = false;
-        });
         m_ffmpegProcess->start(KdenliveSettings::ffmpegpath(), args);
         m_ffmpegProcess->waitForFinished(-1);
         if (m_ffmpegProcess->exitStatus() != QProcess::CrashExit) {
@@ -147,115 +152,49 @@ bool AudioThumbJob::computeWithFFMPEG()
     }
     if (!m_dataInCache && !m_done) {
         m_audioLevels.clear();
-        std::vector<std::unique_ptr<QTemporaryFile>> channelFiles;
-        for (int i = 0; i < m_channels; i++) {
-            std::unique_ptr<QTemporaryFile> channelTmpfile(new QTemporaryFile());
-            if (!channelTmpfile->open()) {
-                m_errorMessage.append(i18n("Audio thumbs: cannot create temporary file, check disk space and permissions\n"));
-                return false;
-            }
-            channelTmpfile->close();
-            channelFiles.emplace_back(std::move(channelTmpfile));
+        // Always create audio thumbs from the original source file, because proxy
+        // can have a different audio config (channels / mono/ stereo).
+        // The interleaved samples are streamed through ffmpeg's stdout and reduced as they arrive,
+        // so that we never hold more than one chunk of raw audio in memory.
+        QStringList args {QStringLiteral("-hide_banner"), QStringLiteral("-nostats"), QStringLiteral("-loglevel"), QStringLiteral("error"),
+                          QStringLiteral("-i"), QUrl::fromLocalFile(filePath).toLocalFile()};
+        args << QStringLiteral("-map") << QStringLiteral("0:a%1").arg(m_audioStream > 0 ? ":" + QString::number(m_audioStream) : QString());
+        args << QStringLiteral("-vn") << QStringLiteral("-ac") << QString::number(m_channels) << QStringLiteral("-ar") << QString::number(m_frequency);
+        args << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-f") << QStringLiteral("s16le") << QStringLiteral("-");
+        double fps = m_prod->get_fps();
+        AudioLevelReducer reducer(m_channels, m_frequency, fps);
+        m_ffmpegProcess.reset(new QProcess);
+        m_ffmpegProcess->start(KdenliveSettings::ffmpegpath(), args);
+        if (!m_ffmpegProcess->waitForStarted()) {
+            m_errorMessage.append(i18n("Audio thumbs: cannot start FFmpeg\n"));
+            return false;
         }
-        // Always create audio thumbs from the original source file, because proxy 
-        // can have a different audio config (channels / mono/ stereo)
-        QStringList args {QStringLiteral("-hide_banner"), QStringLiteral("-i"), QUrl::fromLocalFile(filePath).toLocalFile(), QStringLiteral("-progress")};
-#ifdef Q_OS_WIN
-        args << QStringLiteral("-");
-#else
-        args << QStringLiteral("/dev/stdout");
-#endif
-        bool isFFmpeg = KdenliveSettings::ffmpegpath().contains(QLatin1String("ffmpeg"));
-        args << QStringLiteral("-filter_complex:a");
-        if (m_channels == 1) {
-            //TODO: this does not correcty generate the correct stream data
-            args << QStringLiteral("aformat=channel_layouts=mono,%1=100").arg(isFFmpeg ? "aresample=async" : "sample_rates");
-            args << QStringLiteral("-map") << QStringLiteral("0:a%1").arg(m_audioStream > 0 ? ":" + QString::number(m_audioStream) : QString())
-             << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-frames:v") 
-             << QStringLiteral("1") << QStringLiteral("-y") << QStringLiteral("-f") << QStringLiteral("data")
-             << channelFiles[0]->fileName();
-        } else {
-            QString aformat = QStringLiteral("[0:a%1]%2=100,channelsplit=channel_layout=%3")
-                              .arg(m_audioStream > 0 ? ":" + QString::number(m_audioStream) : QString())
-                              .arg(isFFmpeg ? "aresample=async" : "aformat=sample_rates")
-                              .arg(m_channels > 2 ? "5.1" : "stereo");
-            for (int i = 0; i < m_channels; ++i) {
-                aformat.append(QStringLiteral("[0:%1]").arg(i));
+        int progress = 0;
+        QElapsedTimer publishTimer;
+        publishTimer.start();
+        while (m_ffmpegProcess->waitForReadyRead(-1) || m_ffmpegProcess->bytesAvailable() > 0) {
+            reducer.addData(m_ffmpegProcess->readAllStandardOutput());
+            int p = m_lengthInFrames > 0 ? qMin(99, 100 * reducer.frameCount() / m_lengthInFrames) : 0;
+            if (p != progress) {
+                emit jobProgress(p);
+                progress = p;
             }
-            args << aformat;
-            args << QStringLiteral("-frames:v") << QStringLiteral("1");
-            for (int i = 0; i < m_channels; i++) {
-                // Channel 1
-                args << QStringLiteral("-map") << QStringLiteral("[0:%1]").arg(i) << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-y")
-                 << QStringLiteral("-f") << QStringLiteral("data") << channelFiles[size_t(i)]->fileName();
+            if (publishTimer.elapsed() > 1000) {
+                // Display what we already have in the timeline while the rest is processed
+                publishTimer.restart();
+                QMetaObject::invokeMethod(m_binClip.get(), [clip = m_binClip, levels = reducer.levels()]() { clip->updateAudioThumbnail(levels, false); },
+                                          Qt::QueuedConnection);
             }
         }
-        m_ffmpegProcess.reset(new QProcess);
-        connect(m_ffmpegProcess.get(), &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress, Qt::UniqueConnection);
-        connect(this, &AudioThumbJob::jobCanceled, [&]() {
-            if (m_ffmpegProcess) {
-                m_ffmpegProcess->kill();
-            }
-        });
-        m_ffmpegProcess->start(KdenliveSettings::ffmpegpath(), args);
         m_ffmpegProcess->waitForFinished(-1);
-        if (m_ffmpegProcess->exitStatus() != QProcess::CrashExit) {
-            int dataSize = 0;
-            std::vector<const qint16 *> rawChannels;
-            std::vector<QByteArray> sourceChannels;
-            for (auto &channelFile : channelFiles) {
-                channelFile->open();
-                sourceChannels.emplace_back(channelFile->readAll());
-                QByteArray &res = sourceChannels.back();
-                channelFile->close();
-                if (dataSize == 0) {
-                    dataSize = res.size();
-                }
-                if (res.isEmpty() || res.size() != dataSize) {
-                    // Something went wrong, abort
-                    m_errorMessage.append(i18n("Audio thumbs: error reading audio thumbnail created with FFmpeg\n"));
-                    return false;
-                }
-                rawChannels.emplace_back(reinterpret_cast<const qint16 *>(res.constData()));
-            }
-            int progress = 0;
-            std::vector<long> channelsData;
-            double offset = (double)dataSize / (2.0 * m_lengthInFrames);
-            int intraOffset = 1;
-            if (offset > 1000) {
-                intraOffset = offset / 60;
-            } else if (offset > 250) {
-                intraOffset = offset / 10;
-            }
-            long maxLevel = 1;
-            QVector <long> ffmpegLevels;
-            for (int i = 0; i < m_lengthInFrames; i++) {
-                channelsData.resize((size_t)rawChannels.size());
-                std::fill(channelsData.begin(), channelsData.end(), 0);
-                int pos = (int)(i * offset);
-                int steps = 0;
-                for (int j = 0; j < (int)offset && (pos + j < dataSize); j += intraOffset) {
-                    steps++;
-                    for (size_t k = 0; k < rawChannels.size(); k++) {
-                        channelsData[k] += abs(rawChannels[k][pos + j]);
-                    }
-                }
-                for (long &k : channelsData) {
-                    if (steps != 0) {
-                        k /= steps;
-                    }
-                    maxLevel = qMax(k, maxLevel);
-                    ffmpegLevels << k;
-                }
-                int p = 80 + (i * 20 / m_lengthInFrames);
-                if (p != progress) {
-                    emit jobProgress(p);
-                    progress = p;
-                }
-            }
-            for (long &v : ffmpegLevels) {
-                m_audioLevels << (uint8_t) (255 * v / maxLevel);
+        if (m_ffmpegProcess->exitStatus() != QProcess::CrashExit && m_ffmpegProcess->exitCode() == 0) {
+            reducer.finish();
+            if (reducer.frameCount() == 0) {
+                // Something went wrong, abort
+                m_errorMessage.append(i18n("Audio thumbs: error reading audio thumbnail created with FFmpeg\n"));
+                return false;
             }
+            m_audioLevels = reducer.levels();
             m_done = true;
             return true;
         }
@@ -319,20 +258,8 @@ bool AudioThumbJob::startJob()
     }
     m_cachePath = m_binClip->getAudioThumbPath();
 
-    // checking for cached thumbs
-    QImage image(m_cachePath);
-    if (!image.isNull()) {
-        // convert cached image
-        int n = image.width() * image.height();
-        for (int i = 0; i < n; i++) {
-            QRgb p = image.pixel(i / m_channels, i % m_channels);
-            m_audioLevels << (uint8_t)qRed(p);
-            m_audioLevels << (uint8_t)qGreen(p);
-            m_audioLevels << (uint8_t)qBlue(p);
-            m_audioLevels << (uint8_t)qAlpha(p);
-        }
-    }
-    if (!m_audioLevels.isEmpty()) {
+    // checking for cached levels, they will be mapped by the clip when committing the result
+    if (AudioPeakFile::open(m_cachePath)) {
         m_dataInCache = true;
     }
 
@@ -351,26 +278,14 @@ bool AudioThumbJob::startJob()
     Q_ASSERT(ok == m_done);
 
     if (ok && m_done && !m_dataInCache && !m_audioLevels.isEmpty()) {
-        // Put into an image for caching.
-        int count = m_audioLevels.size();
-        image = QImage((int)lrint((count + 3) / 4.0 / m_channels), m_channels, QImage::Format_ARGB32);
-        int n = image.width() * image.height();
-        for (int i = 0; i < n; i++) {
-            QRgb p;
-            if ((4 * i + 3) < count) {
-                p = qRgba(m_audioLevels.at(4 * i), m_audioLevels.at(4 * i + 1), m_audioLevels.at(4 * i + 2),
-                          m_audioLevels.at(4 * i + 3));
-            } else {
-                int last = m_audioLevels.last();
-                int r = (4 * i + 0) < count ? m_audioLevels.at(4 * i + 0) : last;
-                int g = (4 * i + 1) < count ? m_audioLevels.at(4 * i + 1) : last;
-                int b = (4 * i + 2) < count ? m_audioLevels.at(4 * i + 2) : last;
-                int a = last;
-                p = qRgba(r, g, b, a);
-            }
-            image.setPixel(i / m_channels, i % m_channels, p);
+        // Save the peak file for caching. Once written, the clip maps it instead of keeping the levels in memory
+        if (AudioPeakFile::write(m_cachePath, m_audioLevels, m_channels)) {
+            m_audioLevels.clear();
+            // Levels were cached as a PNG image by previous versions, it is replaced by the peak file
+            QFile::remove(m_cachePath.section(QLatin1Char('.'), 0, -2) + QStringLiteral(".png"));
+        } else {
+            qWarning() << "Cannot write audio peak file" << m_cachePath;
         }
-        image.save(m_cachePath);
         m_successful = true;
         return true;
     } else if (ok && m_thumbInCache && m_done) {
@@ -384,6 +299,9 @@ bool AudioThumbJob::startJob()
 
 bool AudioThumbJob::commitResult(Fun &undo, Fun &redo)
 {
+    // The levels are cached data, not part of the edit history: the peak file they are read from cannot be restored by an undo
+    Q_UNUSED(undo)
+    Q_UNUSED(redo)
     Q_ASSERT(!m_resultConsumed);
     m_ffmpegProcess.reset();
     if (!m_done) {
@@ -394,28 +312,11 @@ bool AudioThumbJob::commitResult(Fun &undo, Fun &redo)
     if (!m_successful) {
         return false;
     }
-    QVector <uint8_t>old = m_binClip->audioFrameCache;
-    QImage oldImage = m_binClip->thumbnail(m_thumbSize.width(), m_thumbSize.height()).toImage();
     QImage result = ThumbnailCache::get()->getAudioThumbnail(m_clipId);
-
-    // note that the image is moved into lambda, it won't be available from this class anymore
-    auto operation = [clip = m_binClip, audio = std::move(m_audioLevels), image = std::move(result)]() {
-        clip->updateAudioThumbnail(audio);
-        if (!image.isNull() && clip->clipType() == ClipType::Audio) {
-            clip->setThumbnail(image);
-        }
-        return true;
-    };
-    auto reverse = [clip = m_binClip, audio = std::move(old), image = std::move(oldImage)]() {
-        clip->updateAudioThumbnail(audio);
-        if (!image.isNull() && clip->clipType() == ClipType::Audio) {
-            clip->setThumbnail(image);
-        }
-        return true;
-    };
-    bool ok = operation();
-    if (ok) {
-        UPDATE_UNDO_REDO_NOLOCK(operation, reverse, undo, redo);
+    m_binClip->updateAudioThumbnail(m_audioLevels);
+    m_audioLevels.clear();
+    if (!result.isNull() && m_binClip->clipType() == ClipType::Audio) {
+        m_binClip->setThumbnail(result);
     }
-    return ok;
+    return true;
 }
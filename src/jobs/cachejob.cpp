@@ -77,11 +77,6 @@ bool CacheJob::startJob()
         m_done = true;
         return true;
     }
-    m_prod = m_binClip->thumbProducer();
-    if ((m_prod == nullptr) || !m_prod->is_valid()) {
-        qDebug() << "********\nCOULD NOT READ THUMB PRODUCER\n********";
-        return false;
-    }
     int duration = m_outPoint > 0 ? m_outPoint - m_inPoint : (int)m_binClip->frameDuration();
     if (m_thumbsCount * 5 > duration) {
         m_thumbsCount = duration / 10;
@@ -93,27 +88,37 @@ bool CacheJob::startJob()
         frames.insert(pos);
         pos = m_inPoint + (steps * i);
     }
-    int size = (int)frames.size();
-    int count = 0;
+    // Decode the missing thumbnails in one forward pass, each one is stored as soon as it is decoded
+    std::vector<int> missing;
     for (int i : frames) {
+        if (!ThumbnailCache::get()->hasThumbnail(m_clipId, i)) {
+            missing.push_back(i);
+        }
+    }
+    if (missing.empty()) {
+        m_done = true;
+        return true;
+    }
+    m_prod = m_binClip->thumbProducer(missing.front());
+    if ((m_prod == nullptr) || !m_prod->is_valid()) {
+        qDebug() << "********\nCOULD NOT READ THUMB PRODUCER\n********";
+        return false;
+    }
+    int size = (int)missing.size();
+    int count = 0;
+    int maxGap = KThumb::sequentialDecodeGap(m_binClip->codec(false), pCore->getCurrentFps());
+    KThumb::extractFrames(*m_prod.get(), missing, maxGap, [&](int pos, Mlt::Frame *frame) {
         if (m_done) {
-            break;
+            return false;
         }
         emit jobProgress(100 * count / size);
         count++;
-        if (ThumbnailCache::get()->hasThumbnail(m_clipId, i)) {
-            continue;
-        }
-        m_prod->seek(i);
-        QScopedPointer<Mlt::Frame> frame(m_prod->get_frame());
-        frame->set("deinterlace_method", "onefield");
-        frame->set("top_field_first", -1);
-        frame->set("rescale.interp", "nearest");
-        if (frame != nullptr && frame->is_valid()) {
-            QImage result = KThumb::getFrame(frame.data(), m_imageWidth, m_imageHeight, m_fullWidth);
-            ThumbnailCache::get()->storeThumbnail(m_clipId, i, result, true);
-        }
-    }
+        QImage result = KThumb::getFrame(frame, m_imageWidth, m_imageHeight, m_fullWidth);
+        ThumbnailCache::get()->storeThumbnail(m_clipId, pos, result, true);
+        return true;
+    });
+    // Return the producer to the pool
+    m_prod.reset();
     m_done = true;
     return true;
 }
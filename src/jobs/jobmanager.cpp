@@ -29,14 +29,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "undohelper.hpp"
 
 #include <KMessageWidget>
-#include <QFuture>
-#include <QFutureWatcher>
 #include <QThread>
 
 int JobManager::m_currentId = 0;
 JobManager::JobManager(QObject *parent)
     : QAbstractListModel(parent)
     , m_lock(QReadWriteLock::Recursive)
+    , m_scheduler(new JobScheduler())
 {
 }
 
@@ -45,13 +44,21 @@ JobManager::~JobManager()
     //slotCancelJobs();
 }
 
+namespace {
+bool isActive(const std::shared_ptr<Job_t> &job)
+{
+    JobManagerStatus status = job->m_status;
+    return status == JobManagerStatus::Pending || status == JobManagerStatus::Running;
+}
+} // namespace
+
 int JobManager::getBlockingJobId(const QString &id, AbstractClipJob::JOBTYPE type)
 {
     READ_LOCK();
     std::vector<int> result;
     if (m_jobsByClip.count(id) > 0) {
         for (int jobId : m_jobsByClip.at(id)) {
-            if (!m_jobs.at(jobId)->m_future.isFinished() && !m_jobs.at(jobId)->m_future.isCanceled()) {
+            if (isActive(m_jobs.at(jobId))) {
                 if (type == AbstractClipJob::NOJOBTYPE || m_jobs.at(jobId)->m_type == type) {
                     return jobId;
                 }
@@ -67,7 +74,7 @@ std::vector<int> JobManager::getPendingJobsIds(const QString &id, AbstractClipJo
     std::vector<int> result;
     if (m_jobsByClip.count(id) > 0) {
         for (int jobId : m_jobsByClip.at(id)) {
-            if (!m_jobs.at(jobId)->m_future.isFinished() && !m_jobs.at(jobId)->m_future.isCanceled()) {
+            if (isActive(m_jobs.at(jobId))) {
                 if (type == AbstractClipJob::NOJOBTYPE || m_jobs.at(jobId)->m_type == type) {
                     result.push_back(jobId);
                 }
@@ -83,7 +90,7 @@ std::vector<int> JobManager::getFinishedJobsIds(const QString &id, AbstractClipJ
     std::vector<int> result;
     if (m_jobsByClip.count(id) > 0) {
         for (int jobId : m_jobsByClip.at(id)) {
-            if (m_jobs.at(jobId)->m_future.isFinished() || m_jobs.at(jobId)->m_future.isCanceled()) {
+            if (!isActive(m_jobs.at(jobId))) {
                 if (type == AbstractClipJob::NOJOBTYPE || m_jobs.at(jobId)->m_type == type) {
                     result.push_back(jobId);
                 }
@@ -101,10 +108,7 @@ void JobManager::discardJobs(const QString &binId, AbstractClipJob::JOBTYPE type
     }
     for (int jobId : m_jobsByClip.at(binId)) {
         if (type == AbstractClipJob::NOJOBTYPE || m_jobs.at(jobId)->m_type == type) {
-            for (const std::shared_ptr<AbstractClipJob> &job : m_jobs.at(jobId)->m_job) {
-                job->jobCanceled();
-            }
-            m_jobs.at(jobId)->m_future.cancel();
+            cancelJob(m_jobs.at(jobId));
         }
     }
 }
@@ -114,8 +118,7 @@ bool JobManager::hasPendingJob(const QString &clipId, AbstractClipJob::JOBTYPE t
     READ_LOCK();
     if (m_jobsByClip.count(clipId) > 0) {
         for (int jobId : m_jobsByClip.at(clipId)) {
-            if ((type == AbstractClipJob::NOJOBTYPE || m_jobs.at(jobId)->m_type == type) && !m_jobs.at(jobId)->m_future.isFinished() &&
-                !m_jobs.at(jobId)->m_future.isCanceled()) {
+            if ((type == AbstractClipJob::NOJOBTYPE || m_jobs.at(jobId)->m_type == type) && isActive(m_jobs.at(jobId))) {
                 if (foundId) {
                     *foundId = jobId;
                 }
@@ -134,13 +137,8 @@ void JobManager::updateJobCount()
     READ_LOCK();
     int count = 0;
     for (const auto &j : m_jobs) {
-        if (!j.second->m_future.isFinished() && !j.second->m_future.isCanceled()) {
+        if (isActive(j.second)) {
             count++;
-            /*for (int i = 0; i < j.second->m_future.future().resultCount(); ++i) {
-                if (j.second->m_future.future().isResultReadyAt(i)) {
-                    count++;
-                }
-            }*/
         }
     }
     // Set jobs count
@@ -187,10 +185,7 @@ void JobManager::slotDiscardClipJobs(const QString &binId)
     if (m_jobsByClip.count(binId) > 0) {
         for (int jobId : m_jobsByClip.at(binId)) {
             Q_ASSERT(m_jobs.count(jobId) > 0);
-            for (const std::shared_ptr<AbstractClipJob> &job : m_jobs.at(jobId)->m_job) {
-                job->jobCanceled();
-            }
-            m_jobs[jobId]->m_future.cancel();
+            cancelJob(m_jobs.at(jobId));
         }
     }
 }
@@ -199,11 +194,8 @@ void JobManager::slotCancelPendingJobs()
 {
     QWriteLocker locker(&m_lock);
     for (const auto &j : m_jobs) {
-        if (!j.second->m_future.isStarted()) {
-            for (const std::shared_ptr<AbstractClipJob> &job : j.second->m_job) {
-                job->jobCanceled();
-            }
-            j.second->m_future.cancel();
+        if (j.second->m_status == JobManagerStatus::Pending) {
+            cancelJob(j.second);
         }
     }
 }
@@ -213,38 +205,17 @@ void JobManager::slotCancelJobs()
     QWriteLocker locker(&m_lock);
     for (const auto &j : m_jobs) {
         j.second->m_processed = true;
-        for (const std::shared_ptr<AbstractClipJob> &job : j.second->m_job) {
-            job->jobCanceled();
-        }
-        j.second->m_future.cancel();
+        cancelJob(j.second);
     }
 }
 
 void JobManager::createJob(const std::shared_ptr<Job_t> &job)
 {
-    /*
-    // This thread wait mechanism was broken and caused a race condition locking the application
-    // so I switched to a simpler model
-    bool ok = false;
-    // wait for parents to finish
-    while (!ok) {
-        ok = true;
-        for (int p : parents) {
-            if (!m_jobs[p]->m_completionMutex.tryLock()) {
-                ok = false;
-                qDebug()<<"********\nWAITING FOR JOB COMPLETION MUTEX!!: "<<job->m_id<<" : "<<m_jobs[p]->m_id<<"="<<m_jobs[p]->m_type;
-                break;
-            } else {
-                qDebug()<<">>>>>>>>>>\nJOB COMPLETION MUTEX DONE: "<<job->m_id;
-                m_jobs[p]->m_completionMutex.unlock();
-            }
-        }
-        if (!ok) {
-            QThread::msleep(10);
-        }
-    }*/
     // connect progress signals
     QReadLocker locker(&m_lock);
+    if (job->m_status != JobManagerStatus::Pending) {
+        return;
+    }
     for (const auto &it : job->m_indices) {
         size_t i = it.second;
         auto binId = it.first;
@@ -255,21 +226,58 @@ void JobManager::createJob(const std::shared_ptr<Job_t> &job)
             }
         });
     }
-    connect(&job->m_future, &QFutureWatcher<bool>::started, this, &JobManager::updateJobCount);
-    connect(&job->m_future, &QFutureWatcher<bool>::finished, [this, id = job->m_id]() { slotManageFinishedJob(id); });
-    connect(&job->m_future, &QFutureWatcher<bool>::canceled, [this, id = job->m_id]() { slotManageCanceledJob(id); });
-    job->m_actualFuture = QtConcurrent::mapped(job->m_job, AbstractClipJob::execute);
-    job->m_future.setFuture(job->m_actualFuture);
+    job->m_pendingTasks = int(job->m_job.size());
+    for (size_t i = 0; i < job->m_job.size(); ++i) {
+        m_scheduler->enqueue(job->m_id, job->m_type, [this, job, i]() {
+            JobManagerStatus status = JobManagerStatus::Pending;
+            if (job->m_status.compare_exchange_strong(status, JobManagerStatus::Running)) {
+                QMetaObject::invokeMethod(this, [this]() { updateJobCount(); }, Qt::QueuedConnection);
+                status = JobManagerStatus::Running;
+            }
+            if (status == JobManagerStatus::Running) {
+                job->m_results[i] = AbstractClipJob::execute(job->m_job[i]) ? 1 : 0;
+            }
+            if (job->m_pendingTasks.fetch_sub(1) == 1) {
+                // Last task of this job, results are processed in the main thread
+                status = JobManagerStatus::Running;
+                if (job->m_status.compare_exchange_strong(status, JobManagerStatus::Finished)) {
+                    QMetaObject::invokeMethod(this, [this, id = job->m_id]() { slotManageFinishedJob(id); }, Qt::QueuedConnection);
+                } else {
+                    QMetaObject::invokeMethod(this, [this, id = job->m_id]() { slotManageCanceledJob(id); }, Qt::QueuedConnection);
+                }
+            }
+        });
+    }
+}
 
-    // In the unlikely event that the job finished before the signal connection was made, we check manually for finish and cancel
-    /*if (job->m_future.isFinished()) {
-        //emit job->m_future.finished();
-        slotManageFinishedJob(job->m_id);
-    }
-    if (job->m_future.isCanceled()) {
-        //emit job->m_future.canceled();
-        slotManageCanceledJob(job->m_id);
-    }*/
+void JobManager::cancelJob(const std::shared_ptr<Job_t> &job)
+{
+    JobManagerStatus status = job->m_status;
+    do {
+        if (status != JobManagerStatus::Pending && status != JobManagerStatus::Running) {
+            return;
+        }
+    } while (!job->m_status.compare_exchange_weak(status, JobManagerStatus::Canceled));
+    for (const std::shared_ptr<AbstractClipJob> &j : job->m_job) {
+        j->jobCanceled();
+    }
+    int removed = m_scheduler->cancel(job->m_id);
+    // If tasks are still running, the last one will report the cancelation
+    if ((removed > 0 && job->m_pendingTasks.fetch_sub(removed) == removed) || job->m_pendingTasks == 0) {
+        QMetaObject::invokeMethod(this, [this, id = job->m_id]() { slotManageCanceledJob(id); }, Qt::QueuedConnection);
+    }
+}
+
+void JobManager::cancelChildJobs(int id)
+{
+    QWriteLocker locker(&m_lock);
+    if (m_jobsByParents.count(id) == 0) {
+        return;
+    }
+    for (int cid : m_jobsByParents[id]) {
+        cancelJob(m_jobs[cid]);
+    }
+    m_jobsByParents.erase(id);
 }
 
 void JobManager::slotManageCanceledJob(int id)
@@ -278,12 +286,12 @@ void JobManager::slotManageCanceledJob(int id)
     Q_ASSERT(m_jobs.count(id) > 0);
     if (m_jobs[id]->m_processed) return;
     m_jobs[id]->m_processed = true;
-    //m_jobs[id]->m_completionMutex.unlock(); // crashing on Windows
     // send notification to refresh view
     for (const auto &it : m_jobs[id]->m_indices) {
         pCore->projectItemModel()->onItemUpdated(it.first, AbstractProjectItem::JobStatus);
     }
-    // TODO: delete child jobs
+    locker.unlock();
+    cancelChildJobs(id);
     updateJobCount();
 }
 void JobManager::slotManageFinishedJob(int id)
@@ -298,16 +306,17 @@ void JobManager::slotManageFinishedJob(int id)
         pCore->projectItemModel()->onItemUpdated(it.first, AbstractProjectItem::JobStatus);
     }
     bool ok = true;
-    for (bool res : m_jobs[id]->m_future.future()) {
-        ok = ok && res;
+    for (char res : m_jobs[id]->m_results) {
+        ok = ok && res != 0;
     }
     Fun undo = []() { return true; };
     Fun redo = []() { return true; };
     if (!ok) {
         qDebug() << " * * * ** * * *\nWARNING + + +\nJOB NOT CORRECT FINISH: " << id <<"\n------------------------";
-        // TODO: delete child jobs
-        m_jobs[id]->m_completionMutex.unlock();
+        m_jobs[id]->m_processed = true;
+        m_jobs[id]->m_failed = true;
         locker.unlock();
+        cancelChildJobs(id);
         if (m_jobs.at(id)->m_type == AbstractClipJob::LOADJOB) {
             // loading failed, remove clip
             for (const auto &it : m_jobs[id]->m_indices) {
@@ -355,18 +364,21 @@ void JobManager::slotManageFinishedJob(int id)
             }
         }
     }
-    m_jobs[id]->m_completionMutex.unlock();
     if (ok && !m_jobs[id]->m_undoString.isEmpty()) {
         pCore->pushUndo(undo, redo, m_jobs[id]->m_undoString);
     }
-    if (m_jobsByParents.count(id) > 0) {
-        std::vector<int> children = m_jobsByParents[id];
-        for (int cid : children) {
-            if (!m_jobs[cid]->m_processed) {
-                QtConcurrent::run(this, &JobManager::createJob, m_jobs[cid]);
-            }
+    std::vector<int> children;
+    {
+        QWriteLocker writeLocker(&m_lock);
+        if (m_jobsByParents.count(id) > 0) {
+            children = m_jobsByParents[id];
+            m_jobsByParents.erase(id);
+        }
+    }
+    for (int cid : children) {
+        if (!m_jobs[cid]->m_processed) {
+            createJob(m_jobs[cid]);
         }
-        m_jobsByParents.erase(id);
     }
     updateJobCount();
 }
@@ -382,17 +394,7 @@ JobManagerStatus JobManager::getJobStatus(int jobId) const
 {
     READ_LOCK();
     Q_ASSERT(m_jobs.count(jobId) > 0);
-    auto job = m_jobs.at(jobId);
-    if (job->m_future.isFinished()) {
-        return JobManagerStatus::Finished;
-    }
-    if (job->m_future.isCanceled()) {
-        return JobManagerStatus::Canceled;
-    }
-    if (job->m_future.isRunning()) {
-        return JobManagerStatus::Running;
-    }
-    return JobManagerStatus::Pending;
+    return m_jobs.at(jobId)->m_status;
 }
 
 bool JobManager::jobSucceded(int jobId) const
@@ -403,6 +405,11 @@ bool JobManager::jobSucceded(int jobId) const
     return !job->m_failed;
 }
 
+std::map<AbstractClipJob::JOBTYPE, JobScheduler::TypeStats> JobManager::queueStats() const
+{
+    return m_scheduler->stats();
+}
+
 int JobManager::getJobProgressForClip(int jobId, const QString &binId) const
 {
     READ_LOCK();
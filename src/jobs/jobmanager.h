@@ -25,11 +25,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "abstractclipjob.h"
 #include "definitions.h"
+#include "jobscheduler.h"
 
 #include <QAbstractListModel>
-#include <QFutureWatcher>
 #include <QObject>
 #include <QReadWriteLock>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -50,13 +51,13 @@ struct Job_t
     std::vector<std::shared_ptr<AbstractClipJob>> m_job; // List of the jobs
     std::vector<int> m_progress;                         // progress of the job, for each clip
     std::unordered_map<QString, size_t> m_indices;       // keys are binIds, value are ids in the vectors m_job and m_progress;
-    QFutureWatcher<bool> m_future;                       // future of the job
-    QFuture<bool> m_actualFuture;
-    QMutex m_completionMutex; // mutex that is locked during execution of the process
+    std::vector<char> m_results;                         // result of the job, for each clip
+    std::atomic<JobManagerStatus> m_status{JobManagerStatus::Pending};
+    std::atomic<int> m_pendingTasks{0}; // number of clips that are queued or being processed in the scheduler
     AbstractClipJob::JOBTYPE m_type;
     QString m_undoString;
     int m_id;
-    bool m_processed = false; // flag that we set to true when we are done with this job
+    std::atomic<bool> m_processed{false}; // flag that we set to true when we are done with this job
     bool m_failed = false;    // flag that we set to true when a problem occurred
 };
 
@@ -121,6 +122,9 @@ public:
     /** @brief returns false if job failed */
     bool jobSucceded(int jobId) const;
 
+    /** @brief Returns the number of queued, running and processed tasks for each job type */
+    std::map<AbstractClipJob::JOBTYPE, JobScheduler::TypeStats> queueStats() const;
+
     /** @brief return the progress of a given job on a given clip */
     int getJobProgressForClip(int jobId, const QString &binId) const;
 
@@ -132,9 +136,12 @@ public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
 protected:
-    // Helper function to launch a given job.
-    // This has to be launched asynchrnously since it blocks until all parents are finished
+    // Helper function to launch a given job, once its parent is finished.
     void createJob(const std::shared_ptr<Job_t> &job);
+    // Mark a job as canceled and remove its queued tasks from the scheduler
+    void cancelJob(const std::shared_ptr<Job_t> &job);
+    // Cancel the jobs waiting for the given job
+    void cancelChildJobs(int id);
 
     void updateJobCount();
 
@@ -159,6 +166,8 @@ private:
     /** @brief List of all the jobs by clip. */
     std::unordered_map<QString, std::vector<int>> m_jobsByClip;
     std::unordered_map<int, std::vector<int>> m_jobsByParents;
+    /** @brief Thread pool running the job tasks, with priorities and concurrency limits per job type */
+    std::unique_ptr<JobScheduler> m_scheduler;
 
 signals:
     void jobCount(int);
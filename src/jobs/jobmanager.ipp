@@ -30,12 +30,12 @@ int JobManager::startJob(const std::vector<QString> &binIds, int parentId, QStri
     // QWriteLocker locker(&m_lock);
     int jobId = m_currentId++;
     std::shared_ptr<Job_t> job(new Job_t());
-    job->m_completionMutex.lock();
     job->m_undoString = std::move(undoString);
     job->m_id = jobId;
     for (const auto &id : binIds) {
         job->m_job.push_back(createFn(id, args...));
         job->m_progress.push_back(0);
+        job->m_results.push_back(0);
         job->m_indices[id] = size_t(int(job->m_job.size()) - 1);
         job->m_type = job->m_job.back()->jobType();
         m_jobsByClip[id].push_back(jobId);
@@ -46,15 +46,15 @@ int JobManager::startJob(const std::vector<QString> &binIds, int parentId, QStri
     Q_ASSERT(m_jobs.count(jobId) == 0);
     m_jobs[jobId] = job;
     endInsertRows();
-    m_lock.unlock();
-    if (parentId == -1 || m_jobs[parentId]->m_completionMutex.tryLock()) {
-        if (parentId != -1) {
-            m_jobs[parentId]->m_completionMutex.unlock();
-        }
-        QtConcurrent::run(this, &JobManager::createJob, job);
-    } else {
+    // The job is only handed to the scheduler once its parent is done, so that no thread is blocked waiting for it
+    bool waitForParent = parentId != -1 && m_jobs.count(parentId) > 0 && !m_jobs[parentId]->m_processed;
+    if (waitForParent) {
         m_jobsByParents[parentId].push_back(jobId);
     }
+    m_lock.unlock();
+    if (!waitForParent) {
+        createJob(job);
+    }
     return jobId;
 }
 
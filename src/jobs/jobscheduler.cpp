@@ -0,0 +1,187 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "jobscheduler.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+namespace {
+class TaskRunnable : public QRunnable
+{
+public:
+    explicit TaskRunnable(std::function<void()> fn)
+        : m_fn(std::move(fn))
+    {
+    }
+    void run() override { m_fn(); }
+
+private:
+    std::function<void()> m_fn;
+};
+
+// Types from this priority on are background work
+const int backgroundPriority = 3;
+} // namespace
+
+JobScheduler::JobScheduler(int maxThreads)
+    : m_running(0)
+    , m_backgroundRunning(0)
+{
+    m_pool.setMaxThreadCount(maxThreads > 0 ? maxThreads : qMax(2, QThread::idealThreadCount()));
+    // Heavy ffmpeg / melt processes, which use several cores each
+    setLimit(AbstractClipJob::PROXYJOB, 2);
+    setLimit(AbstractClipJob::TRANSCODEJOB, 1);
+    setLimit(AbstractClipJob::CUTJOB, 1);
+    setLimit(AbstractClipJob::SPEEDJOB, 1);
+    setLimit(AbstractClipJob::STABILIZEJOB, 1);
+    setLimit(AbstractClipJob::FILTERCLIPJOB, 1);
+    setLimit(AbstractClipJob::ANALYSECLIPJOB, 1);
+    setLimit(AbstractClipJob::AUDIOTHUMBJOB, 2);
+}
+
+JobScheduler::~JobScheduler()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queues.clear();
+    }
+    m_pool.waitForDone();
+}
+
+int JobScheduler::priority(AbstractClipJob::JOBTYPE type)
+{
+    switch (type) {
+    case AbstractClipJob::LOADJOB:
+        return 0;
+    case AbstractClipJob::THUMBJOB:
+    case AbstractClipJob::CACHEJOB:
+        return 1;
+    case AbstractClipJob::AUDIOTHUMBJOB:
+        return 2;
+    case AbstractClipJob::PROXYJOB:
+        return backgroundPriority;
+    default:
+        return backgroundPriority + 1;
+    }
+}
+
+int JobScheduler::maxThreads() const
+{
+    return m_pool.maxThreadCount();
+}
+
+void JobScheduler::setLimit(AbstractClipJob::JOBTYPE type, int maxRunning)
+{
+    QMutexLocker locker(&m_mutex);
+    m_limits[type] = maxRunning;
+    dispatch();
+}
+
+void JobScheduler::enqueue(int jobId, AbstractClipJob::JOBTYPE type, std::function<void()> task)
+{
+    QMutexLocker locker(&m_mutex);
+    m_queues[priority(type)].push_back({jobId, type, std::move(task)});
+    TypeStats &stats = m_stats[type];
+    stats.queued++;
+    stats.peakQueued = qMax(stats.peakQueued, stats.queued);
+    dispatch();
+}
+
+int JobScheduler::cancel(int jobId)
+{
+    QMutexLocker locker(&m_mutex);
+    int removed = 0;
+    for (auto &queue : m_queues) {
+        for (auto it = queue.second.begin(); it != queue.second.end();) {
+            if (it->jobId == jobId) {
+                m_stats[it->type].queued--;
+                it = queue.second.erase(it);
+                removed++;
+            } else {
+                ++it;
+            }
+        }
+    }
+    return removed;
+}
+
+bool JobScheduler::canStart(AbstractClipJob::JOBTYPE type) const
+{
+    if (m_running >= m_pool.maxThreadCount()) {
+        return false;
+    }
+    if (priority(type) >= backgroundPriority && m_backgroundRunning >= qMax(1, m_pool.maxThreadCount() - 1)) {
+        return false;
+    }
+    auto limit = m_limits.find(type);
+    if (limit == m_limits.end()) {
+        return true;
+    }
+    auto stats = m_stats.find(type);
+    return stats == m_stats.end() || stats->second.running < limit->second;
+}
+
+void JobScheduler::dispatch()
+{
+    for (auto &queue : m_queues) {
+        for (auto it = queue.second.begin(); it != queue.second.end() && m_running < m_pool.maxThreadCount();) {
+            if (!canStart(it->type)) {
+                ++it;
+                continue;
+            }
+            Task task = std::move(*it);
+            it = queue.second.erase(it);
+            TypeStats &stats = m_stats[task.type];
+            stats.queued--;
+            stats.running++;
+            m_running++;
+            if (priority(task.type) >= backgroundPriority) {
+                m_backgroundRunning++;
+            }
+            const AbstractClipJob::JOBTYPE type = task.type;
+            m_pool.start(new TaskRunnable([this, type, run = std::move(task.run)]() {
+                run();
+                taskFinished(type);
+            }));
+        }
+    }
+}
+
+void JobScheduler::taskFinished(AbstractClipJob::JOBTYPE type)
+{
+    QMutexLocker locker(&m_mutex);
+    TypeStats &stats = m_stats[type];
+    stats.running--;
+    stats.done++;
+    m_running--;
+    if (priority(type) >= backgroundPriority) {
+        m_backgroundRunning--;
+    }
+    dispatch();
+}
+
+std::map<AbstractClipJob::JOBTYPE, JobScheduler::TypeStats> JobScheduler::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,91 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef JOBSCHEDULER_H
+#define JOBSCHEDULER_H
+
+#include "abstractclipjob.h"
+
+#include <QMutex>
+#include <QThreadPool>
+#include <deque>
+#include <functional>
+#include <map>
+
+/**
+ * @class JobScheduler
+ * @brief Runs the clip job tasks on a dedicated thread pool.
+ * Tasks are started by priority of their job type (clip loading first, long transcoding last), and each job type
+ * can be limited to a number of concurrent tasks. Background types (proxy, transcode, ...) never take the last worker,
+ * so that loading clips and thumbnails can always start.
+ * Tasks are only queued when they can start, waiting for parent jobs is handled by the JobManager.
+ */
+class JobScheduler
+{
+public:
+    /** @brief Queue depth statistics for one job type */
+    struct TypeStats
+    {
+        int queued = 0;
+        int running = 0;
+        int peakQueued = 0;
+        int done = 0;
+    };
+
+    explicit JobScheduler(int maxThreads = -1);
+    ~JobScheduler();
+
+    /** @brief Queue a task of a job. The task runs in a worker thread */
+    void enqueue(int jobId, AbstractClipJob::JOBTYPE type, std::function<void()> task);
+    /** @brief Remove the queued tasks of a job, running tasks are not affected. Returns the number of removed tasks */
+    int cancel(int jobId);
+
+    /** @brief Set the maximum number of tasks of a type running at the same time */
+    void setLimit(AbstractClipJob::JOBTYPE type, int maxRunning);
+    /** @brief Returns the priority of a job type, lower value means it is started first */
+    static int priority(AbstractClipJob::JOBTYPE type);
+
+    std::map<AbstractClipJob::JOBTYPE, TypeStats> stats() const;
+    int maxThreads() const;
+
+private:
+    struct Task
+    {
+        int jobId;
+        AbstractClipJob::JOBTYPE type;
+        std::function<void()> run;
+    };
+    mutable QMutex m_mutex;
+    QThreadPool m_pool;
+    /** @brief Queued tasks, by priority */
+    std::map<int, std::deque<Task>> m_queues;
+    std::map<AbstractClipJob::JOBTYPE, TypeStats> m_stats;
+    std::map<AbstractClipJob::JOBTYPE, int> m_limits;
+    int m_running;
+    int m_backgroundRunning;
+
+    /** @brief Start as many queued tasks as the limits allow. m_mutex must be locked */
+    void dispatch();
+    bool canStart(AbstractClipJob::JOBTYPE type) const;
+    void taskFinished(AbstractClipJob::JOBTYPE type);
+};
+
+#endif
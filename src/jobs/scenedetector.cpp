@@ -0,0 +1,242 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scenedetector.hpp"
+
+#include <QMutex>
+#include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtConcurrent>
+#include <cstring>
+#include <mlt++/MltFrame.h>
+#include <mlt++/MltProducer.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DETECTOR_SSE2
+#endif
+
+namespace {
+// Below this, opening one more producer costs more than it saves
+const int minFramesPerSegment = 250;
+
+// Size of the analysed images, cuts are obvious even at this size
+const int analysisWidth = 128;
+const int analysisHeight = 72;
+
+// A cut needs both the distribution of luma (0 to 1) and the pixels (mean absolute difference, 0 to 255) to change.
+// The histogram alone misses cuts between shots of similar tones, the pixels alone fire on fast camera moves
+const double histogramThreshold = 0.3;
+const double sadThreshold = 20.;
+
+struct LumaFrame
+{
+    std::vector<uchar> luma;
+    quint32 bins[SceneDetector::histogramBins];
+};
+
+bool readFrame(Mlt::Producer &producer, int position, LumaFrame &result)
+{
+    producer.seek(position);
+    QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+    if (frame == nullptr || !frame->is_valid()) {
+        return false;
+    }
+    frame->set("deinterlace_method", "onefield");
+    frame->set("top_field_first", -1);
+    frame->set("rescale.interp", "nearest");
+    mlt_image_format format = mlt_image_yuv422;
+    int width = analysisWidth;
+    int height = analysisHeight;
+    const uchar *image = frame->get_image(format, width, height);
+    if (image == nullptr || format != mlt_image_yuv422 || width <= 0 || height <= 0) {
+        return false;
+    }
+    const int pixels = width * height;
+    result.luma.resize(size_t(pixels));
+    SceneDetector::extractLuma(image, pixels, result.luma.data());
+    SceneDetector::histogram(result.luma.data(), pixels, result.bins);
+    return true;
+}
+
+bool isCut(const LumaFrame &previous, const LumaFrame &current)
+{
+    if (previous.luma.size() != current.luma.size() || current.luma.empty()) {
+        return false;
+    }
+    const int count = int(current.luma.size());
+    quint64 histogramDiff = 0;
+    for (int i = 0; i < SceneDetector::histogramBins; ++i) {
+        histogramDiff += quint64(qAbs(qint64(previous.bins[i]) - qint64(current.bins[i])));
+    }
+    if (double(histogramDiff) / (2. * count) < histogramThreshold) {
+        return false;
+    }
+    return double(SceneDetector::sad(previous.luma.data(), current.luma.data(), count)) / count >= sadThreshold;
+}
+
+// Compares each frame of ]start, end] with its predecessor, calling @param onFrame (if set) after each frame
+std::vector<int> detectSegment(Mlt::Producer &producer, int start, int end, std::atomic<int> &processed, const std::atomic<bool> &canceled,
+                               const std::function<void()> &onFrame)
+{
+    std::vector<int> cuts;
+    LumaFrame previous;
+    LumaFrame current;
+    bool hasPrevious = readFrame(producer, start, previous);
+    for (int position = start + 1; position <= end && !canceled; ++position) {
+        bool valid = readFrame(producer, position, current);
+        if (valid && hasPrevious && isCut(previous, current)) {
+            cuts.push_back(position);
+        }
+        std::swap(previous, current);
+        hasPrevious = valid;
+        processed++;
+        if (onFrame) {
+            onFrame();
+        }
+    }
+    return cuts;
+}
+} // namespace
+
+void SceneDetector::extractLuma(const uchar *yuyv, int pixels, uchar *luma)
+{
+    int x = 0;
+#ifdef DETECTOR_SSE2
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    for (; x + 16 <= pixels; x += 16) {
+        __m128i first = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(yuyv + 2 * x)), mask);
+        __m128i second = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(yuyv + 2 * x + 16)), mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(luma + x), _mm_packus_epi16(first, second));
+    }
+#endif
+    for (; x < pixels; ++x) {
+        luma[x] = yuyv[2 * x];
+    }
+}
+
+quint64 SceneDetector::sad(const uchar *a, const uchar *b, int count)
+{
+    quint64 total = 0;
+    int i = 0;
+#ifdef DETECTOR_SSE2
+    __m128i sum = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(va, vb));
+    }
+    quint64 lanes[2];
+    memcpy(lanes, &sum, sizeof(lanes));
+    total = lanes[0] + lanes[1];
+#endif
+    for (; i < count; ++i) {
+        total += quint64(qAbs(int(a[i]) - int(b[i])));
+    }
+    return total;
+}
+
+void SceneDetector::histogram(const uchar *luma, int count, quint32 *bins)
+{
+    // Interleaved sub histograms, so that consecutive equal values do not wait on each other
+    quint32 partial[4][histogramBins];
+    memset(partial, 0, sizeof(partial));
+    const int shift = 8 - 6; // 256 values in 64 bins
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        partial[0][luma[i] >> shift]++;
+        partial[1][luma[i + 1] >> shift]++;
+        partial[2][luma[i + 2] >> shift]++;
+        partial[3][luma[i + 3] >> shift]++;
+    }
+    for (; i < count; ++i) {
+        partial[0][luma[i] >> shift]++;
+    }
+    for (int bin = 0; bin < histogramBins; ++bin) {
+        bins[bin] = partial[0][bin] + partial[1][bin] + partial[2][bin] + partial[3][bin];
+    }
+}
+
+int SceneDetector::segmentCount(int frames)
+{
+    return qBound(1, frames / minFramesPerSegment, QThread::idealThreadCount());
+}
+
+std::vector<int> SceneDetector::detect(const std::function<std::unique_ptr<Mlt::Producer>()> &createProducer, int in, int out, int segments,
+                                       const std::function<void(int)> &progress, const std::atomic<bool> &canceled)
+{
+    const int frames = out - in + 1;
+    if (frames < 2) {
+        return {};
+    }
+    segments = qBound(1, segments, frames - 1);
+    std::atomic<int> processed{0};
+    std::vector<std::vector<int>> results(size_t(segments), std::vector<int>());
+    auto runSegment = [&](int segment, const std::function<void()> &onFrame) {
+        // A segment owns the frames [first, last] and starts one frame earlier to compare its first frame
+        int first = in + int(qint64(frames) * segment / segments);
+        int last = in + int(qint64(frames) * (segment + 1) / segments) - 1;
+        std::unique_ptr<Mlt::Producer> producer = createProducer();
+        if (producer == nullptr || !producer->is_valid()) {
+            return;
+        }
+        results[size_t(segment)] = detectSegment(*producer.get(), qMax(in, first - 1), last, processed, canceled, onFrame);
+    };
+    QMutex mutex;
+    QWaitCondition frameDone;
+    int running = segments - 1;
+    auto notify = [&]() {
+        QMutexLocker lock(&mutex);
+        frameDone.wakeAll();
+    };
+    // Our own pool, so that the segments neither wait for nor delay the jobs using the global one.
+    // Declared last so that it waits for its threads before the state they use is destroyed
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, segments - 1));
+    for (int segment = 1; segment < segments; ++segment) {
+        QtConcurrent::run(&pool, [&, segment]() {
+            runSegment(segment, notify);
+            QMutexLocker lock(&mutex);
+            running--;
+            frameDone.wakeAll();
+        });
+    }
+    // The calling thread takes the first segment, then reports the progress of the others as their frames are analysed
+    runSegment(0, [&]() { progress(processed); });
+    QMutexLocker lock(&mutex);
+    while (running > 0) {
+        frameDone.wait(&mutex);
+        lock.unlock();
+        progress(processed);
+        lock.relock();
+    }
+    lock.unlock();
+    progress(processed);
+
+    // Segments do not overlap in the frames they report, so merging keeps the order
+    std::vector<int> cuts;
+    for (const auto &segmentCuts : results) {
+        cuts.insert(cuts.end(), segmentCuts.begin(), segmentCuts.end());
+    }
+    return cuts;
+}
@@ -0,0 +1,71 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Mlt {
+class Producer;
+}
+
+/**
+  Scene change detection on downscaled luma.
+
+  Each frame is decoded at a small size and compared with the previous one: a
+  cut is reported when both the luma histograms and the pixels (sum of absolute
+  differences) changed enough. The kernels use SSE2 on x86 with a scalar
+  fallback giving the same results.
+  The clip is split in segments processed concurrently, each one by its own
+  producer. A segment starts decoding one frame before its range so that its
+  first frame can be compared too, which makes the result independent of the
+  number of segments.
+ */
+namespace SceneDetector {
+
+/** @brief Number of bins of the luma histograms */
+const int histogramBins = 64;
+
+/** @brief Writes the luma of @param pixels packed YUYV pixels */
+void extractLuma(const uchar *yuyv, int pixels, uchar *luma);
+
+/** @brief Returns the sum of absolute differences of two luma planes of @param count pixels */
+quint64 sad(const uchar *a, const uchar *b, int count);
+
+/** @brief Fills @param bins (histogramBins entries) with the histogram of @param count luma values */
+void histogram(const uchar *luma, int count, quint32 *bins);
+
+/** @brief Returns the number of segments to use for a clip of @param frames frames */
+int segmentCount(int frames);
+
+/** @brief Returns the frames of the [@param in, @param out] range starting a new scene.
+    @param createProducer is called once per segment, from the thread processing it
+    @param progress receives the number of analysed frames, it is only called from the calling thread
+    @param canceled is checked between frames, the result is incomplete if it was set
+*/
+std::vector<int> detect(const std::function<std::unique_ptr<Mlt::Producer>()> &createProducer, int in, int out, int segments,
+                        const std::function<void(int)> &progress, const std::atomic<bool> &canceled);
+
+} // namespace SceneDetector
@@ -30,7 +30,9 @@
 #include "core.h"
 #include "jobmanager.h"
 #include "kdenlivesettings.h"
+#include "profiles/profilemodel.hpp"
 #include "project/clipstabilize.h"
+#include "scenedetector.hpp"
 #include "ui_scenecutdialog_ui.h"
 
 #include <QScopedPointer>
@@ -38,46 +40,70 @@
 #include <mlt++/Mlt.h>
 
 SceneSplitJob::SceneSplitJob(const QString &binId, bool subClips, int markersType, int minInterval)
-    : MeltJob(binId, STABILIZEJOB, true, -1, -1)
+    : AbstractClipJob(STABILIZEJOB, binId)
     , m_subClips(subClips)
     , m_markersType(markersType)
     , m_minInterval(minInterval)
 {
+    connect(this, &SceneSplitJob::jobCanceled, [this]() { m_canceled = true; });
 }
 
 const QString SceneSplitJob::getDescription() const
 {
     return i18n("Scene split");
 }
-void SceneSplitJob::configureConsumer()
+bool SceneSplitJob::startJob()
 {
-    m_consumer = std::make_unique<Mlt::Consumer>(*m_profile.get(), "null");
-    m_consumer->set("all", 1);
-    m_consumer->set("terminate_on_pause", 1);
-    m_consumer->set("real_time", -KdenliveSettings::mltthreads());
-    // We just want to find scene change, set all methods to the fastests
-    m_consumer->set("rescale", "nearest");
-    m_consumer->set("deinterlace_method", "onefield");
-    m_consumer->set("top_field_first", -1);
-}
-
-void SceneSplitJob::configureFilter()
-{
-    m_filter = std::make_unique<Mlt::Filter>(*m_profile.get(), "motion_est");
-    if ((m_filter == nullptr) || !m_filter->is_valid()) {
-        m_errorMessage.append(i18n("Cannot create filter motion_est. Cannot split scenes"));
-        return;
+    auto binClip = pCore->projectItemModel()->getClipByBinID(m_clipId);
+    if (binClip) {
+        m_url = binClip->url();
     }
+    if (m_url.isEmpty()) {
+        m_errorMessage.append(i18n("No producer for this clip."));
+        m_done = true;
+        return false;
+    }
+    auto createProducer = [this]() {
+        auto producer = std::make_unique<Mlt::Producer>(*m_profile.get(), m_url.toUtf8().constData());
+        // Only the images are analysed
+        producer->set("audio_index", -1);
+        return producer;
+    };
+    m_profile.reset(new Mlt::Profile());
+    m_profile->set_explicit(0);
+    std::unique_ptr<Mlt::Producer> producer = createProducer();
+    if (producer->is_valid()) {
+        m_profile->from_producer(*producer.get());
+        m_profile->set_explicit(1);
+        // Force the project frame rate, so that the positions match the bin clip
+        auto &projectProfile = pCore->getCurrentProfile();
+        if (!qFuzzyCompare(m_profile->fps(), projectProfile->fps())) {
+            m_profile->set_frame_rate(projectProfile->frame_rate_num(), projectProfile->frame_rate_den());
+            producer = createProducer();
+        }
+    }
+    if (!producer->is_valid()) {
+        m_errorMessage.append(i18n("Invalid clip"));
+        m_done = true;
+        return false;
+    }
+    int in = m_inPoint == -1 ? 0 : m_inPoint;
+    int out = m_outPoint == -1 ? producer->get_length() - 1 : m_outPoint;
+    producer.reset();
 
-    m_filter->set("shot_change_list", 0);
-    m_filter->set("denoise", 0);
-    m_filter->set_in_and_out(0, length - 1);
-}
-
-void SceneSplitJob::configureProfile()
-{
-    m_profile->set_height(160);
-    m_profile->set_width(m_profile->height() * m_profile->sar());
+    const int frames = qMax(1, out - in);
+    int lastProgress = -1;
+    auto progress = [&](int processed) {
+        int percent = int(100 * qint64(processed) / frames);
+        if (percent != lastProgress) {
+            lastProgress = percent;
+            emit jobProgress(percent);
+        }
+    };
+    m_cuts = SceneDetector::detect(createProducer, in, out, SceneDetector::segmentCount(out - in + 1), progress, m_canceled);
+    m_done = true;
+    m_successful = !m_canceled;
+    return m_successful;
 }
 
 // static
@@ -118,21 +144,16 @@ bool SceneSplitJob::commitResult(Fun &undo, Fun &redo)
     if (!m_successful) {
         return false;
     }
-    QString result = QString::fromLatin1(m_filter->get("shot_change_list"));
-    if (result.isEmpty()) {
-        m_errorMessage.append(i18n("No data returned from clip analysis"));
+    auto binClip = pCore->projectItemModel()->getClipByBinID(m_clipId);
+    if (!binClip) {
         return false;
     }
-
-    auto binClip = pCore->projectItemModel()->getClipByBinID(m_clipId);
-    QStringList markerData = result.split(QLatin1Char(';'));
     if (m_markersType >= 0) {
         // Build json data for markers
         QJsonArray list;
         int ix = 1;
         int lastCut = 0;
-        for (const QString &marker : markerData) {
-            int pos = marker.section(QLatin1Char('='), 0, 0).toInt();
+        for (int pos : m_cuts) {
             if (m_minInterval > 0 && ix > 1 && pos - lastCut < m_minInterval) {
                 continue;
             }
@@ -153,9 +174,7 @@ bool SceneSplitJob::commitResult(Fun &undo, Fun &redo)
         int lastCut = 0;
         QMap<QString, QString> zoneData;
         QJsonArray list;
-        QJsonDocument json(list);
-        for (const QString &marker : markerData) {
-            int pos = marker.section(QLatin1Char('='), 0, 0).toInt();
+        for (int pos : m_cuts) {
             if (pos <= lastCut + 1 || pos - lastCut < m_minInterval) {
                 continue;
             }
@@ -167,12 +186,11 @@ bool SceneSplitJob::commitResult(Fun &undo, Fun &redo)
             lastCut = pos;
             ix++;
         }
-        if (!json.isEmpty()) {
+        QJsonDocument json(list);
+        if (!list.isEmpty()) {
             pCore->projectItemModel()->loadSubClips(m_clipId, QString(json.toJson()), undo, redo);
         }
     }
-    qDebug() << "RESULT of the SCENESPLIT filter:" << result;
-
-    // TODO refac: reimplement add markers and subclips
+    qDebug() << "Scene split found" << m_cuts.size() << "cuts";
     return true;
 }
@@ -23,18 +23,23 @@
 
 #pragma once
 
-#include "meltjob.h"
-#include <unordered_map>
-#include <unordered_set>
+#include "abstractclipjob.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Mlt {
+class Profile;
+}
 
 /**
  * @class SceneSplitJob
- * @brief Detects the scenes of a clip using a mlt filter
+ * @brief Detects the scenes of a clip using the built-in scene detector
  *
  */
 
 class JobManager;
-class SceneSplitJob : public MeltJob
+class SceneSplitJob : public AbstractClipJob
 {
     Q_OBJECT
 
@@ -50,18 +55,17 @@ public:
     // Then the job is automatically put in queue. Its id is returned
     static int prepareJob(const std::shared_ptr<JobManager> &ptr, const std::vector<QString> &binIds, int parentId, QString undoString);
 
+    bool startJob() override;
     bool commitResult(Fun &undo, Fun &redo) override;
     const QString getDescription() const override;
 
 protected:
-    // @brief create and configure consumer
-    void configureConsumer() override;
-
-    // @brief create and configure filter
-    void configureFilter() override;
-
-    // @brief extra configuration of the profile (eg: resize the profile)
-    void configureProfile() override;
+    std::shared_ptr<Mlt::Profile> m_profile;
+    QString m_url;
+    bool m_done{false}, m_successful{false};
+    std::atomic<bool> m_canceled{false};
+    // @brief first frame of each detected scene, except the first one
+    std::vector<int> m_cuts;
 
     bool m_subClips;
     int m_markersType;
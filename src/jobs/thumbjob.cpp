@@ -96,7 +96,7 @@ bool ThumbJob::startJob()
         m_inCache = true;
         return true;
     }
-    m_prod = m_binClip->thumbProducer();
+    m_prod = m_binClip->thumbProducer(m_frameNumber);
     if ((m_prod == nullptr) || !m_prod->is_valid()) {
         qDebug() << "********\nCOULD NOT READ THUMB PRODUCER\n********";
         return false;
@@ -104,17 +104,22 @@ bool ThumbJob::startJob()
     int max = m_prod->get_length();
     m_frameNumber = m_binClip->clipType() == ClipType::Image ? 0 : qMin(m_frameNumber, max - 1);
 
-    if (m_frameNumber > 0) {
-        m_prod->seek(m_frameNumber);
-    }
+    // The pooled producer may have been left anywhere by its previous user
+    m_prod->seek(m_frameNumber);
     QScopedPointer<Mlt::Frame> frame(m_prod->get_frame());
-    frame->set("deinterlace_method", "onefield");
-    frame->set("top_field_first", -1);
-    frame->set("rescale.interp", "nearest");
-    if ((frame != nullptr) && frame->is_valid()) {
+    bool valid = (frame != nullptr) && frame->is_valid();
+    // Record the decoded position, the pool hands this producer to the requests that can decode forward from there
+    m_prod->set("_kdenlive_decoded", valid ? m_frameNumber : -1);
+    if (valid) {
+        frame->set("deinterlace_method", "onefield");
+        frame->set("top_field_first", -1);
+        frame->set("rescale.interp", "nearest");
         m_result = KThumb::getFrame(frame.data(), m_imageWidth, m_imageHeight, m_fullWidth);
         m_done = true;
     }
+    // Return the producer to the pool
+    frame.reset();
+    m_prod.reset();
     return m_done;
 }
 
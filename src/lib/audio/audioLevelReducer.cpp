@@ -0,0 +1,95 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of kdenlive. See www.kdenlive.org.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+*/
+
+#include "audioLevelReducer.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+AudioLevelReducer::AudioLevelReducer(int channels, int frequency, double fps)
+    : m_channels(qMax(1, channels))
+    , m_samplesPerFrame(fps > 0 ? frequency / fps : frequency / 25.)
+    , m_nextFrameSample(qMax<qint64>(1, qint64(m_samplesPerFrame)))
+    , m_sums((size_t)m_channels, 0)
+{
+}
+
+void AudioLevelReducer::addData(const QByteArray &data)
+{
+    const int frameBytes = 2 * m_channels;
+    const char *raw = data.constData();
+    int size = data.size();
+    if (!m_pending.isEmpty()) {
+        // Complete the sample left over from the previous chunk
+        int missing = qMin(frameBytes - m_pending.size(), size);
+        m_pending.append(raw, missing);
+        raw += missing;
+        size -= missing;
+        if (m_pending.size() < frameBytes) {
+            return;
+        }
+        QByteArray sample = m_pending;
+        m_pending.clear();
+        addData(sample);
+    }
+    int complete = size - size % frameBytes;
+    qint16 sample;
+    for (int offset = 0; offset < complete; offset += frameBytes) {
+        for (int k = 0; k < m_channels; ++k) {
+            memcpy(&sample, raw + offset + 2 * k, 2);
+            m_sums[(size_t)k] += std::abs((int)sample);
+        }
+        m_count++;
+        if (++m_sampleIndex >= m_nextFrameSample) {
+            closeFrame();
+        }
+    }
+    if (complete < size) {
+        m_pending = QByteArray(raw + complete, size - complete);
+    }
+}
+
+void AudioLevelReducer::closeFrame()
+{
+    for (long &sum : m_sums) {
+        long level = m_count > 0 ? sum / m_count : 0;
+        m_maxLevel = qMax(m_maxLevel, level);
+        m_levels << level;
+        sum = 0;
+    }
+    m_count = 0;
+    m_frameCount++;
+    m_nextFrameSample = qint64((m_frameCount + 1) * m_samplesPerFrame);
+}
+
+void AudioLevelReducer::finish()
+{
+    if (m_count > 0) {
+        closeFrame();
+    }
+    m_pending.clear();
+}
+
+int AudioLevelReducer::frameCount() const
+{
+    return m_frameCount;
+}
+
+QVector<uint8_t> AudioLevelReducer::levels() const
+{
+    QVector<uint8_t> result;
+    result.reserve(m_levels.size());
+    for (long v : m_levels) {
+        result << (uint8_t)(255 * v / m_maxLevel);
+    }
+    return result;
+}
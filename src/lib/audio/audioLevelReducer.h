@@ -0,0 +1,51 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of kdenlive. See www.kdenlive.org.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+*/
+
+#ifndef AUDIOLEVELREDUCER_H
+#define AUDIOLEVELREDUCER_H
+
+#include <QByteArray>
+#include <QVector>
+#include <vector>
+
+/**
+ * @class AudioLevelReducer
+ * @brief Reduces a stream of interleaved signed 16 bit PCM samples to one level per channel and per video frame.
+ * Data can be fed in chunks of any size as it arrives, so that the memory use doesn't depend on the duration of the audio.
+ */
+class AudioLevelReducer
+{
+public:
+    AudioLevelReducer(int channels, int frequency, double fps);
+
+    /** @brief Feed interleaved s16le samples. Incomplete samples are kept until the next call */
+    void addData(const QByteArray &data);
+    /** @brief Computes the level of the last, incomplete frame */
+    void finish();
+    /** @brief Returns the number of frames for which a level is available */
+    int frameCount() const;
+    /** @brief Returns the levels interleaved by channel, normalized between 0 and 255 against the loudest frame */
+    QVector<uint8_t> levels() const;
+
+private:
+    int m_channels;
+    double m_samplesPerFrame;
+    qint64 m_sampleIndex{0};
+    qint64 m_nextFrameSample;
+    int m_frameCount{0};
+    long m_count{0};
+    long m_maxLevel{1};
+    std::vector<long> m_sums;
+    QVector<long> m_levels;
+    QByteArray m_pending;
+    void closeFrame();
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of kdenlive. See www.kdenlive.org.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+*/
+
+#include "audioPeakFile.h"
+
+#include <QDataStream>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const char peakMagic[4] = {'K', 'P', 'K', 'S'};
+const quint32 peakVersion = 1;
+const int bucketSizes[] = {1, 16, 256};
+const int mainHeaderSize = 20;
+const int levelHeaderSize = 16;
+} // namespace
+
+AudioPeakFile::~AudioPeakFile() = default;
+
+bool AudioPeakFile::write(const QString &path, const QVector<uint8_t> &levels, int channels)
+{
+    if (channels <= 0 || levels.size() < channels) {
+        return false;
+    }
+    const int frames = levels.size() / channels;
+    const int levelCount = int(sizeof(bucketSizes) / sizeof(int));
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData(peakMagic, 4);
+    stream << peakVersion << quint32(channels) << quint32(frames) << quint32(levelCount);
+    quint64 offset = mainHeaderSize + levelCount * levelHeaderSize;
+    for (int size : bucketSizes) {
+        quint32 buckets = quint32((frames + size - 1) / size);
+        stream << quint32(size) << buckets << offset;
+        offset += quint64(buckets) * quint64(channels) * 2;
+    }
+    QByteArray data;
+    for (int size : bucketSizes) {
+        const int buckets = (frames + size - 1) / size;
+        data.resize(buckets * channels * 2);
+        auto *out = reinterpret_cast<uint8_t *>(data.data());
+        for (int b = 0; b < buckets; ++b) {
+            const int last = qMin(frames, (b + 1) * size);
+            for (int c = 0; c < channels; ++c) {
+                uint8_t minLevel = 255;
+                uint8_t maxLevel = 0;
+                for (int f = b * size; f < last; ++f) {
+                    uint8_t v = levels.at(f * channels + c);
+                    minLevel = qMin(minLevel, v);
+                    maxLevel = qMax(maxLevel, v);
+                }
+                *out++ = minLevel;
+                *out++ = maxLevel;
+            }
+        }
+        stream.writeRawData(data.constData(), data.size());
+    }
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+std::shared_ptr<AudioPeakFile> AudioPeakFile::open(const QString &path)
+{
+    std::shared_ptr<AudioPeakFile> peaks(new AudioPeakFile());
+    peaks->m_file.setFileName(path);
+    if (!peaks->m_file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    const qint64 size = peaks->m_file.size();
+    if (size < mainHeaderSize) {
+        return nullptr;
+    }
+    const uchar *data = peaks->m_file.map(0, size);
+    if (data == nullptr || memcmp(data, peakMagic, 4) != 0 || qFromLittleEndian<quint32>(data + 4) != peakVersion) {
+        return nullptr;
+    }
+    peaks->m_channels = int(qFromLittleEndian<quint32>(data + 8));
+    peaks->m_frames = int(qFromLittleEndian<quint32>(data + 12));
+    const int levelCount = int(qFromLittleEndian<quint32>(data + 16));
+    if (peaks->m_channels <= 0 || levelCount <= 0 || size < mainHeaderSize + levelCount * levelHeaderSize) {
+        return nullptr;
+    }
+    for (int i = 0; i < levelCount; ++i) {
+        const uchar *header = data + mainHeaderSize + i * levelHeaderSize;
+        Level level;
+        level.framesPerBucket = int(qFromLittleEndian<quint32>(header));
+        level.bucketCount = int(qFromLittleEndian<quint32>(header + 4));
+        const quint64 offset = qFromLittleEndian<quint64>(header + 8);
+        if (level.framesPerBucket <= 0 || offset + quint64(level.bucketCount) * quint64(peaks->m_channels) * 2 > quint64(size)) {
+            return nullptr;
+        }
+        level.data = data + offset;
+        peaks->m_levels.push_back(level);
+    }
+    return peaks;
+}
+
+int AudioPeakFile::channels() const
+{
+    return m_channels;
+}
+
+int AudioPeakFile::frameCount() const
+{
+    return m_frames;
+}
+
+int AudioPeakFile::levelForSpan(double framesPerPixel) const
+{
+    int result = 0;
+    for (size_t i = 0; i < m_levels.size(); ++i) {
+        if (m_levels[i].framesPerBucket <= framesPerPixel) {
+            result = int(i);
+        }
+    }
+    return result;
+}
+
+uint8_t AudioPeakFile::peak(int level, int channel, int firstFrame, int lastFrame) const
+{
+    if (level < 0 || level >= int(m_levels.size()) || channel < 0 || channel >= m_channels) {
+        return 0;
+    }
+    const Level &l = m_levels[size_t(level)];
+    if (lastFrame < firstFrame) {
+        std::swap(firstFrame, lastFrame);
+    }
+    const int firstBucket = qMax(0, firstFrame / l.framesPerBucket);
+    const int lastBucket = qMin(l.bucketCount - 1, lastFrame / l.framesPerBucket);
+    uint8_t result = 0;
+    for (int b = firstBucket; b <= lastBucket; ++b) {
+        result = qMax(result, l.data[(b * m_channels + channel) * 2 + 1]);
+    }
+    return result;
+}
+
+QVector<uint8_t> AudioPeakFile::levels() const
+{
+    QVector<uint8_t> result;
+    if (m_levels.empty() || m_levels.front().framesPerBucket != 1) {
+        return result;
+    }
+    const Level &l = m_levels.front();
+    result.reserve(l.bucketCount * m_channels);
+    for (int i = 0; i < l.bucketCount * m_channels; ++i) {
+        result << l.data[2 * i + 1];
+    }
+    return result;
+}
@@ -0,0 +1,62 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of kdenlive. See www.kdenlive.org.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+*/
+
+#ifndef AUDIOPEAKFILE_H
+#define AUDIOPEAKFILE_H
+
+#include <QFile>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+/**
+ * @class AudioPeakFile
+ * @brief Memory mapped, multi resolution audio levels of a clip.
+ * The file stores min/max pairs per channel for buckets of 1, 16 and 256 frames, so that the
+ * timeline can draw a waveform at any zoom level by reading only the buckets it displays.
+ *
+ * Layout (little endian): "KPKS", version, channels, frames, level count, then for each level
+ * its frames per bucket, bucket count and data offset. Level data is bucket major, then channel,
+ * each entry being a min byte followed by a max byte.
+ */
+class AudioPeakFile
+{
+public:
+    ~AudioPeakFile();
+
+    /** @brief Builds the peak pyramid from per frame @param levels (interleaved by channel) and saves it to @param path */
+    static bool write(const QString &path, const QVector<uint8_t> &levels, int channels);
+    /** @brief Maps an existing peak file, returns nullptr if the file is missing or invalid */
+    static std::shared_ptr<AudioPeakFile> open(const QString &path);
+
+    int channels() const;
+    int frameCount() const;
+    /** @brief Returns the coarsest level whose buckets are not larger than @param framesPerPixel */
+    int levelForSpan(double framesPerPixel) const;
+    /** @brief Returns the highest value of @param channel between @param firstFrame and @param lastFrame (included), read at @param level */
+    uint8_t peak(int level, int channel, int firstFrame, int lastFrame) const;
+    /** @brief Returns the full resolution levels, interleaved by channel */
+    QVector<uint8_t> levels() const;
+
+private:
+    AudioPeakFile() = default;
+    struct Level
+    {
+        int framesPerBucket;
+        int bucketCount;
+        const uchar *data;
+    };
+    QFile m_file;
+    int m_channels{0};
+    int m_frames{0};
+    std::vector<Level> m_levels;
+};
+
+#endif
@@ -72,6 +72,18 @@ reading a Read-protected property. In that case, we try to write lock it first (
         Q_ASSERT(false);                                                                                                                                       \
     }
 
+/* @brief Same as PUSH_UNDO, with the memory (in bytes) captured by the lambdas when it is known, see FunctionalUndoCommand::setSizeHint
+*/
+#define PUSH_UNDO_SIZED(undo, redo, text, size)                                                                                                                \
+    if (auto ptr = m_undoStack.lock()) {                                                                                                                       \
+        auto *command = new FunctionalUndoCommand(undo, redo, text);                                                                                           \
+        command->setSizeHint(size);                                                                                                                            \
+        ptr->push(command);                                                                                                                                    \
+    } else {                                                                                                                                                   \
+        qDebug() << "ERROR : unable to access undo stack";                                                                                                     \
+        Q_ASSERT(false);                                                                                                                                       \
+    }
+
 /* @brief This macro takes as parameter one atomic operation and its reverse, and update
    the undo and redo functional stacks/queue accordingly
    This should be used in the rare case where we don't need a lock mutex. In general, prefer the other version
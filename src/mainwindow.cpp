@@ -84,6 +84,7 @@
 #include <KConfigDialog>
 #include <KDualAction>
 #include <KEditToolBar>
+#include <KIO/Global>
 #include <KIconTheme>
 #include <KMessageBox>
 #include <KNotifyConfigWidget>
@@ -831,7 +832,7 @@ bool MainWindow::queryClose()
                 KMessageBox::warningYesNoCancel(this,
                                                 i18np("You have 1 rendering job waiting in the queue.\nWhat do you want to do with this job?",
                                                       "You have %1 rendering jobs waiting in the queue.\nWhat do you want to do with these jobs?", waitingJobs),
-                                                QString(), KGuiItem(i18n("Start them now")), KGuiItem(i18n("Delete them")))) {
+                                                QString(), KGuiItem(i18n("Start them now")), KGuiItem(i18n("Keep them for next session")))) {
             case KMessageBox::Yes:
                 // create script with waiting jobs and start it
                 if (!m_renderWidget->startWaitingRenderJobs()) {
@@ -839,7 +840,7 @@ bool MainWindow::queryClose()
                 }
                 break;
             case KMessageBox::No:
-                // Don't do anything, jobs will be deleted
+                // Don't do anything, the render queue is restored on next start
                 break;
             default:
                 return false;
@@ -2208,6 +2209,15 @@ void MainWindow::connectDocument()
     }
     m_zoomSlider->setValue(project->zoom().x());
     m_commandStack->setActiveStack(project->commandStack().get());
+    auto updateUndoUsage = [this](qint64 usage, qint64 budget) {
+        if (budget > 0) {
+            m_undoView->setToolTip(i18n("Undo history memory: %1 of %2", KIO::convertSize((KIO::filesize_t)usage), KIO::convertSize((KIO::filesize_t)budget)));
+        } else {
+            m_undoView->setToolTip(i18n("Undo history memory: %1", KIO::convertSize((KIO::filesize_t)usage)));
+        }
+    };
+    connect(project->commandStack().get(), &DocUndoStack::memoryUsageChanged, this, updateUndoUsage);
+    updateUndoUsage(project->commandStack()->memoryUsage(), project->commandStack()->memoryBudget());
 
     setWindowTitle(project->description());
     setWindowModified(project->isModified());
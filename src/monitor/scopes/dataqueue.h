@@ -19,10 +19,11 @@
 #ifndef DATAQUEUE_H
 #define DATAQUEUE_H
 
-#include <QList>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QWaitCondition>
+#include <atomic>
+#include <memory>
 
 /*!
   \class DataQueue
@@ -33,14 +34,18 @@
 
   DataQueue provides a limited size container for passing data between objects.
   One object can add data to the queue by calling push() while another object
-  can remove items from the queue by calling pop().
+  can remove items from the queue by calling pop() or tryPop().
 
   DataQueue provides configurable behavior for handling overflows. It can
   discard the oldest, discard the newest or block the object calling push()
   until room has been freed in the queue by another object calling pop().
 
-  DataQueue is threadsafe and is therefore most appropriate when passing data
-  between objects operating in different thread contexts.
+  DataQueue is a lock free ring buffer for a single producer and a single
+  consumer: pushing and popping only use atomic operations, a mutex is only
+  taken when one side has to sleep (empty queue in pop(), full queue in push()
+  with OverflowModeWait). Each item is owned by the slot holding it and slots
+  are handed over with atomic exchanges, so that when the producer discards
+  the oldest item while the consumer is reading it, exactly one of them gets it.
 */
 
 template <class T> class DataQueue
@@ -65,7 +70,7 @@ public:
     virtual ~DataQueue();
 
     /*!
-      Pushes an item into the queue.
+      Pushes an item into the queue. Must only be called from one thread at a time.
 
       If the queue is full and overflow mode is OverflowModeWait then this
       function will block until pop() is called.
@@ -73,83 +78,156 @@ public:
     void push(const T &item);
 
     /*!
-      Pops an item from the queue.
+      Pops an item from the queue. Must only be called from one thread at a time.
 
       If the queue is empty then this  function will block. If blocking is
-      undesired, then check the return of count() before calling pop().
+      undesired, use tryPop().
     */
     T pop();
 
+    /*!
+      Pops an item from the queue into \a item if there is one.
+
+      Returns false without blocking if the queue is empty.
+    */
+    bool tryPop(T &item);
+
     //! Returns the number of items in the queue.
     int count() const;
 
 private:
-    QList<T> m_queue;
+    struct Item
+    {
+        T value;
+        quint64 index;
+    };
+    std::unique_ptr<std::atomic<Item *>[]> m_slots;
     int m_maxSize;
     OverflowMode m_mode;
-    mutable QMutex m_mutex;
-    QWaitCondition m_notEmptyCondition;
-    QWaitCondition m_notFullCondition;
+    //! Index of the oldest item, advanced by the consumer, or by the producer when discarding the oldest item
+    std::atomic<quint64> m_head;
+    //! Index of the next pushed item, only written by the producer
+    std::atomic<quint64> m_tail;
+    //! Index following the last popped item, only used by the consumer
+    quint64 m_nextIndex;
+    //! Slow path, only used when one side sleeps
+    std::atomic<int> m_sleepers;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+
+    std::atomic<Item *> &slot(quint64 index) { return m_slots[index % quint64(m_maxSize)]; }
+    void wakeSleepers();
 };
 
 template <class T>
 DataQueue<T>::DataQueue(int maxSize, OverflowMode mode)
-    : m_queue()
-    , m_maxSize(maxSize)
+    : m_slots(new std::atomic<Item *>[size_t(qMax(1, maxSize))])
+    , m_maxSize(qMax(1, maxSize))
     , m_mode(mode)
+    , m_head(0)
+    , m_tail(0)
+    , m_nextIndex(0)
+    , m_sleepers(0)
     , m_mutex(QMutex::NonRecursive)
-    , m_notEmptyCondition()
-    , m_notFullCondition()
+    , m_condition()
 {
+    for (int i = 0; i < m_maxSize; ++i) {
+        m_slots[size_t(i)].store(nullptr);
+    }
 }
 
-template <class T> DataQueue<T>::~DataQueue() = default;
+template <class T> DataQueue<T>::~DataQueue()
+{
+    for (int i = 0; i < m_maxSize; ++i) {
+        delete m_slots[size_t(i)].exchange(nullptr);
+    }
+}
+
+template <class T> void DataQueue<T>::wakeSleepers()
+{
+    if (m_sleepers.load() > 0) {
+        QMutexLocker locker(&m_mutex);
+        m_condition.wakeAll();
+    }
+}
 
 template <class T> void DataQueue<T>::push(const T &item)
 {
-    m_mutex.lock();
-    if (m_queue.size() == m_maxSize) {
+    const quint64 tail = m_tail.load();
+    quint64 head = m_head.load();
+    if (tail - head >= quint64(m_maxSize)) {
         switch (m_mode) {
         case OverflowModeDiscardOldest:
-            m_queue.removeFirst();
-            m_queue.append(item);
+            // If the consumer advanced in the meantime there is room anyway
+            if (m_head.compare_exchange_strong(head, head + 1)) {
+                delete slot(head).exchange(nullptr);
+            }
             break;
         case OverflowModeDiscardNewest:
             // This item is the newest so discard it and exit
-            break;
+            return;
         case OverflowModeWait:
-            m_notFullCondition.wait(&m_mutex);
-            m_queue.append(item);
+            m_sleepers++;
+            {
+                QMutexLocker locker(&m_mutex);
+                while (tail - m_head.load() >= quint64(m_maxSize)) {
+                    m_condition.wait(&m_mutex);
+                }
+            }
+            m_sleepers--;
             break;
         }
-    } else {
-        m_queue.append(item);
-        if (m_queue.size() == 1) {
-            m_notEmptyCondition.wakeOne();
+    }
+    // The slot may still be in the hands of a consumer that lost the race with a discard, it will then hold nullptr
+    delete slot(tail).exchange(new Item{item, tail});
+    m_tail.store(tail + 1);
+    wakeSleepers();
+}
+
+template <class T> bool DataQueue<T>::tryPop(T &item)
+{
+    while (true) {
+        quint64 head = m_head.load();
+        if (head == m_tail.load()) {
+            return false;
+        }
+        std::unique_ptr<Item> taken(slot(head).exchange(nullptr));
+        // Fails if the producer discarded this item meanwhile, in which case we may have taken a newer one
+        m_head.compare_exchange_strong(head, head + 1);
+        if (!taken || taken->index < m_nextIndex) {
+            // Discarded, or older than what we already returned
+            continue;
+        }
+        m_nextIndex = taken->index + 1;
+        item = taken->value;
+        if (m_mode == OverflowModeWait) {
+            wakeSleepers();
         }
+        return true;
     }
-    m_mutex.unlock();
 }
 
 template <class T> T DataQueue<T>::pop()
 {
     T retVal;
-    m_mutex.lock();
-    if (m_queue.size() == 0) {
-        m_notEmptyCondition.wait(&m_mutex);
-    }
-    retVal = m_queue.takeFirst();
-    if (m_mode == OverflowModeWait && m_queue.size() == m_maxSize - 1) {
-        m_notFullCondition.wakeOne();
+    while (!tryPop(retVal)) {
+        m_sleepers++;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_head.load() == m_tail.load()) {
+                m_condition.wait(&m_mutex);
+            }
+        }
+        m_sleepers--;
     }
-    m_mutex.unlock();
     return retVal;
 }
 
 template <class T> int DataQueue<T>::count() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_queue.size();
+    // Read the head first, so that it cannot be ahead of the tail we read
+    const quint64 head = m_head.load();
+    return int(m_tail.load() - head);
 }
 
 #endif // DATAQUEUE_H
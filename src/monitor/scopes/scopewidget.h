@@ -38,7 +38,7 @@
 
   Frames are received by the onNewFrame() slot. The ScopeWidget automatically
   places new frames in the DataQueue (m_queue). Subclasses shall implement the
-  refreshScope() function and can check for new frames in m_queue.
+  refreshScope() function and can check for new frames in m_queue with tryPop().
 
   refreshScope() is run from a separate thread. Therefore, any members that are
   accessed by both the worker thread (refreshScope) and the GUI thread
@@ -320,6 +320,8 @@ bool ProjectManager::saveFileAs(const QString &outputFileName)
     // This timer is set by KdenliveDoc::setModified()
     const QString projectId = QCryptographicHash::hash(url.fileName().toUtf8(), QCryptographicHash::Md5).toHex();
     QUrl autosaveUrl = QUrl::fromLocalFile(QFileInfo(outputFileName).absoluteDir().absoluteFilePath(projectId + QStringLiteral(".kdenlive")));
+    // A background autosave may still be writing to the current autosave file
+    m_project->waitForAutoSave();
     if (m_project->m_autosave == nullptr) {
         // The temporary file is not opened or created until actually needed.
         // The file filename does not have to exist for KAutoSaveFile to be constructed (if it exists, it will not be touched).
@@ -557,9 +559,8 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale)
     }
     pCore->window()->connectDocument();
     pCore->mixer()->setModel(m_mainTimelineModel);
-    QDateTime documentDate = QFileInfo(m_project->url().toLocalFile()).lastModified();
     pCore->window()->getMainTimeline()->controller()->loadPreview(m_project->getDocumentProperty(QStringLiteral("previewchunks")),
-                                                                  m_project->getDocumentProperty(QStringLiteral("dirtypreviewchunks")), documentDate,
+                                                                  m_project->getDocumentProperty(QStringLiteral("dirtypreviewchunks")),
                                                                   m_project->getDocumentProperty(QStringLiteral("disablepreview")).toInt());
 
     emit docOpened(m_project);
@@ -641,18 +642,27 @@ void ProjectManager::slotStartAutoSave()
 
 void ProjectManager::slotAutoSave()
 {
+    if (m_project->isAutoSaving()) {
+        // Don't wait for the previous autosave, the next one will include the latest changes
+        m_autoSaveTimer.start(3000);
+        return;
+    }
+    QElapsedTimer blockedTime;
+    blockedTime.start();
     prepareSave();
     QString saveFolder = m_project->url().adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile();
+    // The MLT services cannot be walked while the user edits the timeline, so the scene is serialized here.
+    // The disk write is done by the document in a background thread
     QString scene = projectSceneList(saveFolder);
-    if (!m_replacementPattern.isEmpty()) {
-        QMapIterator<QString, QString> i(m_replacementPattern);
-        while (i.hasNext()) {
-            i.next();
-            scene.replace(i.key(), i.value());
-        }
-    }
-    m_project->slotAutoSave(scene);
+    m_project->slotAutoSave(scene, m_replacementPattern);
     m_lastSave.start();
+    m_autoSaveBlockingTime = blockedTime.elapsed();
+    qCDebug(KDENLIVE_LOG) << "Autosave blocked the interface for" << m_autoSaveBlockingTime << "ms";
+}
+
+qint64 ProjectManager::autoSaveBlockingTime() const
+{
+    return m_autoSaveBlockingTime;
 }
 
 QString ProjectManager::projectSceneList(const QString &outputFolder)
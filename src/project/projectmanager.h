@@ -66,6 +66,8 @@ public:
     void disableBinEffects(bool disable);
     /** @brief Returns current project's xml scene */
     QString projectSceneList(const QString &outputFolder);
+    /** @brief Returns the time (in ms) the interface was blocked by the last autosave */
+    qint64 autoSaveBlockingTime() const;
     /** @brief returns a default hd profile depending on timezone*/
     static QString getDefaultProjectFormat();
     void saveZone(const QStringList &info, const QDir &dir);
@@ -185,6 +187,7 @@ private:
     QUrl m_startUrl;
     QString m_loadClipsOnOpen;
     QMap<QString, QString> m_replacementPattern;
+    qint64 m_autoSaveBlockingTime{0};
 
     QAction *m_fileRevert;
     KRecentFilesAction *m_recentFilesAction;
@@ -9,12 +9,14 @@
  ***************************************************************************/
 
 #include "histogramgenerator.h"
+#include "scopekernels.h"
 
 #include "klocalizedstring.h"
 #include <QImage>
 #include <QPainter>
 #include <algorithm>
 #include <cmath>
+#include <vector>
 
 HistogramGenerator::HistogramGenerator() = default;
 
@@ -45,27 +47,52 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     const uint wh = (uint)paradeSize.height();
     const uint byteCount = iw * ih;
 
-    // Read the stats from the input image
-    for (int Y = 0; Y < image.height(); ++Y) {
-        for (int X = 0; X < image.width(); X += (int)accelFactor) {
-            QRgb col = image.pixel(X, Y);
-            r[qRed(col)]++;
-            g[qGreen(col)]++;
-            b[qBlue(col)]++;
+    // The kernels read whole QRgb rows
+    const QImage source = image.depth() == 32 ? image : image.convertToFormat(QImage::Format_RGB32);
+    const int imageWidth = source.width();
+    const ScopeKernels::Rec kernelRec = rec == HistogramGenerator::Rec_601 ? ScopeKernels::Rec_601 : ScopeKernels::Rec_709;
+
+    // Read the stats from the input image, each band of rows counting into its own buffer:
+    // red, green, blue and luma, 256 values each
+    const int bands = ScopeKernels::bandCount((int)ih);
+    std::vector<std::vector<int>> bandValues((size_t)bands);
+    ScopeKernels::parallelBands((int)ih, bands, [&](int band, int first, int last) {
+        std::vector<int> &values = bandValues[(size_t)band];
+        values.assign(4 * 256, 0);
+        int *red = values.data();
+        int *green = red + 256;
+        int *blue = green + 256;
+        int *luma = blue + 256;
+        std::vector<uchar> lumaRow((size_t)imageWidth);
+        for (int Y = first; Y < last; ++Y) {
+            auto *line = reinterpret_cast<const QRgb *>(source.constScanLine(Y));
+            for (int X = 0; X < imageWidth; X += (int)accelFactor) {
+                const QRgb col = line[X];
+                red[qRed(col)]++;
+                green[qGreen(col)]++;
+                blue[qBlue(col)]++;
+            }
             if (drawY) {
-                // Use if branch to avoid expensive multiplication if Y disabled
-                if (rec == HistogramGenerator::Rec_601) {
-                    y[(int)floor(.299 * qRed(col) + .587 * qGreen(col) + .114 * qBlue(col))]++;
-                } else {
-                    y[(int)floor(.2125 * qRed(col) + .7154 * qGreen(col) + .0721 * qBlue(col))]++;
+                // Skip the luma computation if Y disabled
+                ScopeKernels::rowLuma(line, imageWidth, (int)accelFactor, kernelRec, lumaRow.data());
+                for (int i = 0, X = 0; X < imageWidth; ++i, X += (int)accelFactor) {
+                    luma[lumaRow[(size_t)i]]++;
                 }
             }
-            if (drawSum) {
-                // Use an if branch here because the sum takes more operations than rgb
-                s[qRed(col)]++;
-                s[qGreen(col)]++;
-                s[qBlue(col)]++;
-            }
+        }
+    });
+    for (const std::vector<int> &values : bandValues) {
+        for (int i = 0; i < 256; ++i) {
+            r[i] += values[(size_t)i];
+            g[i] += values[(size_t)(256 + i)];
+            b[i] += values[(size_t)(512 + i)];
+            y[i] += values[(size_t)(768 + i)];
+        }
+    }
+    if (drawSum) {
+        // The sum is the count of all components
+        for (int i = 0; i < 256; ++i) {
+            s[i] = r[i] + g[i] + b[i];
         }
     }
 
@@ -10,6 +10,7 @@
 
 #include "rgbparadegenerator.h"
 #include "klocalizedstring.h"
+#include "scopekernels.h"
 #include <QColor>
 #include <QPainter>
 
@@ -56,7 +57,7 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
     const uint partH = wh - distBottom;
 
     // Statistics
-    uchar minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0, r, g, b;
+    uchar minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0;
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
@@ -69,68 +70,83 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
 
     const float wPrediv = (float)(partW - 1) / float((int)iw - 1);
 
-    std::vector<std::vector<StructRGB>> paradeVals(partW, std::vector<StructRGB>(256, {0, 0, 0}));
-
-    const uchar *bits = image.bits();
-    const uint stepsize = uint(uint(image.depth() / 8) * accelFactor);
-
-    for (uint i = 0, x = 0; i < byteCount; i += stepsize) {
-        auto *col = (const QRgb *)(bits);
-        r = (uchar)qRed(*col);
-        g = (uchar)qGreen(*col);
-        b = (uchar)qBlue(*col);
-
-        double dx = x * (double)wPrediv;
-
-        paradeVals[(size_t)dx][r].r++;
-        paradeVals[(size_t)dx][g].g++;
-        paradeVals[(size_t)dx][b].b++;
+    // The kernels read whole QRgb rows
+    const QImage source = image.depth() == 32 ? image : image.convertToFormat(QImage::Format_RGB32);
+    const int imageWidth = source.width();
+    std::vector<uint> columnOffset((size_t)imageWidth);
+    for (int x = 0; x < imageWidth; ++x) {
+        columnOffset[(size_t)x] = (uint)(double(x * 4) * (double)wPrediv);
+    }
 
-        if (r < minR) {
-            minR = r;
-        }
-        if (g < minG) {
-            minG = g;
-        }
-        if (b < minB) {
-            minB = b;
-        }
-        if (r > maxR) {
-            maxR = r;
-        }
-        if (g > maxG) {
-            maxG = g;
+    // One flat buffer per band, holding the red, green and blue planes one after the other.
+    // In each plane, values are stored by component value then by column
+    const size_t planeSize = partW * 256;
+    const int bands = ScopeKernels::bandCount((int)ih);
+    std::vector<std::vector<uint>> bandValues((size_t)bands);
+    std::vector<StructRGB> bandMin((size_t)bands, {255, 255, 255});
+    std::vector<StructRGB> bandMax((size_t)bands, {0, 0, 0});
+    ScopeKernels::parallelBands((int)ih, bands, [&](int band, int first, int last) {
+        std::vector<uint> &values = bandValues[(size_t)band];
+        values.assign(3 * planeSize, 0);
+        uint *redPlane = values.data();
+        uint *greenPlane = redPlane + planeSize;
+        uint *bluePlane = greenPlane + planeSize;
+        uint lowR = 255, lowG = 255, lowB = 255, highR = 0, highG = 0, highB = 0;
+        for (int row = first; row < last; ++row) {
+            auto *line = reinterpret_cast<const QRgb *>(source.constScanLine(row));
+            for (int x = 0; x < imageWidth; x += (int)accelFactor) {
+                const QRgb col = line[x];
+                const uint red = (uint)qRed(col);
+                const uint green = (uint)qGreen(col);
+                const uint blue = (uint)qBlue(col);
+                const uint dx = columnOffset[(size_t)x];
+                redPlane[red * partW + dx]++;
+                greenPlane[green * partW + dx]++;
+                bluePlane[blue * partW + dx]++;
+                lowR = qMin(lowR, red);
+                lowG = qMin(lowG, green);
+                lowB = qMin(lowB, blue);
+                highR = qMax(highR, red);
+                highG = qMax(highG, green);
+                highB = qMax(highB, blue);
+            }
         }
-        if (b > maxB) {
-            maxB = b;
+        bandMin[(size_t)band] = {lowR, lowG, lowB};
+        bandMax[(size_t)band] = {highR, highG, highB};
+    });
+    std::vector<uint> &paradeVals = bandValues.front();
+    for (size_t band = 1; band < bandValues.size(); ++band) {
+        const std::vector<uint> &values = bandValues[band];
+        for (size_t i = 0; i < paradeVals.size(); ++i) {
+            paradeVals[i] += values[i];
         }
-
-        bits += stepsize;
-        x += stepsize;
-        x %= iw; // Modulo image width, to represent the current x position in the image
+    }
+    for (size_t band = 0; band < bandValues.size(); ++band) {
+        minR = (uchar)qMin<uint>(minR, bandMin[band].r);
+        minG = (uchar)qMin<uint>(minG, bandMin[band].g);
+        minB = (uchar)qMin<uint>(minB, bandMin[band].b);
+        maxR = (uchar)qMax<uint>(maxR, bandMax[band].r);
+        maxG = (uchar)qMax<uint>(maxG, bandMax[band].g);
+        maxB = (uchar)qMax<uint>(maxB, bandMax[band].b);
     }
 
     const int offset1 = (int)partW + (int)offset;
     const int offset2 = 2 * (int)partW + 2 * (int)offset;
-    switch (paintMode) {
-    case PaintMode_RGB:
+    const uint *redVals = paradeVals.data();
+    const uint *greenVals = redVals + planeSize;
+    const uint *blueVals = greenVals + planeSize;
+    const QRgb redColor = paintMode == PaintMode_RGB ? qRgb(255, 10, 10) : qRgb(255, 255, 255);
+    const QRgb greenColor = paintMode == PaintMode_RGB ? qRgb(10, 255, 10) : qRgb(255, 255, 255);
+    const QRgb blueColor = paintMode == PaintMode_RGB ? qRgb(10, 10, 255) : qRgb(255, 255, 255);
+    auto withAlpha = [](QRgb color, int alpha) { return qRgba(qRed(color), qGreen(color), qBlue(color), alpha); };
+    for (int j = 0; j < 256; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(unscaled.scanLine(j));
+        const size_t rowStart = (size_t)j * partW;
         for (int i = 0; i < (int)partW; ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 10, 10, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].r)));
-                unscaled.setPixel(i + offset1, j, qRgba(10, 255, 10, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].g)));
-                unscaled.setPixel(i + offset2, j, qRgba(10, 10, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].b)));
-            }
-        }
-        break;
-    default:
-        for (int i = 0; i < (int)partW; ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].r)));
-                unscaled.setPixel(i + offset1, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].g)));
-                unscaled.setPixel(i + offset2, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].b)));
-            }
+            line[i] = withAlpha(redColor, CHOP255(gain * (float)redVals[rowStart + (size_t)i]));
+            line[i + offset1] = withAlpha(greenColor, CHOP255(gain * (float)greenVals[rowStart + (size_t)i]));
+            line[i + offset2] = withAlpha(blueColor, CHOP255(gain * (float)blueVals[rowStart + (size_t)i]));
         }
-        break;
     }
 
     // Scale the image to the target height. Scaling is not accomplished before because
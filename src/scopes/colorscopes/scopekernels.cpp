@@ -0,0 +1,144 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Kdenlive contributors                           *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "scopekernels.h"
+
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SCOPES_SSE2
+#endif
+#if defined(SCOPES_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCOPES_AVX2
+#endif
+
+namespace {
+// Below this, the cost of scheduling a band is higher than the work it does
+const int minRowsPerBand = 64;
+
+// Luma weights (blue, green, red) scaled by 2^15 so that they sum to 32768
+const int weights601[3] = {3735, 19235, 9798};
+const int weights709[3] = {2363, 23442, 6963};
+
+inline uchar scalarLuma(QRgb px, const int *w)
+{
+    return uchar((w[0] * qBlue(px) + w[1] * qGreen(px) + w[2] * qRed(px)) >> 15);
+}
+
+#ifdef SCOPES_SSE2
+// Luma of 4 pixels, stored as 4 bytes. QRgb is stored as B, G, R, A in memory
+inline __m128i lumaSse2(__m128i px, __m128i weights)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), weights);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), weights);
+    // Each pixel now has two partial sums, add them
+    lo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+    hi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+    lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 3, 2, 0));
+    hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 3, 2, 0));
+    __m128i sum = _mm_srli_epi32(_mm_unpacklo_epi64(lo, hi), 15);
+    sum = _mm_packs_epi32(sum, sum);
+    return _mm_packus_epi16(sum, sum);
+}
+
+int rowLumaSse2(const QRgb *row, int count, const int *w, uchar *luma)
+{
+    const __m128i weights = _mm_setr_epi16(short(w[0]), short(w[1]), short(w[2]), 0, short(w[0]), short(w[1]), short(w[2]), 0);
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+        int packed = _mm_cvtsi128_si32(lumaSse2(px, weights));
+        memcpy(luma + x, &packed, 4);
+    }
+    return x;
+}
+#endif
+
+#ifdef SCOPES_AVX2
+__attribute__((target("avx2"))) int rowLumaAvx2(const QRgb *row, int count, const int *w, uchar *luma)
+{
+    const __m256i weights = _mm256_setr_epi16(short(w[0]), short(w[1]), short(w[2]), 0, short(w[0]), short(w[1]), short(w[2]), 0, short(w[0]), short(w[1]),
+                                              short(w[2]), 0, short(w[0]), short(w[1]), short(w[2]), 0);
+    const __m256i zero = _mm256_setzero_si256();
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x));
+        // Same as the SSE2 version, on two lanes of 4 pixels
+        __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(px, zero), weights);
+        __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(px, zero), weights);
+        lo = _mm256_add_epi32(lo, _mm256_srli_epi64(lo, 32));
+        hi = _mm256_add_epi32(hi, _mm256_srli_epi64(hi, 32));
+        lo = _mm256_shuffle_epi32(lo, _MM_SHUFFLE(3, 3, 2, 0));
+        hi = _mm256_shuffle_epi32(hi, _MM_SHUFFLE(3, 3, 2, 0));
+        __m256i sum = _mm256_srli_epi32(_mm256_unpacklo_epi64(lo, hi), 15);
+        __m128i first = _mm256_castsi256_si128(sum);
+        __m128i second = _mm256_extracti128_si256(sum, 1);
+        __m128i words = _mm_packs_epi32(first, second);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(luma + x), _mm_packus_epi16(words, words));
+    }
+    return x;
+}
+
+bool hasAvx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2") != 0;
+    return supported;
+}
+#endif
+} // namespace
+
+void ScopeKernels::rowLuma(const QRgb *row, int count, int step, Rec rec, uchar *luma)
+{
+    const int *w = rec == Rec_601 ? weights601 : weights709;
+    if (step > 1) {
+        for (int i = 0, x = 0; x < count; ++i, x += step) {
+            luma[i] = scalarLuma(row[x], w);
+        }
+        return;
+    }
+    int x = 0;
+#ifdef SCOPES_AVX2
+    if (hasAvx2()) {
+        x = rowLumaAvx2(row, count, w, luma);
+    }
+#endif
+#ifdef SCOPES_SSE2
+    x += rowLumaSse2(row + x, count - x, w, luma + x);
+#endif
+    for (; x < count; ++x) {
+        luma[x] = scalarLuma(row[x], w);
+    }
+}
+
+int ScopeKernels::bandCount(int rows)
+{
+    return qBound(1, rows / minRowsPerBand, QThread::idealThreadCount());
+}
+
+void ScopeKernels::parallelBands(int rows, int bands, const std::function<void(int, int, int)> &fn)
+{
+    QVector<QFuture<void>> futures;
+    for (int band = 1; band < bands; ++band) {
+        int first = int(qint64(rows) * band / bands);
+        int last = int(qint64(rows) * (band + 1) / bands);
+        futures << QtConcurrent::run([&fn, band, first, last]() { fn(band, first, last); });
+    }
+    // The calling thread takes the first band
+    fn(0, 0, int(qint64(rows) / bands));
+    for (auto &future : futures) {
+        future.waitForFinished();
+    }
+}
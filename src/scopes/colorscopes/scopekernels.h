@@ -0,0 +1,40 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Kdenlive contributors                           *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef SCOPEKERNELS_H
+#define SCOPEKERNELS_H
+
+#include <QRgb>
+#include <functional>
+
+/**
+  Helpers shared by the colour scope generators.
+
+  Luma is computed in 15 bit fixed point, with SSE2 (and AVX2 when the CPU
+  supports it) on x86 and a scalar fallback giving the same results elsewhere.
+  Images are processed in bands of rows on the global thread pool, each band
+  accumulating into its own flat buffer which the caller merges afterwards.
+ */
+namespace ScopeKernels {
+
+enum Rec { Rec_601, Rec_709 };
+
+/** @brief Writes the luma (0 to 255) of @param count pixels of @param row, reading every @param step pixel */
+void rowLuma(const QRgb *row, int count, int step, Rec rec, uchar *luma);
+
+/** @brief Returns the number of bands to use for @param rows rows */
+int bandCount(int rows);
+
+/** @brief Calls @param fn(band, firstRow, endRow) for each band, concurrently, and returns when all bands are done */
+void parallelBands(int rows, int bands, const std::function<void(int, int, int)> &fn);
+
+} // namespace ScopeKernels
+
+#endif // SCOPEKERNELS_H
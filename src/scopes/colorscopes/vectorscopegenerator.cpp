@@ -64,8 +64,10 @@ mRgb2YPbPr =                        r =
  */
 
 #include "vectorscopegenerator.h"
+#include "scopekernels.h"
 #include <QImage>
 #include <cmath>
+#include <vector>
 
 // The maximum distance from the center for any RGB color is 0.63, so
 // no need to make the circle bigger than required.
@@ -122,147 +124,185 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
     QImage scope = QImage(cw, cw, QImage::Format_ARGB32);
     scope.fill(qRgba(0, 0, 0, 0));
 
-    const uchar *bits = image.bits();
-
-    double dy, dr, dg, db, dmax;
-    double /*y,*/ u, v;
-    QPoint pt;
-    QRgb px;
-
-    const int stepsize = int(uint(image.depth() / 8) * accelFactor);
+    // The kernels read whole QRgb rows
+    const QImage source = image.depth() == 32 ? image : image.convertToFormat(QImage::Format_RGB32);
+    const int imageWidth = source.width();
+    const int imageHeight = source.height();
 
     // Just an average for the number of image pixels per scope pixel.
     // NOTE: byteCount() has to be replaced by (img.bytesPerLine()*img.height()) for Qt 4.5 to compile, see:
     // https://doc.qt.io/qt-5/qimage.html#bytesPerLine
     double avgPxPerPx = (double)image.depth() / 8 * (image.bytesPerLine() * image.height()) / scope.size().width() / scope.size().height() / accelFactor;
 
-    for (int i = 0; i < (image.bytesPerLine() * image.height()); i += stepsize) {
-        auto *col = (const QRgb *)(bits);
-
-        int r = qRed(*col);
-        int g = qGreen(*col);
-        int b = qBlue(*col);
+    // U and V coefficients for red, green and blue
+    double uCoeffs[3];
+    double vCoeffs[3];
+    switch (colorSpace) {
+    case VectorscopeGenerator::ColorSpace_YUV:
+        //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
+        uCoeffs[0] = -0.0005781;
+        uCoeffs[1] = -0.001135;
+        uCoeffs[2] = 0.001713;
+        vCoeffs[0] = 0.002411;
+        vCoeffs[1] = -0.002019;
+        vCoeffs[2] = -0.0003921;
+        break;
+    case VectorscopeGenerator::ColorSpace_YPbPr:
+    default:
+        //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
+        uCoeffs[0] = -0.0006671;
+        uCoeffs[1] = -0.001299;
+        uCoeffs[2] = 0.0019608;
+        vCoeffs[0] = 0.001961;
+        vCoeffs[1] = -0.001642;
+        vCoeffs[2] = -0.0003189;
+        break;
+    }
 
-        switch (colorSpace) {
-        case VectorscopeGenerator::ColorSpace_YUV:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = (double)-0.0005781 * r - 0.001135 * g + 0.001713 * b;
-            v = (double)0.002411 * r - 0.002019 * g - 0.0003921 * b;
-            break;
-        case VectorscopeGenerator::ColorSpace_YPbPr:
-        default:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = (double)-0.0006671 * r - 0.001299 * g + 0.0019608 * b;
-            v = (double)0.001961 * r - 0.001642 * g - 0.0003189 * b;
-            break;
+    // In the green and black modes, a scope pixel only depends on how many image pixels fall on it.
+    // In the other modes, it gets the colour of the last image pixel falling on it.
+    const bool countHits = paintMode == PaintMode_Green || paintMode == PaintMode_Green2 || paintMode == PaintMode_Black;
+    const size_t scopePixels = size_t(cw) * size_t(cw);
+    const int bands = ScopeKernels::bandCount(imageHeight);
+    std::vector<std::vector<uint>> bandValues((size_t)bands);
+    ScopeKernels::parallelBands(imageHeight, bands, [&](int band, int first, int last) {
+        // Hit counts, or colours with 0 meaning not hit
+        std::vector<uint> &values = bandValues[(size_t)band];
+        values.assign(scopePixels, 0);
+        double dy, dr, dg, db, dmax;
+        double u, v;
+        // The accelerator skips pixels across rows, as if the image was a single line
+        int x = int((qint64(first) * imageWidth) % accelFactor);
+        if (x > 0) {
+            x = int(accelFactor) - x;
         }
-
-        pt = mapToCircle(vectorscopeSize, QPointF(SCALING * gain * u, SCALING * gain * v));
-
-        if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
-            // Point lies outside (because of scaling), don't plot it
-
-        } else {
-
-            // Draw the pixel using the chosen draw mode.
-            switch (paintMode) {
-            case PaintMode_YUV:
-                // see yuvColorWheel
-                dy = 128; // Default Y value. Lower = darker.
-
-                // Calculate the RGB values from YUV/YPbPr
-                switch (colorSpace) {
-                case VectorscopeGenerator::ColorSpace_YUV:
-                    dr = dy + 290.8 * v;
-                    dg = dy - 100.6 * u - 148 * v;
-                    db = dy + 517.2 * u;
-                    break;
-                case VectorscopeGenerator::ColorSpace_YPbPr:
-                default:
-                    dr = dy + 357.5 * v;
-                    dg = dy - 87.75 * u - 182 * v;
-                    db = dy + 451.9 * u;
-                    break;
-                }
-
-                if (dr < 0) {
-                    dr = 0;
-                }
-                if (dg < 0) {
-                    dg = 0;
-                }
-                if (db < 0) {
-                    db = 0;
-                }
-                if (dr > 255) {
-                    dr = 255;
-                }
-                if (dg > 255) {
-                    dg = 255;
+        for (int row = first; row < last; ++row) {
+            auto *line = reinterpret_cast<const QRgb *>(source.constScanLine(row));
+            for (; x < imageWidth; x += (int)accelFactor) {
+                const QRgb col = line[x];
+                int r = qRed(col);
+                int g = qGreen(col);
+                int b = qBlue(col);
+                u = uCoeffs[0] * r + uCoeffs[1] * g + uCoeffs[2] * b;
+                v = vCoeffs[0] * r + vCoeffs[1] * g + vCoeffs[2] * b;
+
+                QPoint pt = mapToCircle(vectorscopeSize, QPointF(SCALING * gain * u, SCALING * gain * v));
+                if (pt.x() >= cw || pt.x() < 0 || pt.y() >= cw || pt.y() < 0) {
+                    // Point lies outside (because of scaling), don't plot it
+                    continue;
                 }
-                if (db > 255) {
-                    db = 255;
+                uint &value = values[size_t(pt.y()) * size_t(cw) + size_t(pt.x())];
+                if (countHits) {
+                    value++;
+                    continue;
                 }
 
-                scope.setPixel(pt, qRgba(dr, dg, db, 255));
-                break;
-
-            case PaintMode_Chroma:
-                dy = 200; // Default Y value. Lower = darker.
-
-                // Calculate the RGB values from YUV/YPbPr
-                switch (colorSpace) {
-                case VectorscopeGenerator::ColorSpace_YUV:
-                    dr = dy + 290.8 * v;
-                    dg = dy - 100.6 * u - 148 * v;
-                    db = dy + 517.2 * u;
+                // Draw the pixel using the chosen draw mode.
+                switch (paintMode) {
+                case PaintMode_YUV:
+                case PaintMode_Chroma:
+                    // see yuvColorWheel
+                    dy = paintMode == PaintMode_YUV ? 128 : 200; // Default Y value. Lower = darker.
+
+                    // Calculate the RGB values from YUV/YPbPr
+                    switch (colorSpace) {
+                    case VectorscopeGenerator::ColorSpace_YUV:
+                        dr = dy + 290.8 * v;
+                        dg = dy - 100.6 * u - 148 * v;
+                        db = dy + 517.2 * u;
+                        break;
+                    case VectorscopeGenerator::ColorSpace_YPbPr:
+                    default:
+                        dr = dy + 357.5 * v;
+                        dg = dy - 87.75 * u - 182 * v;
+                        db = dy + 451.9 * u;
+                        break;
+                    }
+
+                    if (paintMode == PaintMode_YUV) {
+                        dr = qBound(0., dr, 255.);
+                        dg = qBound(0., dg, 255.);
+                        db = qBound(0., db, 255.);
+                    } else {
+                        // Scale the RGB values back to max 255
+                        dmax = qMax(dr, qMax(dg, db));
+                        dmax = 255 / dmax;
+                        dr *= dmax;
+                        dg *= dmax;
+                        db *= dmax;
+                    }
+                    value = qRgba(int(dr), int(dg), int(db), 255);
                     break;
-                case VectorscopeGenerator::ColorSpace_YPbPr:
+                case PaintMode_Original:
                 default:
-                    dr = dy + 357.5 * v;
-                    dg = dy - 87.75 * u - 182 * v;
-                    db = dy + 451.9 * u;
+                    value = col;
                     break;
                 }
-
-                // Scale the RGB values back to max 255
-                dmax = dr;
-                if (dg > dmax) {
-                    dmax = dg;
-                }
-                if (db > dmax) {
-                    dmax = db;
+            }
+            x -= imageWidth;
+        }
+    });
+
+    // Merge the bands. Counts are added, colours from later bands replace earlier ones as later image pixels would
+    std::vector<uint> &values = bandValues.front();
+    uint maxHits = 0;
+    for (size_t i = 0; i < scopePixels; ++i) {
+        for (size_t band = 1; band < bandValues.size(); ++band) {
+            const uint value = bandValues[band][i];
+            if (countHits) {
+                values[i] += value;
+            } else if (value != 0) {
+                values[i] = value;
+            }
+        }
+        maxHits = qMax(maxHits, values[i]);
+    }
+    if (!countHits) {
+        for (int j = 0; j < cw; ++j) {
+            auto *line = reinterpret_cast<QRgb *>(scope.scanLine(j));
+            const uint *colors = values.data() + size_t(j) * size_t(cw);
+            for (int i = 0; i < cw; ++i) {
+                if (colors[i] != 0) {
+                    line[i] = colors[i];
                 }
-                dmax = 255 / dmax;
-
-                dr *= dmax;
-                dg *= dmax;
-                db *= dmax;
-
-                scope.setPixel(pt, qRgba(dr, dg, db, 255));
-                break;
-            case PaintMode_Original:
-                scope.setPixel(pt, *col);
-                break;
-            case PaintMode_Green:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + (255 - qRed(px)) / (3 * avgPxPerPx), qGreen(px) + 20 * (255 - qGreen(px)) / (avgPxPerPx),
-                                         qBlue(px) + (255 - qBlue(px)) / (avgPxPerPx), qAlpha(px) + (255 - qAlpha(px)) / (avgPxPerPx)));
-                break;
-            case PaintMode_Green2:
-                px = scope.pixel(pt);
-                scope.setPixel(pt,
-                               qRgba(qRed(px) + ceil((255 - (float)qRed(px)) / (4 * avgPxPerPx)), 255,
-                                     qBlue(px) + ceil((255 - (float)qBlue(px)) / (avgPxPerPx)), qAlpha(px) + ceil((255 - (float)qAlpha(px)) / (avgPxPerPx))));
-                break;
-            case PaintMode_Black:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20));
-                break;
             }
         }
+        return scope;
+    }
 
-        bits += stepsize;
+    // Every hit blends the scope pixel towards the mode's colour, starting from transparent.
+    // Compute the colour after n hits once, it stops changing after a few hits anyway.
+    std::vector<QRgb> blended(1, qRgba(0, 0, 0, 0));
+    while (blended.size() <= maxHits) {
+        const QRgb px = blended.back();
+        QRgb next;
+        switch (paintMode) {
+        case PaintMode_Green:
+            next = qRgba(qRed(px) + (255 - qRed(px)) / (3 * avgPxPerPx), qGreen(px) + 20 * (255 - qGreen(px)) / (avgPxPerPx),
+                         qBlue(px) + (255 - qBlue(px)) / (avgPxPerPx), qAlpha(px) + (255 - qAlpha(px)) / (avgPxPerPx));
+            break;
+        case PaintMode_Green2:
+            next = qRgba(qRed(px) + ceil((255 - (float)qRed(px)) / (4 * avgPxPerPx)), 255, qBlue(px) + ceil((255 - (float)qBlue(px)) / (avgPxPerPx)),
+                         qAlpha(px) + ceil((255 - (float)qAlpha(px)) / (avgPxPerPx)));
+            break;
+        case PaintMode_Black:
+        default:
+            next = qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20);
+            break;
+        }
+        if (next == px && blended.size() > 1) {
+            break;
+        }
+        blended.push_back(next);
+    }
+    for (int j = 0; j < cw; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(scope.scanLine(j));
+        const uint *hits = values.data() + size_t(j) * size_t(cw);
+        for (int i = 0; i < cw; ++i) {
+            if (hits[i] > 0) {
+                line[i] = blended[qMin<size_t>(hits[i], blended.size() - 1)];
+            }
+        }
     }
     return scope;
 }
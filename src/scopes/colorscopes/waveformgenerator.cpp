@@ -9,6 +9,7 @@
  ***************************************************************************/
 
 #include "waveformgenerator.h"
+#include "scopekernels.h"
 
 #include <cmath>
 
@@ -41,13 +42,15 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
     // Fill with transparent color
     wave.fill(qRgba(0, 0, 0, 0));
 
+    // The kernels read whole QRgb rows
+    const QImage source = image.depth() == 32 ? image : image.convertToFormat(QImage::Format_RGB32);
+
     const uint ww = (uint)waveformSize.width();
     const uint wh = (uint)waveformSize.height();
-    const uint iw = (uint)image.bytesPerLine();
-    const uint ih = (uint)image.height();
+    const uint iw = (uint)source.bytesPerLine();
+    const uint ih = (uint)source.height();
     const uint byteCount = iw * ih;
-
-    std::vector<std::vector<uint>> waveValues((size_t)waveformSize.width(), std::vector<uint>((size_t)waveformSize.height(), 0));
+    const int imageWidth = source.width();
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
@@ -60,67 +63,70 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
     const float hPrediv = (float)(wh - 1) / 255.;
     const float wPrediv = (float)(ww - 1) / float(iw - 1);
 
-    const uchar *bits = image.bits();
-    const int bpp = image.depth() / 8;
-
-    for (uint i = 0, x = 0; i < byteCount; i += (uint)bpp) {
-
-        Q_ASSERT(bits < image.bits() + byteCount);
-
-        double dY, dx, dy;
-        auto *col = (const QRgb *)bits;
+    // Scope column of each image column, and scope row offset of each luma value,
+    // so that the inner loop is reduced to one increment in a flat buffer
+    std::vector<uint> columnOffset((size_t)imageWidth);
+    for (int x = 0; x < imageWidth; ++x) {
+        columnOffset[(size_t)x] = (uint)(float(x * 4) * wPrediv);
+    }
+    std::vector<uint> lumaOffset(256);
+    for (uint l = 0; l < 256; ++l) {
+        lumaOffset[l] = (uint)(float(l) * hPrediv) * ww;
+    }
 
-        if (rec == WaveformGenerator::Rec_601) {
-            // CIE 601 Luminance
-            dY = .299 * qRed(*col) + .587 * qGreen(*col) + .114 * qBlue(*col);
-        } else {
-            // CIE 709 Luminance
-            dY = .2125 * qRed(*col) + .7154 * qGreen(*col) + .0721 * qBlue(*col);
-        }
-        // dY is on [0,255] now.
-
-        dy = dY * hPrediv;
-        dx = (float)x * wPrediv;
-        waveValues[(size_t)dx][(size_t)dy]++;
-
-        bits += bpp;
-        x += (uint)bpp;
-        if (x > iw) {
-            x -= iw;
-            if (accelFactor > 1) {
-                bits += bpp * (int)iw * ((int)accelFactor - 1);
-                i += (uint)bpp * iw * (accelFactor - 1);
+    const ScopeKernels::Rec kernelRec = rec == WaveformGenerator::Rec_601 ? ScopeKernels::Rec_601 : ScopeKernels::Rec_709;
+    const int sampledRows = int((ih + accelFactor - 1) / accelFactor);
+    const int bands = ScopeKernels::bandCount(sampledRows);
+    std::vector<std::vector<uint>> bandValues((size_t)bands);
+    ScopeKernels::parallelBands(sampledRows, bands, [&](int band, int first, int last) {
+        std::vector<uint> &values = bandValues[(size_t)band];
+        values.assign(ww * wh, 0);
+        std::vector<uchar> luma((size_t)imageWidth);
+        for (int row = first; row < last; ++row) {
+            auto *line = reinterpret_cast<const QRgb *>(source.constScanLine(row * (int)accelFactor));
+            ScopeKernels::rowLuma(line, imageWidth, 1, kernelRec, luma.data());
+            for (int x = 0; x < imageWidth; ++x) {
+                values[lumaOffset[luma[(size_t)x]] + columnOffset[(size_t)x]]++;
             }
         }
+    });
+    std::vector<uint> &waveValues = bandValues.front();
+    uint maxValue = 0;
+    for (size_t i = 0; i < waveValues.size(); ++i) {
+        for (size_t band = 1; band < bandValues.size(); ++band) {
+            waveValues[i] += bandValues[band][i];
+        }
+        maxValue = qMax(maxValue, waveValues[i]);
     }
 
-    switch (paintMode) {
-    case PaintMode_Green:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                // Logarithmic scale. Needs fine tuning by hand, but looks great.
-                wave.setPixel(i, waveformSize.height() - j - 1,
-                              qRgba(CHOP255(52 * log(0.1 * gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(52 * std::log(gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(52 * log(.25 * gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(64 * std::log(gain * (float)waveValues[(size_t)i][(size_t)j]))));
-            }
+    // Colour of a scope pixel depending on the number of image pixels falling on it
+    auto colorFor = [paintMode, gain](uint count) {
+        switch (paintMode) {
+        case PaintMode_Green:
+            // Logarithmic scale. Needs fine tuning by hand, but looks great.
+            return qRgba(CHOP255(52 * log(0.1 * gain * (float)count)), CHOP255(52 * std::log(gain * (float)count)), CHOP255(52 * log(.25 * gain * (float)count)),
+                         CHOP255(64 * std::log(gain * (float)count)));
+        case PaintMode_Yellow:
+            return qRgba(255, 242, 0, CHOP255(gain * (float)count));
+        default:
+            return qRgba(255, 255, 255, CHOP255(2. * gain * (float)count));
         }
-        break;
-    case PaintMode_Yellow:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 242, 0, CHOP255(gain * (float)waveValues[(size_t)i][(size_t)j])));
-            }
-        }
-        break;
-    default:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 255, 255, CHOP255(2. * gain * (float)waveValues[(size_t)i][(size_t)j])));
+    };
+    // Most counts are small, cache their colour instead of computing logarithms for every pixel
+    std::vector<QRgb> colors(qMin<size_t>(maxValue + 1, 4096));
+    for (size_t count = 1; count < colors.size(); ++count) {
+        colors[count] = colorFor((uint)count);
+    }
+    for (uint j = 0; j < wh; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(wave.scanLine(int(wh - j - 1)));
+        const uint *counts = waveValues.data() + j * ww;
+        for (uint i = 0; i < ww; ++i) {
+            const uint count = counts[i];
+            if (count == 0) {
+                continue;
             }
+            line[i] = count < colors.size() ? colors[count] : colorFor(count);
         }
-        break;
     }
 
     if (drawAxis) {
@@ -36,7 +36,9 @@
 #include "timelinefunctions.hpp"
 #include "trackmodel.hpp"
 
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QDomDocument>
 #include <QThread>
 #include <QModelIndex>
 #include <klocalizedstring.h>
@@ -743,124 +745,117 @@ int TimelineModel::suggestClipMove(int clipId, int trackId, int position, int cu
             position = snapped;
         }
     }
-    // we check if move is possible
-    bool possible = (m_editMode == TimelineMode::NormalEdit) ? requestClipMove(clipId, trackId, position, moveMirrorTracks, true, false, false)
-                                                           : requestFakeClipMove(clipId, trackId, position, true, false, false);
-    /*} else {
-        possible = requestClipMoveAttempt(clipId, trackId, position);
-    }*/
-    if (possible) {
-        TRACE_RES(position);
-        return position;
-    }
-    if (sourceTrackId == -1) {
-        // not clear what to do hear, if the current move doesn't work. We could try to find empty space, but it might end up being far away...
-        TRACE_RES(currentPos);
-        return currentPos;
-    }
-    // Find best possible move
-    if (!m_groups->isInGroup(clipId)) {
-        // Try same track move
-        if (trackId != sourceTrackId && sourceTrackId != -1) {
-            qDebug() << "// TESTING SAME TRACVK MOVE: " << trackId << " = " << sourceTrackId;
-            trackId = sourceTrackId;
-            possible = requestClipMove(clipId, trackId, position, moveMirrorTracks, true, false, false);
-            if (!possible) {
-                qDebug() << "CANNOT MOVE CLIP : " << clipId << " ON TK: " << trackId << ", AT POS: " << position;
-            } else {
+    if (m_editMode == TimelineMode::NormalEdit && sourceTrackId != -1) {
+        // Find a legal position on the track indexes first, so that the tracks are only modified once
+        int target = currentPos;
+        int targetTrack = sourceTrackId;
+        bool grouped = m_groups->isInGroup(clipId);
+        std::unordered_set<int> items = getMoveSelection(clipId);
+        if (trackId != sourceTrackId) {
+            if (!grouped) {
+                if (canInsertClip(clipId, trackId, position)) {
+                    target = position;
+                    targetTrack = trackId;
+                }
+            } else if (requestClipMove(clipId, trackId, position, moveMirrorTracks, true, false, false)) {
+                // Group moves across tracks follow the track mapping of requestGroupMove, let it decide
                 TRACE_RES(position);
                 return position;
             }
         }
-
-        int blank_length = getTrackById_const(trackId)->getBlankSizeNearClip(clipId, after);
-        qDebug() << "Found blank" << blank_length;
-        if (blank_length < INT_MAX) {
-            if (after) {
-                position = currentPos + blank_length;
+        if (targetTrack == sourceTrackId) {
+            // Same track move. Items jump over other clips when their target is free, otherwise they slide until the first obstacle
+            if (canMoveItems(items, position - currentPos)) {
+                target = position;
             } else {
-                position = currentPos - blank_length;
+                int slide = getFreeSlide(items, after);
+                if (slide == INT_MAX && !grouped) {
+                    slide = 0;
+                }
+                slide = qMin(slide, qAbs(position - currentPos));
+                target = currentPos + (after ? slide : -slide);
             }
-        } else {
+        }
+        if (target == currentPos && targetTrack == sourceTrackId) {
             TRACE_RES(currentPos);
             return currentPos;
         }
-        possible = requestClipMove(clipId, trackId, position, moveMirrorTracks, true, false, false);
-        TRACE_RES(possible ? position : currentPos);
-        return possible ? position : currentPos;
+        bool possible = requestClipMove(clipId, targetTrack, target, moveMirrorTracks, true, false, false);
+        TRACE_RES(possible ? target : currentPos);
+        return possible ? target : currentPos;
     }
-    if (trackId != sourceTrackId) {
-        // Try same track move
-        possible = requestClipMove(clipId, sourceTrackId, position, moveMirrorTracks, true, false, false);
-        return possible ? position : currentPos;
+    // we check if move is possible
+    bool possible = (m_editMode == TimelineMode::NormalEdit) ? requestClipMove(clipId, trackId, position, moveMirrorTracks, true, false, false)
+                                                           : requestFakeClipMove(clipId, trackId, position, true, false, false);
+    TRACE_RES(possible ? position : currentPos);
+    return possible ? position : currentPos;
+}
+
+std::unordered_set<int> TimelineModel::getMoveSelection(int clipId) const
+{
+    if (m_groups->isInGroup(clipId)) {
+        return m_groups->getLeaves(m_groups->getRootId(clipId));
     }
-    // find best pos for groups
-    int groupId = m_groups->getRootId(clipId);
-    std::unordered_set<int> all_items = m_groups->getLeaves(groupId);
-    QMap<int, int> trackPosition;
+    return {clipId};
+}
 
-    // First pass, sort clips by track and keep only the first / last depending on move direction
-    for (int current_clipId : all_items) {
-        int clipTrack = getItemTrackId(current_clipId);
-        if (clipTrack == -1) {
-            continue;
+bool TimelineModel::canMoveItems(const std::unordered_set<int> &items, int delta) const
+{
+    std::unordered_set<int> tracks;
+    for (int id : items) {
+        int tid = getItemTrackId(id);
+        if (tid != -1) {
+            tracks.insert(tid);
         }
-        int in = getItemPosition(current_clipId);
-        if (trackPosition.contains(clipTrack)) {
-            if (after) {
-                // keep only last clip position for track
-                int out = in + getItemPlaytime(current_clipId);
-                if (trackPosition.value(clipTrack) < out) {
-                    trackPosition.insert(clipTrack, out);
-                }
-            } else {
-                // keep only first clip position for track
-                if (trackPosition.value(clipTrack) > in) {
-                    trackPosition.insert(clipTrack, in);
-                }
-            }
-        } else {
-            trackPosition.insert(clipTrack, after ? in + getItemPlaytime(current_clipId) - 1 : in);
+    }
+    for (int tid : tracks) {
+        auto track = getTrackById_const(tid);
+        if (track->isLocked() || !track->canMoveItems(items, delta)) {
+            return false;
         }
     }
+    return true;
+}
 
-    // Now check space on each track
-    QMapIterator<int, int> i(trackPosition);
-    int blank_length = 0;
-    while (i.hasNext()) {
-        i.next();
-        int track_space;
-        if (!after) {
-            // Check space before the position
-            track_space = i.value() - getTrackById_const(i.key())->getBlankStart(i.value() - 1);
-            if (blank_length == 0 || blank_length > track_space) {
-                blank_length = track_space;
-            }
-        } else {
-            // Check space after the position
-            track_space = getTrackById(i.key())->getBlankEnd(i.value() + 1) - i.value() - 1;
-            if (blank_length == 0 || blank_length > track_space) {
-                blank_length = track_space;
-            }
+int TimelineModel::getFreeSlide(const std::unordered_set<int> &items, bool after) const
+{
+    std::unordered_set<int> tracks;
+    for (int id : items) {
+        int tid = getItemTrackId(id);
+        if (tid != -1) {
+            tracks.insert(tid);
         }
     }
-    if (snapDistance > 0) {
-        if (blank_length > 10 * snapDistance) {
-            blank_length = 0;
+    int slide = INT_MAX;
+    for (int tid : tracks) {
+        auto track = getTrackById_const(tid);
+        if (track->isLocked()) {
+            return 0;
         }
-    } else if (blank_length / m_profile->fps() > 5) {
-        blank_length = 0;
+        slide = qMin(slide, track->getFreeSlide(items, after));
+    }
+    return slide;
+}
+
+bool TimelineModel::canInsertClip(int clipId, int trackId, int position) const
+{
+    const std::shared_ptr<ClipModel> clip = m_allClips.at(clipId);
+    auto track = getTrackById_const(trackId);
+    if (position < 0 || track->isLocked()) {
+        return false;
     }
-    if (blank_length != 0) {
-        int updatedPos = currentPos + (after ? blank_length : -blank_length);
-        possible = requestClipMove(clipId, trackId, updatedPos, moveMirrorTracks, true, false, false);
-        if (possible) {
-            TRACE_RES(updatedPos);
-            return updatedPos;
+    // Same type checks as requestClipMove
+    if (clip->clipState() == PlaylistState::Disabled) {
+        if ((track->trackType() == PlaylistState::AudioOnly && !clip->canBeAudio()) || (track->trackType() == PlaylistState::VideoOnly && !clip->canBeVideo())) {
+            return false;
         }
+    } else if (track->trackType() != clip->clipState()) {
+        return false;
     }
-    TRACE_RES(currentPos);
-    return currentPos;
+    if (getClipTrackId(clipId) != -1 && getTrackById_const(getClipTrackId(clipId))->isLocked()) {
+        return false;
+    }
+    return track->getClipsInRange(position, position + clip->getPlaytime()).empty();
 }
 
 int TimelineModel::suggestCompositionMove(int compoId, int trackId, int position, int cursorPosition, int snapDistance)
@@ -1258,6 +1253,136 @@ std::unordered_set<int> TimelineModel::getItemsInRange(int trackId, int start, i
     return allClips;
 }
 
+namespace {
+// Feed an xml element to the hash with sorted attributes, the attribute order of QDom is not stable between sessions
+void hashElement(QCryptographicHash &hash, const QDomElement &element)
+{
+    hash.addData(element.tagName().toUtf8());
+    QDomNamedNodeMap attributes = element.attributes();
+    QStringList names;
+    for (int i = 0; i < attributes.count(); ++i) {
+        names << attributes.item(i).nodeName();
+    }
+    names.sort();
+    for (const QString &name : names) {
+        hash.addData(QStringLiteral(" %1=%2").arg(name, element.attribute(name)).toUtf8());
+    }
+    for (QDomNode child = element.firstChild(); !child.isNull(); child = child.nextSibling()) {
+        if (child.isElement()) {
+            hashElement(hash, child.toElement());
+        } else if (child.isText()) {
+            hash.addData(child.nodeValue().toUtf8());
+        }
+    }
+    hash.addData("/", 1);
+}
+
+// Bin clip properties changing the rendered frames without changing the source file
+const QStringList &renderProperties()
+{
+    static const QStringList properties = {QStringLiteral("force_aspect_ratio"), QStringLiteral("force_aspect_num"), QStringLiteral("force_aspect_den"),
+                                           QStringLiteral("set.force_full_luma"), QStringLiteral("full_luma"), QStringLiteral("force_colorspace"),
+                                           QStringLiteral("force_tff"), QStringLiteral("force_progressive"), QStringLiteral("force_fps"),
+                                           QStringLiteral("video_delay"), QStringLiteral("autorotate"), QStringLiteral("rotate"),
+                                           QStringLiteral("video_index"), QStringLiteral("templatetext"), QStringLiteral("kdenlive:proxy"),
+                                           QStringLiteral("luma_duration"), QStringLiteral("luma_file"), QStringLiteral("fade"), QStringLiteral("ttl"),
+                                           QStringLiteral("softness"), QStringLiteral("crop"), QStringLiteral("animation")};
+    return properties;
+}
+
+// The source of a timeline clip: the content of its bin clip, its render properties and its bin effects
+QDomElement binClipSource(QDomDocument &doc, const std::shared_ptr<ProjectClip> &binClip)
+{
+    QDomElement source = doc.createElement(QStringLiteral("source"));
+    if (!binClip) {
+        return source;
+    }
+    source.setAttribute(QStringLiteral("hash"), binClip->hash());
+    for (const QString &name : renderProperties()) {
+        const QString value = binClip->getProducerProperty(name);
+        if (!value.isEmpty()) {
+            source.setAttribute(name, value);
+        }
+    }
+    source.appendChild(binClip->getEffectStack()->toXml(doc));
+    return source;
+}
+} // namespace
+
+QByteArray TimelineModel::getVideoContentHash(int start, int end)
+{
+    READ_LOCK();
+    QDomDocument doc;
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(end - start));
+    hashElement(hash, m_masterStack->toXml(doc));
+    // Master and track effects are not moved with the items, their keyframes render differently at another position
+    bool absolute = m_masterStack->rowCount() > 0;
+    // Several instances of a bin clip share the same source
+    QMap<QString, QDomElement> sources;
+    int videoTrack = 0;
+    for (const auto &track : m_allTracks) {
+        if (track->isAudioTrack()) {
+            continue;
+        }
+        // Track order matters for compositing
+        hash.addData(QStringLiteral("track %1").arg(videoTrack++).toUtf8());
+        if (track->isHidden()) {
+            hash.addData("hidden");
+            continue;
+        }
+        hashElement(hash, track->m_effectStack->toXml(doc));
+        absolute = absolute || track->m_effectStack->rowCount() > 0;
+        // Sort the items by position for a stable hash
+        std::vector<std::pair<int, int>> items;
+        for (int id : track->getClipsInRange(start, end)) {
+            items.emplace_back(m_allClips.at(id)->getPosition(), id);
+        }
+        for (int id : track->getCompositionsInRange(start, end)) {
+            items.emplace_back(m_allCompositions.at(id)->getPosition(), id);
+        }
+        std::sort(items.begin(), items.end());
+        for (const auto &item : items) {
+            QDomElement xml;
+            if (isClip(item.second)) {
+                std::shared_ptr<ClipModel> clip = m_allClips.at(item.second);
+                xml = clip->toXml(doc);
+                // Identify the source by its content rather than by its bin id
+                const QString binId = clip->binId();
+                xml.removeAttribute(QStringLiteral("binid"));
+                xml.removeAttribute(QStringLiteral("mirrorTrack"));
+                if (!sources.contains(binId)) {
+                    sources.insert(binId, binClipSource(doc, pCore->projectItemModel()->getClipByBinID(binId)));
+                }
+                xml.appendChild(sources.value(binId).cloneNode().toElement());
+            } else {
+                std::shared_ptr<CompositionModel> compo = m_allCompositions.at(item.second);
+                xml = compo->toXml(doc);
+                // The absolute in / out of the transition are already given by the relative position and duration
+                QDomNodeList props = xml.elementsByTagName(QStringLiteral("property"));
+                for (int i = props.count() - 1; i >= 0; --i) {
+                    QDomElement prop = props.item(i).toElement();
+                    QString name = prop.attribute(QStringLiteral("name"));
+                    if (name == QLatin1String("in") || name == QLatin1String("out")) {
+                        xml.removeChild(prop);
+                    }
+                }
+                xml.removeAttribute(QStringLiteral("in"));
+                xml.removeAttribute(QStringLiteral("out"));
+                xml.setAttribute(QStringLiteral("duration"), compo->getPlaytime());
+            }
+            xml.removeAttribute(QStringLiteral("id"));
+            xml.removeAttribute(QStringLiteral("track"));
+            xml.setAttribute(QStringLiteral("position"), item.first - start);
+            hashElement(hash, xml);
+        }
+    }
+    if (absolute) {
+        hash.addData(QStringLiteral("start %1").arg(start).toUtf8());
+    }
+    return hash.result().toHex();
+}
+
 bool TimelineModel::requestFakeGroupMove(int clipId, int groupId, int delta_track, int delta_pos, bool updateView, bool logUndo)
 {
     TRACE(clipId, groupId, delta_track, delta_pos, updateView, logUndo);
@@ -547,6 +547,16 @@ protected:
      */
     int getBestSnapPos(int pos, int length, const std::vector<int> &pts = std::vector<int>(), int cursorPosition = 0, int snapDistance = -1);
 
+    /* @brief Returns the items that move along with a clip: the leaves of its group, or the clip itself */
+    std::unordered_set<int> getMoveSelection(int clipId) const;
+    /* @brief Returns true if the items can be moved by delta frames on their current tracks.
+       The check is done on the position indexes of the tracks, nothing is modified */
+    bool canMoveItems(const std::unordered_set<int> &items, int delta) const;
+    /* @brief Returns how many frames the items can slide forward (or backward) on their tracks before hitting another item, INT_MAX if unlimited */
+    int getFreeSlide(const std::unordered_set<int> &items, bool after) const;
+    /* @brief Returns true if a clip that is not in a group can be moved to the given track and position, nothing is modified */
+    bool canInsertClip(int clipId, int trackId, int position) const;
+
     /* @brief Returns the best possible size for a clip on resize
      */
     int requestItemResizeInfo(int itemId, int in, int out, int size, bool right, int snapDistance);
@@ -613,6 +623,14 @@ public:
      */
     std::unordered_set<int> getItemsInRange(int trackId, int start, int end = -1, bool listCompositions = true);
 
+    /* @brief Returns a hash of everything that affects the video rendered between start and end (excluded):
+     * the clips and compositions intersecting the range with their position relative to start, the effects, and the video track states.
+     * Clips are identified by the content of their bin clip, with its bin effects and the producer properties changing the rendered frames.
+     * It does not depend on the item ids, so that identical content gets the same hash. It only depends on the absolute position of the range
+     * when the master or a video track has effects, since their keyframes are in timeline time.
+     */
+    QByteArray getVideoContentHash(int start, int end);
+
     /* @brief Returns a list of all luma files used in the project
      */
     QStringList extractCompositionLumas() const;
@@ -31,6 +31,36 @@
 #include <QModelIndex>
 #include <mlt++/MltTransition.h>
 
+#include <algorithm>
+#include <iterator>
+
+namespace {
+// Insert an id in a sorted vector of ids, if it is not already present
+void insertSortedId(std::vector<int> &ids, int id)
+{
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it == ids.end() || *it != id) {
+        ids.insert(it, id);
+    }
+}
+
+void removeSortedId(std::vector<int> &ids, int id)
+{
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it != ids.end() && *it == id) {
+        ids.erase(it);
+    }
+}
+
+// Returns the index of an id in a sorted vector of ids
+int sortedIdIndex(const std::vector<int> &ids, int id)
+{
+    auto it = std::lower_bound(ids.cbegin(), ids.cend(), id);
+    Q_ASSERT(it != ids.cend() && *it == id);
+    return (int)std::distance(ids.cbegin(), it);
+}
+} // namespace
+
 TrackModel::TrackModel(const std::weak_ptr<TimelineModel> &parent, int id, const QString &trackName, bool audioTrack)
     : m_parent(parent)
     , m_id(id == -1 ? TimelineModel::getNextId() : id)
@@ -143,8 +173,10 @@ Fun TrackModel::requestClipInsertion_lambda(int clipId, int position, bool updat
         if (auto ptr = m_parent.lock()) {
             std::shared_ptr<ClipModel> clip = ptr->getClipPtr(clipId);
             m_allClips[clip->getId()] = clip; // store clip
+            insertSortedId(m_clipRows, clipId);
             // update clip position and track
             clip->setPosition(position);
+            m_clipsPos[position] = clipId;
             clip->setSubPlaylistIndex(subPlaylist);
             int new_in = clip->getPosition();
             int new_out = new_in + clip->getPlaytime();
@@ -325,7 +357,12 @@ Fun TrackModel::requestClipDeletion_lambda(int clipId, bool updateView, bool fin
             m_playlists[target_track].consolidate_blanks();
             m_allClips[clipId]->setCurrentTrackId(-1);
             m_allClips[clipId]->setSubPlaylistIndex(-1);
+            auto indexed = m_clipsPos.find(m_allClips[clipId]->getPosition());
+            if (indexed != m_clipsPos.end() && indexed->second == clipId) {
+                m_clipsPos.erase(indexed);
+            }
             m_allClips.erase(clipId);
+            removeSortedId(m_clipRows, clipId);
             delete prod;
             m_playlists[target_track].unlock();
             if (auto ptr = m_parent.lock()) {
@@ -566,6 +603,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
             m_playlists[target_track].insert_blank(blank_index, delta - 1);
             if (!right) {
                 m_allClips[clipId]->setPosition(clip_position + delta);
+                updateClipPosition(clipId, clip_position, clip_position + delta);
                 // Because we inserted blank before, the index of our clip has increased
                 target_clip_mutable++;
             }
@@ -648,7 +686,9 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
                     err = m_playlists[target_track].resize_clip(target_clip_mutable, in, out);
                 }
                 if (!right && err == 0) {
+                    int old_position = m_allClips[clipId]->getPosition();
                     m_allClips[clipId]->setPosition(m_playlists[target_track].clip_start(target_clip_mutable));
+                    updateClipPosition(clipId, old_position, m_allClips[clipId]->getPosition());
                 }
                 if (err == 0) {
                     update_snaps(m_allClips[clipId]->getPosition(), m_allClips[clipId]->getPosition() + out - in + 1);
@@ -715,36 +755,132 @@ int TrackModel::getCompositionByPosition(int position)
 int TrackModel::getClipByRow(int row) const
 {
     READ_LOCK();
-    if (row >= static_cast<int>(m_allClips.size())) {
+    if (row < 0 || row >= static_cast<int>(m_clipRows.size())) {
         return -1;
     }
-    auto it = m_allClips.cbegin();
-    std::advance(it, row);
-    return (*it).first;
+    return m_clipRows[(size_t)row];
 }
 
 std::unordered_set<int> TrackModel::getClipsInRange(int position, int end)
 {
     READ_LOCK();
     std::unordered_set<int> ids;
-    for (const auto &clp : m_allClips) {
-        int pos = clp.second->getPosition();
-        int length = clp.second->getPlaytime();
-        if (end > -1 && pos >= end) {
+    // Clips don't overlap, so only the clip starting right before position can intersect the range among the ones that start before it
+    auto it = m_clipsPos.lower_bound(position);
+    if (it != m_clipsPos.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + m_allClips.at(prev->second)->getPlaytime() - 1 >= position && (end == -1 || prev->first < end)) {
+            ids.insert(prev->second);
+        }
+    }
+    for (; it != m_clipsPos.end() && (end == -1 || it->first < end); ++it) {
+        ids.insert(it->second);
+    }
+    return ids;
+}
+
+namespace {
+// Helpers for the move checks, working the same way on clips and compositions since both are indexed by position
+template <typename Items>
+bool canMoveIndexedItems(const Items &items, const std::map<int, int> &positions, const std::unordered_set<int> &ids, int delta)
+{
+    for (int id : ids) {
+        auto item = items.find(id);
+        if (item == items.end()) {
             continue;
         }
-        if (pos >= position || pos + length - 1 >= position) {
-            ids.insert(clp.first);
+        int in = item->second->getPosition() + delta;
+        if (in < 0) {
+            return false;
+        }
+        int end = in + item->second->getPlaytime();
+        auto it = positions.lower_bound(in);
+        if (it != positions.begin()) {
+            auto prev = std::prev(it);
+            if (ids.count(prev->second) == 0 && prev->first + items.at(prev->second)->getPlaytime() > in) {
+                return false;
+            }
+        }
+        for (; it != positions.end() && it->first < end; ++it) {
+            if (ids.count(it->second) == 0) {
+                return false;
+            }
         }
     }
-    return ids;
+    return true;
+}
+
+template <typename Items>
+int freeSlideOfIndexedItems(const Items &items, const std::map<int, int> &positions, const std::unordered_set<int> &ids, bool after)
+{
+    int first = INT_MAX;
+    int remaining = 0;
+    for (int id : ids) {
+        auto item = items.find(id);
+        if (item != items.end()) {
+            first = qMin(first, item->second->getPosition());
+            remaining++;
+        }
+    }
+    int result = INT_MAX;
+    if (remaining == 0) {
+        return result;
+    }
+    auto it = positions.lower_bound(first);
+    if (after) {
+        // The moved item ending last before each other item limits the move
+        int pendingEnd = -1;
+        for (; it != positions.end() && (remaining > 0 || pendingEnd >= 0); ++it) {
+            if (ids.count(it->second) > 0) {
+                pendingEnd = it->first + items.at(it->second)->getPlaytime();
+                remaining--;
+            } else if (pendingEnd >= 0) {
+                result = qMin(result, it->first - pendingEnd);
+                pendingEnd = -1;
+            }
+        }
+        return result;
+    }
+    // The first moved item after each other item limits the move
+    int obstacleEnd = 0;
+    if (it != positions.begin()) {
+        auto prev = std::prev(it);
+        obstacleEnd = prev->first + items.at(prev->second)->getPlaytime();
+    }
+    bool afterObstacle = true;
+    for (; it != positions.end() && remaining > 0; ++it) {
+        if (ids.count(it->second) > 0) {
+            if (afterObstacle) {
+                result = qMin(result, it->first - obstacleEnd);
+                afterObstacle = false;
+            }
+            remaining--;
+        } else {
+            obstacleEnd = it->first + items.at(it->second)->getPlaytime();
+            afterObstacle = true;
+        }
+    }
+    return result;
+}
+} // namespace
+
+bool TrackModel::canMoveItems(const std::unordered_set<int> &ids, int delta) const
+{
+    READ_LOCK();
+    return canMoveIndexedItems(m_allClips, m_clipsPos, ids, delta) && canMoveIndexedItems(m_allCompositions, m_compoPos, ids, delta);
+}
+
+int TrackModel::getFreeSlide(const std::unordered_set<int> &ids, bool after) const
+{
+    READ_LOCK();
+    return qMin(freeSlideOfIndexedItems(m_allClips, m_clipsPos, ids, after), freeSlideOfIndexedItems(m_allCompositions, m_compoPos, ids, after));
 }
 
 int TrackModel::getRowfromClip(int clipId) const
 {
     READ_LOCK();
     Q_ASSERT(m_allClips.count(clipId) > 0);
-    return (int)std::distance(m_allClips.begin(), m_allClips.find(clipId));
+    return sortedIdIndex(m_clipRows, clipId);
 }
 
 std::unordered_set<int> TrackModel::getCompositionsInRange(int position, int end)
@@ -752,17 +888,17 @@ std::unordered_set<int> TrackModel::getCompositionsInRange(int position, int end
     READ_LOCK();
     // TODO: this function doesn't take into accounts the fact that there are two tracks
     std::unordered_set<int> ids;
-    for (const auto &compo : m_allCompositions) {
-        int pos = compo.second->getPosition();
-        int length = compo.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
-        }
-        if (pos >= position || pos + length - 1 >= position) {
-            
-            ids.insert(compo.first);
+    // Compositions of a track never intersect (see hasIntersectingComposition), so we use the same strategy as for clips
+    auto it = m_compoPos.lower_bound(position);
+    if (it != m_compoPos.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + m_allCompositions.at(prev->second)->getPlaytime() - 1 >= position && (end == -1 || prev->first < end)) {
+            ids.insert(prev->second);
         }
     }
+    for (; it != m_compoPos.end() && (end == -1 || it->first < end); ++it) {
+        ids.insert(it->second);
+    }
     return ids;
 }
 
@@ -770,7 +906,16 @@ int TrackModel::getRowfromComposition(int tid) const
 {
     READ_LOCK();
     Q_ASSERT(m_allCompositions.count(tid) > 0);
-    return (int)m_allClips.size() + (int)std::distance(m_allCompositions.begin(), m_allCompositions.find(tid));
+    return (int)m_allClips.size() + sortedIdIndex(m_compoRows, tid);
+}
+
+void TrackModel::updateClipPosition(int clipId, int oldPosition, int newPosition)
+{
+    auto it = m_clipsPos.find(oldPosition);
+    if (it != m_clipsPos.end() && it->second == clipId) {
+        m_clipsPos.erase(it);
+    }
+    m_clipsPos[newPosition] = clipId;
 }
 
 QVariant TrackModel::getProperty(const QString &name) const
@@ -916,8 +1061,21 @@ bool TrackModel::checkConsistency()
         return false;
     }
 
+    // We now check the clips position index
+    if (m_allClips.size() != m_clipsPos.size() || m_allClips.size() != m_clipRows.size()) {
+        qDebug() << "Error: the number of indexed clips doesn't match number of clips";
+        return false;
+    }
+    for (const auto &c : m_allClips) {
+        int pos = c.second->getPosition();
+        if (m_clipsPos.count(pos) == 0 || m_clipsPos[pos] != c.first) {
+            qDebug() << "Error: the position of clip " << c.first << " is not properly indexed";
+            return false;
+        }
+    }
+
     // We now check compositions positions
-    if (m_allCompositions.size() != m_compoPos.size()) {
+    if (m_allCompositions.size() != m_compoPos.size() || m_allCompositions.size() != m_compoRows.size()) {
         qDebug() << "Error: the number of compositions position doesn't match number of compositions";
         return false;
     }
@@ -1148,6 +1306,7 @@ Fun TrackModel::requestCompositionDeletion_lambda(int compoId, bool updateView,
         }
         m_allCompositions[compoId]->setCurrentTrackId(-1);
         m_allCompositions.erase(compoId);
+        removeSortedId(m_compoRows, compoId);
         m_compoPos.erase(old_in);
         ptr->m_snaps->removePoint(old_in);
         ptr->m_snaps->removePoint(old_out);
@@ -1165,9 +1324,11 @@ int TrackModel::getCompositionByRow(int row) const
         return -1;
     }
     Q_ASSERT(row <= (int)m_allClips.size() + (int)m_allCompositions.size());
-    auto it = m_allCompositions.cbegin();
-    std::advance(it, row - (int)m_allClips.size());
-    return (*it).first;
+    int compoRow = row - (int)m_allClips.size();
+    if (compoRow >= (int)m_compoRows.size()) {
+        return -1;
+    }
+    return m_compoRows[(size_t)compoRow];
 }
 
 int TrackModel::getCompositionsCount() const
@@ -1191,6 +1352,7 @@ Fun TrackModel::requestCompositionInsertion_lambda(int compoId, int position, bo
             if (auto ptr = m_parent.lock()) {
                 std::shared_ptr<CompositionModel> composition = ptr->getCompositionPtr(compoId);
                 m_allCompositions[composition->getId()] = composition; // store clip
+                insertSortedId(m_compoRows, composition->getId());
                 // update clip position and track
                 composition->setCurrentTrackId(getId());
                 int new_in = position;
@@ -31,6 +31,7 @@
 #include <mlt++/MltTractor.h>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 class TimelineModel;
 class ClipModel;
@@ -257,10 +258,19 @@ protected:
 
     int trackDuration() const;
 
+    /* @brief Updates the position of a clip in the position index. This must be called each time the position of a clip of the track changes */
+    void updateClipPosition(int clipId, int oldPosition, int newPosition);
+
     /* @brief Returns the list of the ids of the clips that intersect the given range */
     std::unordered_set<int> getClipsInRange(int position, int end = -1);
     /* @brief Returns the list of the ids of the compositions that intersect the given range */
     std::unordered_set<int> getCompositionsInRange(int position, int end);
+    /* @brief Returns true if the given items of this track can be moved by delta frames without overlapping the other items of the track.
+       This only looks at the position indexes, the playlists are not touched. Items that are not on this track are ignored */
+    bool canMoveItems(const std::unordered_set<int> &ids, int delta) const;
+    /* @brief Returns how many frames the given items of this track can slide forward (or backward) before they overlap another item
+       of the track or reach the timeline start. Returns INT_MAX if nothing limits the move */
+    int getFreeSlide(const std::unordered_set<int> &ids, bool after) const;
 
     /* @brief Import effects from a service that contains some (another track) */
     bool importEffects(std::weak_ptr<Mlt::Service> service);
@@ -291,6 +301,12 @@ private:
     std::map<int, int> m_compoPos; // We store the positions of the compositions. In Melt, the compositions are not inserted at the track level, but we keep
                                    // those positions here to check for moves and resize
 
+    std::map<int, int> m_clipsPos; // Position ordered index of the clips (position -> clip id). Clips of a track never overlap, so this allows range queries
+                                   // in O(log n + k). It is kept in sync on insertion, deletion and resize
+
+    std::vector<int> m_clipRows;  // Sorted ids of the clips, so that the row of a clip is found by dichotomy
+    std::vector<int> m_compoRows; // Sorted ids of the compositions, so that the row of a composition is found by dichotomy
+
     mutable QReadWriteLock m_lock; // This is a lock that ensures safety in case of concurrent access
 
 protected:
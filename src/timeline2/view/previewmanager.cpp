@@ -27,9 +27,38 @@
 #include "timeline2/view/timelinecontroller.h"
 
 #include <KLocalizedString>
+#include <QCryptographicHash>
 #include <QProcess>
 #include <QStandardPaths>
-#include <QCollator>
+#include <QThread>
+#include <QtConcurrent>
+
+namespace {
+// Number of rendered chunks that are not used in the timeline anymore, but kept in case an undo or a move makes them valid again
+const int maxUnusedChunks = 500;
+
+// Mark a chunk as recently used, so that it is the last one to be removed from the cache
+void touchChunk(const QString &path)
+{
+    QFile file(path);
+    if (file.open(QIODevice::Append)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+}
+
+// Hash of the timeline content and rendering parameters of each chunk, run outside of the GUI thread
+QMap<int, QString> hashChunks(const std::shared_ptr<TimelineItemModel> &model, const QList<int> &frames, int chunkSize, const QByteArray &parameters)
+{
+    QMap<int, QString> hashes;
+    for (int frame : frames) {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(model->getVideoContentHash(frame, frame + chunkSize));
+        hash.addData(parameters);
+        hashes.insert(frame, QString::fromLatin1(hash.result().toHex()));
+    }
+    return hashes;
+}
+} // namespace
 
 PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tractor)
     : QObject()
@@ -39,11 +68,14 @@ PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tra
     , m_previewTrack(nullptr)
     , m_overlayTrack(nullptr)
     , m_previewTrackIndex(-1)
+    , m_hashesOutdated(false)
+    , m_renderRequested(false)
     , m_initialized(false)
 {
     m_previewGatherTimer.setSingleShot(true);
     m_previewGatherTimer.setInterval(200);
     QObject::connect(&m_previewProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &PreviewManager::processEnded);
+    connect(&m_hashWatcher, &QFutureWatcher<QMap<int, QString>>::finished, this, &PreviewManager::slotChunksHashed);
 
 
     // Find path for Kdenlive renderer
@@ -64,11 +96,9 @@ PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tra
 
 PreviewManager::~PreviewManager()
 {
+    m_hashWatcher.waitForFinished();
     if (m_initialized) {
         abortRendering();
-        if (m_undoDir.dirName() == QLatin1String("undo")) {
-            m_undoDir.removeRecursively();
-        }
         if ((pCore->currentDoc()->url().isEmpty() && m_cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot).isEmpty()) ||
             m_cacheDir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot).isEmpty()) {
             if (m_cacheDir.dirName() == QLatin1String("preview")) {
@@ -97,8 +127,7 @@ bool PreviewManager::initialize()
         pCore->displayMessage(i18n("Cannot create folder %1", m_cacheDir.absolutePath()), ErrorMessage);
         return false;
     }
-    if (m_cacheDir.dirName() != QLatin1String("preview") || m_cacheDir == QDir() ||
-        (!m_cacheDir.exists(QStringLiteral("undo")) && !m_cacheDir.mkdir(QStringLiteral("undo"))) || !m_cacheDir.absolutePath().contains(documentId)) {
+    if (m_cacheDir.dirName() != QLatin1String("preview") || m_cacheDir == QDir() || !m_cacheDir.absolutePath().contains(documentId)) {
         pCore->displayMessage(i18n("Something is wrong with cache folder %1", m_cacheDir.absolutePath()), ErrorMessage);
         return false;
     }
@@ -106,16 +135,19 @@ bool PreviewManager::initialize()
         pCore->displayMessage(i18n("Invalid timeline preview parameters"), ErrorMessage);
         return false;
     }
-    m_undoDir = QDir(m_cacheDir.absoluteFilePath(QStringLiteral("undo")));
 
     // Make sure our cache dirs are inside the temporary folder
-    if (!m_cacheDir.makeAbsolute() || !m_undoDir.makeAbsolute() || !m_undoDir.mkpath(QStringLiteral("."))) {
+    if (!m_cacheDir.makeAbsolute()) {
         pCore->displayMessage(i18n("Something is wrong with cache folders"), ErrorMessage);
         return false;
     }
+    // Chunks used to be archived by undo index, they are now found by content
+    QDir legacyUndoDir = m_cacheDir;
+    if (legacyUndoDir.cd(QStringLiteral("undo"))) {
+        legacyUndoDir.removeRecursively();
+    }
 
     connect(this, &PreviewManager::cleanupOldPreviews, this, &PreviewManager::doCleanupOldPreviews);
-    connect(doc, &KdenliveDoc::removeInvalidUndo, this, &PreviewManager::slotRemoveInvalidUndo, Qt::DirectConnection);
     m_previewTimer.setSingleShot(true);
     m_previewTimer.setInterval(3000);
     connect(&m_previewTimer, &QTimer::timeout, this, &PreviewManager::startPreviewRender);
@@ -140,7 +172,7 @@ bool PreviewManager::buildPreviewTrack()
     return true;
 }
 
-void PreviewManager::loadChunks(QVariantList previewChunks, QVariantList dirtyChunks, const QDateTime &documentDate)
+void PreviewManager::loadChunks(QVariantList previewChunks, QVariantList dirtyChunks)
 {
     if (previewChunks.isEmpty()) {
         previewChunks = m_renderedChunks;
@@ -148,18 +180,10 @@ void PreviewManager::loadChunks(QVariantList previewChunks, QVariantList dirtyCh
     if (dirtyChunks.isEmpty()) {
         dirtyChunks = m_dirtyChunks;
     }
+    // Chunks are named after their content: the previous renders are plugged back once the chunks are hashed, the others stay dirty
     for (const auto &frame : previewChunks) {
-        const QString fileName = m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(frame.toInt()).arg(m_extension));
-        QFile file(fileName);
-        if (file.exists()) {
-            if (!documentDate.isNull() && QFileInfo(file).lastModified() > documentDate) {
-                // Timeline preview file was created after document, invalidate
-                file.remove();
-                dirtyChunks << frame;
-            } else {
-                gotPreviewRender(frame.toInt(), fileName, 1000);
-            }
-        } else {
+        m_renderedChunks.removeAll(frame);
+        if (!dirtyChunks.contains(frame)) {
             dirtyChunks << frame;
         }
     }
@@ -173,6 +197,7 @@ void PreviewManager::loadChunks(QVariantList previewChunks, QVariantList dirtyCh
             }
         }
         m_controller->dirtyChunksChanged();
+        requestHashes();
     }
 }
 
@@ -184,6 +209,8 @@ void PreviewManager::deletePreviewTrack()
     m_previewTrack = nullptr;
     m_dirtyChunks.clear();
     m_renderedChunks.clear();
+    m_chunkHashes.clear();
+    m_dirtyHashes.clear();
     m_controller->dirtyChunksChanged();
     m_controller->renderedChunksChanged();
     m_tractor->unlock();
@@ -194,6 +221,106 @@ const QDir PreviewManager::getCacheDir() const
     return m_cacheDir;
 }
 
+QByteArray PreviewManager::renderParameters() const
+{
+    QByteArray parameters = pCore->getCurrentProfilePath().toUtf8();
+    parameters.append(m_consumerParams.join(QLatin1Char(' ')).toUtf8());
+    parameters.append(m_extension.toUtf8());
+    parameters.append(pCore->currentDoc()->getDocumentProperty(QStringLiteral("compositing")).toUtf8());
+    return parameters;
+}
+
+void PreviewManager::requestHashes()
+{
+    if (m_hashWatcher.isRunning()) {
+        // The chunks still missing are hashed when the current job is done
+        return;
+    }
+    QList<int> frames;
+    for (const QVariant &frame : m_dirtyChunks) {
+        if (!m_dirtyHashes.contains(frame.toInt())) {
+            frames << frame.toInt();
+        }
+    }
+    if (frames.isEmpty()) {
+        useHashedChunks();
+        return;
+    }
+    m_changedWhileHashing.clear();
+    m_hashesOutdated = false;
+    std::shared_ptr<TimelineItemModel> model = m_controller->getModel();
+    const QByteArray parameters = renderParameters();
+    const int chunkSize = KdenliveSettings::timelinechunks();
+    m_hashWatcher.setFuture(QtConcurrent::run([model, frames, chunkSize, parameters]() { return hashChunks(model, frames, chunkSize, parameters); }));
+}
+
+void PreviewManager::slotChunksHashed()
+{
+    QMutexLocker lock(&m_previewMutex);
+    const QMap<int, QString> hashes = m_hashWatcher.result();
+    if (!m_hashesOutdated) {
+        for (auto it = hashes.constBegin(); it != hashes.constEnd(); ++it) {
+            if (!m_changedWhileHashing.contains(it.key()) && m_dirtyChunks.contains(QVariant(it.key()))) {
+                m_dirtyHashes.insert(it.key(), it.value());
+            }
+        }
+    }
+    m_changedWhileHashing.clear();
+    // Hash again the chunks that changed meanwhile
+    requestHashes();
+}
+
+void PreviewManager::useHashedChunks()
+{
+    // Reuse the chunks already rendered for the same content, for example after an undo or a move
+    QVariantList foundChunks;
+    for (const QVariant &frame : m_dirtyChunks) {
+        const QString hash = m_dirtyHashes.value(frame.toInt());
+        if (hash.isEmpty()) {
+            continue;
+        }
+        const QString fileName = chunkFile(hash);
+        if (QFile::exists(fileName)) {
+            touchChunk(fileName);
+            m_chunkHashes.insert(frame.toInt(), hash);
+            foundChunks << frame;
+        }
+    }
+    if (!foundChunks.isEmpty()) {
+        for (const QVariant &frame : foundChunks) {
+            m_dirtyChunks.removeAll(frame);
+            m_dirtyHashes.remove(frame.toInt());
+            m_renderedChunks << frame;
+        }
+        std::sort(foundChunks.begin(), foundChunks.end());
+        m_controller->dirtyChunksChanged();
+        m_controller->renderedChunksChanged();
+        reloadChunks(foundChunks);
+    }
+    if (m_renderRequested) {
+        m_renderRequested = false;
+        if (!m_dirtyChunks.isEmpty()) {
+            const QString sceneList = m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt"));
+            pCore->getMonitor(Kdenlive::ProjectMonitor)->sceneList(m_cacheDir.absolutePath(), sceneList);
+            pCore->currentDoc()->saveMltPlaylist(sceneList);
+            doPreviewRender(sceneList);
+        }
+    }
+}
+
+QString PreviewManager::chunkFile(const QString &hash) const
+{
+    return m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(hash, m_extension));
+}
+
+void PreviewManager::removeChunkFile(int frame)
+{
+    QString hash = m_chunkHashes.take(frame);
+    if (!hash.isEmpty() && !m_chunkHashes.values().contains(hash)) {
+        QFile::remove(chunkFile(hash));
+    }
+}
+
 void PreviewManager::reconnectTrack()
 {
     disconnectTrack();
@@ -293,10 +420,13 @@ bool PreviewManager::loadParams()
     if (KdenliveSettings::gpu_accel()) {
         m_consumerParams << QStringLiteral("glsl.=1");
     }
+    // The parameters are part of the chunk hashes
+    m_dirtyHashes.clear();
+    m_hashesOutdated = true;
     return true;
 }
 
-void PreviewManager::invalidatePreviews(const QVariantList chunks)
+void PreviewManager::invalidatePreviews()
 {
     QMutexLocker lock(&m_previewMutex);
     bool timer = KdenliveSettings::autopreview();
@@ -304,76 +434,9 @@ void PreviewManager::invalidatePreviews(const QVariantList chunks)
         m_previewTimer.stop();
         timer = true;
     }
-    KdenliveDoc *doc = pCore->currentDoc();
-    int stackIx = doc->commandStack()->index();
-    int stackMax = doc->commandStack()->count();
-    if (stackIx == stackMax && !m_undoDir.exists(QString::number(stackIx - 1))) {
-        // We just added a new command in stack, archive existing chunks
-        int ix = stackIx - 1;
-        m_undoDir.mkdir(QString::number(ix));
-        bool foundPreviews = false;
-        for (const auto &i : chunks) {
-            QString current = QStringLiteral("%1.%2").arg(i.toInt()).arg(m_extension);
-            if (m_cacheDir.rename(current, QStringLiteral("undo/%1/%2").arg(ix).arg(current))) {
-                foundPreviews = true;
-            }
-        }
-        if (!foundPreviews) {
-            // No preview files found, remove undo folder
-            m_undoDir.rmdir(QString::number(ix));
-        } else {
-            // new chunks archived, cleanup old ones
-            emit cleanupOldPreviews();
-        }
-    } else {
-        // Restore existing chunks, delete others
-        // Check if we just undo the last stack action, then backup, otherwise delete
-        bool lastUndo = false;
-        if (stackIx + 1 == stackMax) {
-            if (!m_undoDir.exists(QString::number(stackMax))) {
-                lastUndo = true;
-                bool foundPreviews = false;
-                m_undoDir.mkdir(QString::number(stackMax));
-                for (const auto &i : chunks) {
-                    QString current = QStringLiteral("%1.%2").arg(i.toInt()).arg(m_extension);
-                    if (m_cacheDir.rename(current, QStringLiteral("undo/%1/%2").arg(stackMax).arg(current))) {
-                        foundPreviews = true;
-                    }
-                }
-                if (!foundPreviews) {
-                    m_undoDir.rmdir(QString::number(stackMax));
-                }
-            }
-        }
-        bool moveFile = true;
-        QDir tmpDir = m_undoDir;
-        if (!tmpDir.cd(QString::number(stackIx))) {
-            moveFile = false;
-        }
-        QVariantList foundChunks;
-        for (const auto &i : chunks) {
-            QString cacheFileName = QStringLiteral("%1.%2").arg(i.toInt()).arg(m_extension);
-            if (!lastUndo) {
-                m_cacheDir.remove(cacheFileName);
-            }
-            if (moveFile) {
-                if (QFile::copy(tmpDir.absoluteFilePath(cacheFileName), m_cacheDir.absoluteFilePath(cacheFileName))) {
-                    foundChunks << i;
-                    m_dirtyChunks.removeAll(i);
-                    m_renderedChunks << i;
-                } else {
-                    qDebug() << "// ERROR PROCESSE CHUNK: " << i << ", " << cacheFileName;
-                }
-            }
-        }
-        if (!foundChunks.isEmpty()) {
-            std::sort(foundChunks.begin(), foundChunks.end());
-            m_controller->dirtyChunksChanged();
-            m_controller->renderedChunksChanged();
-            reloadChunks(foundChunks);
-        }
-    }
-    doc->setModified(true);
+    // Chunks rendered for the same content are plugged back once hashed, for example after an undo or a move
+    requestHashes();
+    pCore->currentDoc()->setModified(true);
     if (timer) {
         m_previewTimer.start();
     }
@@ -381,22 +444,23 @@ void PreviewManager::invalidatePreviews(const QVariantList chunks)
 
 void PreviewManager::doCleanupOldPreviews()
 {
-    if (m_undoDir.dirName() != QLatin1String("undo")) {
+    if (m_cacheDir.dirName() != QLatin1String("preview")) {
         return;
     }
-    QStringList dirs = m_undoDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-
-    // Use QCollator to do a natural sorting so that 10 is after 2
-    QCollator collator;
-    collator.setNumericMode(true);
-    std::sort(dirs.begin(), dirs.end(), [&collator](const QString &file1, const QString &file2) { return collator.compare(file1, file2) < 0; });
-    bool ok;
-    while (dirs.count() > 5) {
-        QDir tmp = m_undoDir;
-        QString dirName = dirs.takeFirst();
-        dirName.toInt(&ok);
-        if (ok && tmp.cd(dirName)) {
-            tmp.removeRecursively();
+    QStringList usedFiles;
+    for (const QString &hash : m_chunkHashes) {
+        usedFiles << QStringLiteral("%1.%2").arg(hash, m_extension);
+    }
+    // Most recently used first
+    QFileInfoList files = m_cacheDir.entryInfoList({QStringLiteral("*.") + m_extension}, QDir::Files, QDir::Time);
+    int unused = 0;
+    for (const QFileInfo &file : files) {
+        // Only consider content addressed chunks (sha1 names)
+        if (file.completeBaseName().length() != 40 || usedFiles.contains(file.fileName())) {
+            continue;
+        }
+        if (++unused > maxUnusedChunks) {
+            m_cacheDir.remove(file.fileName());
         }
     }
 }
@@ -408,7 +472,7 @@ void PreviewManager::clearPreviewRange(bool resetZones)
     m_tractor->lock();
     bool hasPreview = m_previewTrack != nullptr;
     for (const auto &ix : m_renderedChunks) {
-        m_cacheDir.remove(QStringLiteral("%1.%2").arg(ix.toInt()).arg(m_extension));
+        removeChunkFile(ix.toInt());
         if (!m_dirtyChunks.contains(ix)) {
             m_dirtyChunks << ix;
         }
@@ -471,7 +535,7 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
         m_tractor->lock();
         bool hasPreview = m_previewTrack != nullptr;
         for (int ix : toRemove) {
-            m_cacheDir.remove(QStringLiteral("%1.%2").arg(ix).arg(m_extension));
+            removeChunkFile(ix);
             if (!hasPreview) {
                 continue;
             }
@@ -495,6 +559,7 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
 
 void PreviewManager::abortRendering()
 {
+    m_renderRequested = false;
     if (m_previewProcess.state() == QProcess::NotRunning) {
         return;
     }
@@ -521,11 +586,10 @@ void PreviewManager::startPreviewRender()
         m_waitingThumbs.clear();
         // clear log
         m_errorLog.clear();
-        const QString sceneList = m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt"));
-        pCore->getMonitor(Kdenlive::ProjectMonitor)->sceneList(m_cacheDir.absolutePath(), sceneList);
-        pCore->currentDoc()->saveMltPlaylist(sceneList);
         m_previewTimer.stop();
-        doPreviewRender(sceneList);
+        // Rendering starts once the content of the chunks is hashed
+        m_renderRequested = true;
+        requestHashes();
     }
 }
 
@@ -541,10 +605,22 @@ void PreviewManager::receivedStderr()
         } else if (result.startsWith(QLatin1String("DONE:"))) {
             int chunk = result.section(QLatin1String("DONE:"), 1).simplified().toInt();
             m_processedChunks++;
-            QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
+            // The renderer names chunks by frame, store them by content
+            const QString renderedFile = m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(chunk).arg(m_extension));
+            const QString hash = m_renderHashes.take(chunk);
+            QString fileName = renderedFile;
+            if (!hash.isEmpty()) {
+                fileName = chunkFile(hash);
+                if (QFile::exists(fileName) || QFile::rename(renderedFile, fileName)) {
+                    QFile::remove(renderedFile);
+                    m_chunkHashes.insert(chunk, hash);
+                } else {
+                    fileName = renderedFile;
+                }
+            }
             qDebug() << "---------------\nJOB PROGRRESS: " << m_chunksToRender << ", " << m_processedChunks << " = "
                      << (100 * m_processedChunks / m_chunksToRender);
-            emit previewRender(chunk, m_cacheDir.absoluteFilePath(fileName), 1000 * m_processedChunks / m_chunksToRender);
+            emit previewRender(chunk, fileName, 1000 * m_processedChunks / m_chunksToRender);
         } else {
             m_errorLog.append(result);
         }
@@ -560,16 +636,31 @@ void PreviewManager::doPreviewRender(const QString &scene)
     }
     Q_ASSERT(m_previewProcess.state() == QProcess::NotRunning);
 
+    // The content of the chunks was hashed before starting, the rendering is aborted if the timeline changes
     QStringList chunks;
-    for (QVariant &frame : m_dirtyChunks) {
+    m_renderHashes.clear();
+    for (const QVariant &frame : m_dirtyChunks) {
+        // The renderer keeps existing files, remove any leftover of an interrupted render
+        m_cacheDir.remove(QStringLiteral("%1.%2").arg(frame.toInt()).arg(m_extension));
+        m_renderHashes.insert(frame.toInt(), m_dirtyHashes.value(frame.toInt()));
         chunks << frame.toString();
     }
-    m_chunksToRender = m_dirtyChunks.count();
+    // Render the chunks closest to the playhead first, they are the ones the user is about to watch
+    int position = pCore->getTimelinePosition();
+    std::stable_sort(chunks.begin(), chunks.end(),
+                     [position](const QString &a, const QString &b) { return qAbs(a.toInt() - position) < qAbs(b.toInt() - position); });
+    m_chunksToRender = chunks.count();
     m_processedChunks = 0;
     int chunkSize = KdenliveSettings::timelinechunks();
+    int workers = KdenliveSettings::previewworkers();
+    if (workers <= 0) {
+        // Each chunk render is itself multithreaded, keep some cores for the encoder threads and the UI
+        workers = qMax(1, QThread::idealThreadCount() / 4);
+    }
     QStringList args{KdenliveSettings::rendererpath(),
                      scene,
                      m_cacheDir.absolutePath(),
+                     QStringLiteral("-workers:%1").arg(qMin(workers, chunks.count())),
                      QStringLiteral("-split"),
                      chunks.join(QLatin1Char(',')),
                      QString::number(chunkSize - 1),
@@ -592,8 +683,9 @@ void PreviewManager::processEnded(int, QProcess::ExitStatus status)
     if (status == QProcess::QProcess::CrashExit) {
         qDebug() << "// PROCESS CRASHED!!!!!!";
         pCore->currentDoc()->previewProgress(-1);
-        if (workingPreview >= 0) {
-            const QString fileName = QStringLiteral("%1.%2").arg(workingPreview).arg(m_extension);
+        // Several chunks may have been in progress, remove all unfinished files
+        for (auto it = m_renderHashes.constBegin(); it != m_renderHashes.constEnd(); ++it) {
+            const QString fileName = QStringLiteral("%1.%2").arg(it.key()).arg(m_extension);
             if (m_cacheDir.exists(fileName)) {
                 m_cacheDir.remove(fileName);
             }
@@ -603,6 +695,7 @@ void PreviewManager::processEnded(int, QProcess::ExitStatus status)
     }
     workingPreview = -1;
     m_controller->workingPreviewChanged();
+    emit cleanupOldPreviews();
 }
 
 void PreviewManager::slotProcessDirtyChunks()
@@ -610,31 +703,12 @@ void PreviewManager::slotProcessDirtyChunks()
     if (m_dirtyChunks.isEmpty()) {
         return;
     }
-    invalidatePreviews(m_dirtyChunks);
+    invalidatePreviews();
     if (KdenliveSettings::autopreview()) {
         m_previewTimer.start();
     }
 }
 
-void PreviewManager::slotRemoveInvalidUndo(int ix)
-{
-    QMutexLocker lock(&m_previewMutex);
-    if (m_undoDir.dirName() != QLatin1String("undo")) {
-        // Make sure we delete correct folder
-        return;
-    }
-    QStringList dirs = m_undoDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-    bool ok;
-    for (const QString &dir : dirs) {
-        if (dir.toInt(&ok) >= ix && ok) {
-            QDir tmp = m_undoDir;
-            if (tmp.cd(dir)) {
-                tmp.removeRecursively();
-            }
-        }
-    }
-}
-
 void PreviewManager::invalidatePreview(int startFrame, int endFrame)
 {
     int chunkSize = KdenliveSettings::timelinechunks();
@@ -648,6 +722,11 @@ void PreviewManager::invalidatePreview(int startFrame, int endFrame)
     bool hasPreview = m_previewTrack != nullptr;
     bool chunksChanged = false;
     for (int i = start; i <= end; i += chunkSize) {
+        // The content changed, a hash computed before is wrong
+        m_dirtyHashes.remove(i);
+        if (m_hashWatcher.isRunning()) {
+            m_changedWhileHashing.insert(i);
+        }
         if (m_renderedChunks.contains(i) && hasPreview) {
             int ix = m_previewTrack->get_clip_index_at(i);
             if (m_previewTrack->is_blank(ix)) {
@@ -656,6 +735,8 @@ void PreviewManager::invalidatePreview(int startFrame, int endFrame)
             Mlt::Producer *prod = m_previewTrack->replace_with_blank(ix);
             delete prod;
             QVariant val(i);
+            // The chunk file stays in the cache, it will be reused if this content comes back
+            m_chunkHashes.remove(i);
             m_renderedChunks.removeAll(val);
             if (!m_dirtyChunks.contains(val)) {
                 m_dirtyChunks << val;
@@ -680,7 +761,7 @@ void PreviewManager::reloadChunks(const QVariantList chunks)
     m_tractor->lock();
     for (const auto &ix : chunks) {
         if (m_previewTrack->is_blank_at(ix.toInt())) {
-            QString fileName = m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(ix.toInt()).arg(m_extension));
+            QString fileName = chunkFile(m_chunkHashes.value(ix.toInt()));
             fileName.prepend(QStringLiteral("avformat:"));
             Mlt::Producer prod(pCore->getCurrentProfile()->profile(), fileName.toUtf8().constData());
             if (prod.is_valid()) {
@@ -718,6 +799,7 @@ void PreviewManager::gotPreviewRender(int frame, const QString &file, int progre
         Mlt::Producer prod(pCore->getCurrentProfile()->profile(), QString("avformat:%1").arg(file).toUtf8().constData());
         if (prod.is_valid()) {
             m_dirtyChunks.removeAll(frame);
+            m_dirtyHashes.remove(frame);
             m_renderedChunks << frame;
             m_controller->renderedChunksChanged();
             prod.set("mlt_service", "avformat-novalidate");
@@ -747,7 +829,9 @@ void PreviewManager::corruptedChunk(int frame, const QString &fileName)
         m_controller->workingPreviewChanged();
     }
     emit previewRender(0, m_errorLog, -1);
-    m_cacheDir.remove(fileName);
+    m_chunkHashes.remove(frame);
+    m_renderedChunks.removeAll(frame);
+    QFile::remove(fileName);
     if (!m_dirtyChunks.contains(frame)) {
         m_dirtyChunks << frame;
         std::sort(m_dirtyChunks.begin(), m_dirtyChunks.end());
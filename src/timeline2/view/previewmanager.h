@@ -24,8 +24,11 @@
 
 #include <QDir>
 #include <QFuture>
+#include <QFutureWatcher>
+#include <QMap>
 #include <QMutex>
 #include <QProcess>
+#include <QSet>
 #include <QTimer>
 
 class TimelineController;
@@ -44,6 +47,8 @@ class Producer;
  * This allow us to get a preview with a smooth playback of our project.
  * Only the preview zone is rendered. Once defined, a preview zone shows as a red line below
  * the timeline ruler. As chunks are rendered, the zone turns to green.
+ * Chunk files are named after a hash of the timeline content they cover, so that a chunk
+ * rendered once is reused when the same content comes back (undo/redo, moved clips).
  */
 
 class PreviewManager : public QObject
@@ -59,8 +64,8 @@ public:
     bool initialize();
     /** @brief: a timeline operation caused changes to frames between startFrame and endFrame. */
     void invalidatePreview(int startFrame, int endFrame);
-    /** @brief: after a small  delay (some operations trigger several invalidatePreview calls), take care of these invalidated chunks. */
-    void invalidatePreviews(const QVariantList chunks);
+    /** @brief: after a small  delay (some operations trigger several invalidatePreview calls), take care of the invalidated chunks. */
+    void invalidatePreviews();
     /** @brief: user adds current timeline zone to the preview zone. */
     void addPreviewRange(const QPoint zone, bool add);
     /** @brief: Remove all existing previews. */
@@ -80,7 +85,7 @@ public:
     /** @brief: Returns directory currently used to store the preview files. */
     const QDir getCacheDir() const;
     /** @brief: Load existing ruler chunks. */
-    void loadChunks(QVariantList previewChunks, QVariantList dirtyChunks, const QDateTime &documentDate);
+    void loadChunks(QVariantList previewChunks, QVariantList dirtyChunks);
     int setOverlayTrack(Mlt::Playlist *overlay);
     /** @brief Remove the effect compare overlay track */
     void removeOverlayTrack();
@@ -104,8 +109,20 @@ private:
     QProcess m_previewProcess;
     /** @brief: The directory used to store the preview files. */
     QDir m_cacheDir;
-    /** @brief: The directory used to store undo history of preview files (child of m_cacheDir). */
-    QDir m_undoDir;
+    /** @brief: The content hash of each rendered chunk, by chunk frame. */
+    QMap<int, QString> m_chunkHashes;
+    /** @brief: The content hash of the chunks being rendered, computed when the rendering started. */
+    QMap<int, QString> m_renderHashes;
+    /** @brief: The content hash of the dirty chunks, kept until the chunk changes again. */
+    QMap<int, QString> m_dirtyHashes;
+    /** @brief: Hashing the timeline content of many chunks is slow, it runs in a thread. */
+    QFutureWatcher<QMap<int, QString>> m_hashWatcher;
+    /** @brief: Chunks invalidated while they were hashed, their result is outdated. */
+    QSet<int> m_changedWhileHashing;
+    /** @brief: The rendering parameters changed while hashing, the whole result is outdated. */
+    bool m_hashesOutdated;
+    /** @brief: Start rendering once the dirty chunks are hashed. */
+    bool m_renderRequested;
     QMutex m_previewMutex;
     QStringList m_consumerParams;
     QString m_extension;
@@ -130,18 +147,28 @@ private:
     void enable();
     /** @brief: Temporarily disable timeline preview track. */
     void disable();
+    /** @brief: Returns the rendering parameters that are part of the chunk hashes. */
+    QByteArray renderParameters() const;
+    /** @brief: Hash the dirty chunks in a thread, then reuse the matching rendered files and start the requested rendering. */
+    void requestHashes();
+    /** @brief: All dirty chunks are hashed, plug the ones already rendered and start rendering if requested. */
+    void useHashedChunks();
+    /** @brief: Returns the path of the file storing the chunk with given content hash. */
+    QString chunkFile(const QString &hash) const;
+    /** @brief: Delete the file of a rendered chunk, unless another chunk has the same content. */
+    void removeChunkFile(int frame);
 
 private slots:
-    /** @brief: To avoid filling the hard drive, remove preview undo history after 5 steps. */
+    /** @brief: To avoid filling the hard drive, remove the least recently used chunks that are not in the timeline anymore. */
     void doCleanupOldPreviews();
     /** @brief: Start the real rendering process. */
     void doPreviewRender(const QString &scene); // std::shared_ptr<Mlt::Producer> sourceProd);
-    /** @brief: If user does an undo, then makes a new timeline operation, delete undo history of more recent stack . */
-    void slotRemoveInvalidUndo(int ix);
     /** @brief: When the timer collecting invalid zones is done, process. */
     void slotProcessDirtyChunks();
     /** @brief: Process preview rendering output. */
     void receivedStderr();
+    /** @brief: The background hashing is done, store the result. */
+    void slotChunksHashed();
     void processEnded(int, QProcess::ExitStatus status);
 
 public slots:
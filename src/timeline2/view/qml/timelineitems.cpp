@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "kdenlivesettings.h"
 #include "core.h"
 #include "bin/projectitemmodel.h"
+#include "lib/audio/audioPeakFile.h"
 #include <QPainter>
 #include <QPainterPath>
 #include <QQuickPaintedItem>
@@ -97,8 +98,8 @@ public:
         //setMipmap(true);
         setTextureSize(QSize(1, 1));
         connect(this, &TimelineWaveform::levelsChanged, [&]() {
-            if (!m_binId.isEmpty() && m_audioLevels.isEmpty()) {
-                m_audioLevels = pCore->projectItemModel()->getAudioLevelsByBinID(m_binId);
+            if (!m_binId.isEmpty() && !m_peaks && m_audioLevels.isEmpty()) {
+                fetchLevels();
                 update();
             }
         });
@@ -128,13 +129,15 @@ public:
         if (!m_showItem || m_binId.isEmpty()) {
             return;
         }
-        if (m_audioLevels.isEmpty()) {
-            m_audioLevels = pCore->projectItemModel()->getAudioLevelsByBinID(m_binId);
-            if (m_audioLevels.isEmpty()) {
+        if (!m_peaks && m_audioLevels.isEmpty()) {
+            fetchLevels();
+            if (!m_peaks && m_audioLevels.isEmpty()) {
                 return;
             }
         }
         qreal indicesPrPixel = qreal(m_outPoint - m_inPoint) / width();
+        // Read the peaks at the resolution matching the number of frames covered by one pixel
+        int peakLevel = m_peaks ? m_peaks->levelForSpan(qAbs(indicesPrPixel) / m_channels) : 0;
         QPen pen = painter->pen();
         pen.setColor(m_color);
         pen.setWidthF(0);
@@ -145,20 +148,23 @@ public:
             path.moveTo(-1, height());
             double i = 0;
             double increment = qMax(1., 1 / qAbs(indicesPrPixel));
+            int span = int(increment * indicesPrPixel);
             double level;
+            double channelLevel;
             int lastIdx = -1;
             for (; i <= width(); i += increment) {
                 int idx = m_inPoint + int(i * indicesPrPixel);
-                if (idx + m_channels >= m_audioLevels.length() || idx < 0) {
+                if (!levelAt(peakLevel, idx, span, m_channels - 1, channelLevel)) {
                     break;
                 }
                 if (lastIdx == idx) {
                     continue;
                 }
                 lastIdx = idx;
-                level = m_audioLevels.at(idx) / 255.;
-                for (int j = 1; j < m_channels; j++) {
-                    level = qMax(level, m_audioLevels.at(idx + j) / 255.);
+                level = channelLevel;
+                for (int j = 0; j < m_channels - 1; j++) {
+                    levelAt(peakLevel, idx, span, j, channelLevel);
+                    level = qMax(level, channelLevel);
                 }
                 path.lineTo(i, height() - level * height());
             }
@@ -172,6 +178,7 @@ public:
             // Draw separate channels
             double i = 0;
             double increment = qMax(1., 1 / indicesPrPixel);
+            int span = int(increment * indicesPrPixel);
             double level;
             QRectF bgRect(0, 0, width(), 2 * channelHeight);
             QVector<QPainterPath> channelPaths(m_channels);
@@ -195,9 +202,10 @@ public:
                         continue;
                     }
                     lastIdx = idx;
-                    idx += channel;
-                    if (idx >= m_audioLevels.length() || idx < 0) break;
-                    level = m_audioLevels.at(idx) * channelHeight / 255.;
+                    if (!levelAt(peakLevel, idx, span, channel, level)) {
+                        break;
+                    }
+                    level *= channelHeight;
                     channelPaths[channel].lineTo(i, y - level);
                 }
                 if (m_firstChunk && m_channels > 1 && m_channels < 7) {
@@ -220,6 +228,38 @@ signals:
     void audioChannelsChanged();
 
 private:
+    void fetchLevels()
+    {
+        m_peaks = pCore->projectItemModel()->getAudioPeaksByBinID(m_binId);
+        if (!m_peaks) {
+            // Audio thumbnail not finished, use the levels computed so far
+            m_audioLevels = pCore->projectItemModel()->getAudioLevelsByBinID(m_binId);
+        }
+    }
+
+    /** @brief Reads the level (0 to 1) of @param channel for the frames covered by level indexes @param idx to @param idx + @param span.
+        Returns false if idx is outside of the clip */
+    bool levelAt(int peakLevel, int idx, int span, int channel, double &level) const
+    {
+        if (m_peaks) {
+            int frame = idx / m_channels;
+            if (idx < 0 || frame >= m_peaks->frameCount()) {
+                return false;
+            }
+            int frames = span / m_channels;
+            int lastFrame = frames > 0 ? frame + frames - 1 : (frames < 0 ? frame + frames + 1 : frame);
+            level = m_peaks->peak(peakLevel, channel, frame, lastFrame) / 255.;
+            return true;
+        }
+        idx += channel;
+        if (idx >= m_audioLevels.length() || idx < 0) {
+            return false;
+        }
+        level = m_audioLevels.at(idx) / 255.;
+        return true;
+    }
+
+    std::shared_ptr<AudioPeakFile> m_peaks;
     QVector<uint8_t> m_audioLevels;
     int m_inPoint;
     int m_outPoint;
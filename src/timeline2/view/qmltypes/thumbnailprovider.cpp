@@ -44,16 +44,18 @@ QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSi
     bool ok;
     int frameNumber = id.section('#', -1).toInt(&ok);
     if (ok) {
-        if (ThumbnailCache::get()->hasThumbnail(binId, frameNumber, false)) {
-            result = ThumbnailCache::get()->getThumbnail(binId, frameNumber);
+        result = ThumbnailCache::get()->getThumbnail(binId, frameNumber);
+        if (!result.isNull()) {
             *size = result.size();
             return result;
         }
         std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
         if (binClip) {
-            std::shared_ptr<Mlt::Producer> prod = binClip->thumbProducer();
+            std::shared_ptr<Mlt::Producer> prod = binClip->thumbProducer(frameNumber);
             if (prod && prod->is_valid()) {
-                result = makeThumbnail(prod, frameNumber, requestedSize);
+                // Thumbnails are requested from left to right, close frames are decoded forward from the previous request
+                int maxGap = KThumb::sequentialDecodeGap(binClip->codec(false), pCore->getCurrentFps());
+                result = makeThumbnail(prod, frameNumber, maxGap, requestedSize);
                 ThumbnailCache::get()->storeThumbnail(binId, frameNumber, result, false);
             }
         }
@@ -80,17 +82,17 @@ QString ThumbnailProvider::cacheKey(Mlt::Properties &properties, const QString &
     return key;
 }
 
-QImage ThumbnailProvider::makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize)
+QImage ThumbnailProvider::makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, int maxGap, const QSize &requestedSize)
 {
     Q_UNUSED(requestedSize)
-    producer->seek(frameNumber);
-    QScopedPointer<Mlt::Frame> frame(producer->get_frame());
-    if (frame == nullptr || !frame->is_valid()) {
-        return QImage();
-    }
     // TODO: cache these values ?
     int imageHeight = pCore->thumbProfile()->height();
     int imageWidth = pCore->thumbProfile()->width();
     int fullWidth = imageHeight * pCore->getCurrentDar() + 0.5;
-    return KThumb::getFrame(frame.data(), imageWidth, imageHeight, fullWidth);
+    QImage result;
+    KThumb::extractFrames(*producer.get(), {frameNumber}, maxGap, [&](int, Mlt::Frame *frame) {
+        result = KThumb::getFrame(frame, imageWidth, imageHeight, fullWidth);
+        return true;
+    });
+    return result;
 }
@@ -34,7 +34,7 @@ public:
     QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
 
 private:
-    QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize);
+    QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, int maxGap, const QSize &requestedSize);
     QString cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber);
 };
 
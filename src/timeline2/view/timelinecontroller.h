@@ -475,7 +475,7 @@ public:
     bool useRuler() const;
     /* @brief Load timeline preview from saved doc
      */
-    void loadPreview(const QString &chunks, const QString &dirty, const QDateTime &documentDate, int enable);
+    void loadPreview(const QString &chunks, const QString &dirty, int enable);
     /* @brief Return document properties with added settings from timeline
      */
     QMap<QString, QString> documentProperties();
@@ -153,6 +153,11 @@ QString TransitionsRepository::assetPreferredListPath() const
     return QStringLiteral("");
 }
 
+QString TransitionsRepository::assetCacheName() const
+{
+    return QStringLiteral("transitions");
+}
+
 std::unique_ptr<Mlt::Transition> TransitionsRepository::getTransition(const QString &transitionId) const
 {
     Q_ASSERT(exists(transitionId));
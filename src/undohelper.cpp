@@ -23,11 +23,19 @@
 #include "logger.hpp"
 #include <QDebug>
 #include <utility>
+
+namespace {
+// Average memory captured by the composed undo/redo functors of an operation: models, producers, xml data
+const qint64 functorsFootprint = 4096;
+} // namespace
+
 FunctionalUndoCommand::FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, QUndoCommand *parent)
     : QUndoCommand(parent)
     , m_undo(std::move(undo))
     , m_redo(std::move(redo))
+    , m_sizeHint(0)
     , m_undone(false)
+    , m_discarded(false)
 {
     setText(text);
 }
@@ -50,3 +58,24 @@ void FunctionalUndoCommand::redo()
         Q_ASSERT(res);
     }
 }
+
+qint64 FunctionalUndoCommand::footprint() const
+{
+    qint64 size = (qint64)sizeof(FunctionalUndoCommand) + text().size() * (qint64)sizeof(QChar);
+    if (!m_discarded) {
+        size += m_sizeHint > 0 ? m_sizeHint : functorsFootprint;
+    }
+    return size;
+}
+
+void FunctionalUndoCommand::setSizeHint(qint64 bytes)
+{
+    m_sizeHint = bytes;
+}
+
+void FunctionalUndoCommand::discard()
+{
+    m_undo = []() { return true; };
+    m_redo = []() { return true; };
+    m_discarded = true;
+}
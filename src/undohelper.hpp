@@ -54,10 +54,19 @@ public:
     FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, QUndoCommand *parent = nullptr);
     void undo() override;
     void redo() override;
+    /* @brief Returns an estimation of the memory, in bytes, held by the command and the state captured by its functors */
+    qint64 footprint() const;
+    /* @brief Set the memory, in bytes, captured by the functors when the caller can measure it (xml data, parameters...).
+       Without a hint, an average operation is assumed */
+    void setSizeHint(qint64 bytes);
+    /* @brief Release the captured state. The command does nothing afterwards, so it must not be undone anymore */
+    void discard();
 
 private:
     Fun m_undo, m_redo;
+    qint64 m_sizeHint;
     bool m_undone;
+    bool m_discarded;
 };
 
 #endif
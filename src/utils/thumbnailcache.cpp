@@ -26,6 +26,7 @@
 #include "doc/kdenlivedoc.h"
 #include <QDir>
 #include <QMutexLocker>
+#include <QtConcurrent>
 #include <list>
 
 std::unique_ptr<ThumbnailCache> ThumbnailCache::instance;
@@ -34,8 +35,10 @@ std::once_flag ThumbnailCache::m_onceFlag;
 class ThumbnailCache::Cache_t
 {
 public:
-    Cache_t(int maxCost)
+    // maxItemCost is the largest image accepted, it can be above maxCost: the image is then alone in the cache
+    Cache_t(int maxCost, int maxItemCost)
         : m_maxCost(maxCost)
+        , m_maxItemCost(maxItemCost)
     {
     }
 
@@ -52,18 +55,23 @@ public:
         m_cache.erase(key);
     }
 
-    void insert(const QString &key, const QImage &img, int cost)
+    // Returns the number of images that were dropped to make room for this one
+    int insert(const QString &key, const QImage &img, int cost)
     {
-        if (cost > m_maxCost) {
-            return;
+        if (cost > m_maxItemCost) {
+            return 0;
         }
+        remove(key);
         m_data.push_front({key, {img, cost}});
         auto it = m_data.begin();
         m_cache[key] = it;
         m_currentCost += cost;
-        while (m_currentCost > m_maxCost) {
+        int evicted = 0;
+        while (m_currentCost > m_maxCost && m_data.size() > 1) {
             remove(m_data.back().first);
+            evicted++;
         }
+        return evicted;
     }
 
     QImage get(const QString &key)
@@ -89,15 +97,47 @@ public:
 
 protected:
     int m_maxCost;
+    int m_maxItemCost;
     int m_currentCost{0};
 
     std::list<std::pair<QString, std::pair<QImage, int>>> m_data; // the data is stored as (key,(image, cost))
     std::unordered_map<QString, decltype(m_data.begin())> m_cache;
 };
 
+struct ThumbnailCache::Shard
+{
+    Shard(int maxCost, int maxItemCost)
+        : cache(maxCost, maxItemCost)
+    {
+    }
+    QMutex mutex;
+    Cache_t cache;
+};
+
+namespace {
+QFuture<QImage> readyFuture(const QImage &img)
+{
+    QFutureInterface<QImage> result;
+    result.reportStarted();
+    result.reportFinished(&img);
+    return result.future();
+}
+} // namespace
+
 ThumbnailCache::ThumbnailCache()
-    : m_volatileCache(new Cache_t(10000000))
 {
+    // total size of the volatile cache
+    const int maxCost = 16000000;
+    // Any image fitting in the whole cache is accepted, a shard holding a large one temporarily exceeds its share
+    for (auto &s : m_shards) {
+        s.reset(new Shard(maxCost / shardCount, maxCost));
+    }
+    m_diskThread.setMaxThreadCount(1);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    m_diskThread.waitForDone();
 }
 
 std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
@@ -106,43 +146,167 @@ std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
     return instance;
 }
 
-bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOnly) const
+ThumbnailCache::Shard &ThumbnailCache::shard(const QString &key) const
+{
+    return *m_shards[qHash(key) % shardCount];
+}
+
+bool ThumbnailCache::getVolatile(const QString &key, QImage &img) const
 {
+    Shard &s = shard(key);
+    QMutexLocker locker(&s.mutex);
+    if (!s.cache.contains(key)) {
+        m_misses++;
+        return false;
+    }
+    m_hits++;
+    img = s.cache.get(key);
+    return true;
+}
+
+void ThumbnailCache::insertVolatile(const QString &key, const QImage &img) const
+{
+    Shard &s = shard(key);
+    QMutexLocker locker(&s.mutex);
+    m_evictions += quint64(s.cache.insert(key, img, (int)img.sizeInBytes()));
+}
+
+QFuture<QImage> ThumbnailCache::readFromDisk(const QString &binId, int pos, const QString &key) const
+{
+    bool ok = false;
+    QDir thumbFolder = getDir(pos < 0, &ok);
+    if (!ok) {
+        return readyFuture(QImage());
+    }
+    const QString path = thumbFolder.absoluteFilePath(key);
     QMutexLocker locker(&m_mutex);
+    auto pending = m_pendingWrites.find(key);
+    if (pending != m_pendingWrites.end()) {
+        return readyFuture(pending->second);
+    }
+    auto reading = m_pendingReads.find(key);
+    if (reading != m_pendingReads.end()) {
+        return reading->second;
+    }
+    const int generation = m_generation;
+    QFuture<QImage> future = QtConcurrent::run(&m_diskThread, [this, binId, pos, key, path, generation]() {
+        QImage img = loadImage(binId, pos, key, path, generation);
+        QMutexLocker readLocker(&m_mutex);
+        m_pendingReads.erase(key);
+        return img;
+    });
+    // The task cannot remove itself from the pending reads before we release the lock
+    m_pendingReads[key] = future;
+    return future;
+}
+
+QImage ThumbnailCache::readFromDiskNow(const QString &binId, int pos, const QString &key) const
+{
+    bool ok = false;
+    QDir thumbFolder = getDir(pos < 0, &ok);
+    if (!ok) {
+        return QImage();
+    }
+    {
+        // The file is complete once it is not pending anymore
+        QMutexLocker locker(&m_mutex);
+        auto pending = m_pendingWrites.find(key);
+        if (pending != m_pendingWrites.end()) {
+            return pending->second;
+        }
+    }
+    return loadImage(binId, pos, key, thumbFolder.absoluteFilePath(key), m_generation);
+}
+
+QImage ThumbnailCache::loadImage(const QString &binId, int pos, const QString &key, const QString &path, int generation) const
+{
+    if (generation != m_generation) {
+        return QImage();
+    }
+    QImage img;
+    if (QFile::exists(path)) {
+        img = QImage(path);
+    }
+    if (img.isNull()) {
+        return img;
+    }
+    m_diskReads++;
+    QMutexLocker locker(&m_mutex);
+    if (generation != m_generation) {
+        // Loaded for the previous project
+        return img;
+    }
+    if (pos >= 0) {
+        insertVolatile(key, img);
+        m_storedVolatile[binId].push_back(pos);
+    }
+    m_storedOnDisk[binId].push_back(pos);
+    return img;
+}
+
+void ThumbnailCache::writeToDisk(const QString &path, const QString &key, const QImage &img)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pendingWrites[key] = img;
+    const int generation = m_generation;
+    QtConcurrent::run(&m_diskThread, [this, path, key, img, generation]() {
+        if (generation != m_generation) {
+            // The cache was cleared, don't write the thumbnails of the previous project
+            return;
+        }
+        if (img.save(path)) {
+            m_diskWrites++;
+        } else {
+            qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: " << path;
+        }
+        QMutexLocker writeLocker(&m_mutex);
+        auto pending = m_pendingWrites.find(key);
+        if (pending != m_pendingWrites.end() && pending->second.cacheKey() == img.cacheKey()) {
+            m_pendingWrites.erase(pending);
+        }
+    });
+}
+
+bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOnly) const
+{
     bool ok = false;
     auto key = pos < 0 ? getAudioKey(binId, &ok) : getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return true;
+    if (!ok) {
+        return false;
+    }
+    {
+        Shard &s = shard(key);
+        QMutexLocker locker(&s.mutex);
+        if (s.cache.contains(key)) {
+            return true;
+        }
     }
-    if (!ok || volatileOnly) {
+    if (volatileOnly) {
         return false;
     }
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pendingWrites.count(key) > 0) {
+            return true;
+        }
+    }
     QDir thumbFolder = getDir(pos < 0, &ok);
     return ok && thumbFolder.exists(key);
 }
 
 QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
     auto key = getAudioKey(binId, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
-    }
-    if (!ok || volatileOnly) {
-        return QImage();
-    }
-    QDir thumbFolder = getDir(true, &ok);
-    if (ok && thumbFolder.exists(key)) {
-        m_storedOnDisk[binId].push_back(-1);
-        return QImage(thumbFolder.absoluteFilePath(key));
+    QImage img;
+    if (!ok || getVolatile(key, img) || volatileOnly) {
+        return img;
     }
-    return QImage();
+    return readFromDiskNow(binId, -1, key);
 }
 
 const QUrl ThumbnailCache::getAudioThumbPath(const QString &binId) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
     auto key = getAudioKey(binId, &ok);
     QDir thumbFolder = getDir(true, &ok);
@@ -154,26 +318,28 @@ const QUrl ThumbnailCache::getAudioThumbPath(const QString &binId) const
 
 QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
     auto key = getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
+    QImage img;
+    if (!ok || getVolatile(key, img) || volatileOnly) {
+        return img;
     }
-    if (!ok || volatileOnly) {
-        return QImage();
-    }
-    QDir thumbFolder = getDir(false, &ok);
-    if (ok && thumbFolder.exists(key)) {
-        m_storedOnDisk[binId].push_back(pos);
-        return QImage(thumbFolder.absoluteFilePath(key));
+    return readFromDiskNow(binId, pos, key);
+}
+
+QFuture<QImage> ThumbnailCache::requestThumbnail(const QString &binId, int pos) const
+{
+    bool ok = false;
+    auto key = getKey(binId, pos, &ok);
+    QImage img;
+    if (!ok || getVolatile(key, img)) {
+        return readyFuture(img);
     }
-    return QImage();
+    return readFromDisk(binId, pos, key);
 }
 
 void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent)
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
     const QString key = getKey(binId, pos, &ok);
     if (!ok) {
@@ -181,23 +347,17 @@ void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage
     }
     if (persistent) {
         QDir thumbFolder = getDir(false, &ok);
-        if (ok) {
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: "<<thumbFolder.absoluteFilePath(key);
-            }
-            m_storedOnDisk[binId].push_back(pos);
-            // if volatile cache also contains this entry, update it
-            if (m_volatileCache->contains(key)) {
-                m_volatileCache->remove(key);
-            } else {
-                m_storedVolatile[binId].push_back(pos);
-            }
-            m_volatileCache->insert(key, img, (int)img.sizeInBytes());
+        if (!ok) {
+            return;
         }
-    } else {
-        m_volatileCache->insert(key, img, (int)img.sizeInBytes());
-        m_storedVolatile[binId].push_back(pos);
+        writeToDisk(thumbFolder.absoluteFilePath(key), key, img);
+    }
+    insertVolatile(key, img);
+    QMutexLocker locker(&m_mutex);
+    if (persistent) {
+        m_storedOnDisk[binId].push_back(pos);
     }
+    m_storedVolatile[binId].push_back(pos);
 }
 
 void ThumbnailCache::saveCachedThumbs(QStringList keys)
@@ -207,63 +367,117 @@ void ThumbnailCache::saveCachedThumbs(QStringList keys)
     if (!ok) {
         return;
     }
+    std::vector<std::pair<QString, QImage>> images;
     for (const QString &key : keys) {
-        if (!thumbFolder.exists(key) && m_volatileCache->contains(key)) {
-            QImage img = m_volatileCache->get(key);
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
+        Shard &s = shard(key);
+        QMutexLocker locker(&s.mutex);
+        if (s.cache.contains(key)) {
+            images.emplace_back(key, s.cache.get(key));
+        }
+    }
+    if (images.empty()) {
+        return;
+    }
+    const int generation = m_generation;
+    QtConcurrent::run(&m_diskThread, [this, thumbFolder, images, generation]() {
+        for (const auto &image : images) {
+            if (generation != m_generation) {
                 break;
             }
+            if (!thumbFolder.exists(image.first)) {
+                if (!image.second.save(thumbFolder.absoluteFilePath(image.first))) {
+                    qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
+                    break;
+                }
+                m_diskWrites++;
+            }
         }
-    }
+    });
 }
 
 void ThumbnailCache::invalidateThumbsForClip(const QString &binId, bool reloadAudio)
 {
-    QMutexLocker locker(&m_mutex);
-    if (m_storedVolatile.find(binId) != m_storedVolatile.end()) {
-        bool ok = false;
-        for (int pos : m_storedVolatile.at(binId)) {
-            auto key = getKey(binId, pos, &ok);
-            if (ok) {
-                m_volatileCache->remove(key);
+    std::vector<QString> volatileKeys;
+    QStringList files;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_storedVolatile.find(binId) != m_storedVolatile.end()) {
+            bool ok = false;
+            for (int pos : m_storedVolatile.at(binId)) {
+                auto key = getKey(binId, pos, &ok);
+                if (ok) {
+                    volatileKeys.push_back(key);
+                }
             }
+            m_storedVolatile.erase(binId);
         }
-        m_storedVolatile.erase(binId);
-    }
-    bool ok = false;
-    // Video thumbs
-    QDir thumbFolder = getDir(false, &ok);
-    QDir audioThumbFolder = getDir(true, &ok);
-    if (ok && m_storedOnDisk.find(binId) != m_storedOnDisk.end()) {
-        // Remove persistent cache
-        for (int pos : m_storedOnDisk.at(binId)) {
-            if (pos < 0) {
-                if (reloadAudio) {
-                    auto key = getAudioKey(binId, &ok);
+        bool ok = false;
+        // Video thumbs
+        QDir thumbFolder = getDir(false, &ok);
+        QDir audioThumbFolder = getDir(true, &ok);
+        if (ok && m_storedOnDisk.find(binId) != m_storedOnDisk.end()) {
+            // Remove persistent cache
+            for (int pos : m_storedOnDisk.at(binId)) {
+                if (pos < 0) {
+                    if (reloadAudio) {
+                        auto key = getAudioKey(binId, &ok);
+                        if (ok) {
+                            files << audioThumbFolder.absoluteFilePath(key);
+                        }
+                    }
+                } else {
+                    auto key = getKey(binId, pos, &ok);
                     if (ok) {
-                        QFile::remove(audioThumbFolder.absoluteFilePath(key));
+                        m_pendingWrites.erase(key);
+                        files << thumbFolder.absoluteFilePath(key);
                     }
                 }
-            } else {
-                auto key = getKey(binId, pos, &ok);
-                if (ok) {
-                    QFile::remove(thumbFolder.absoluteFilePath(key));
-                }
             }
+            m_storedOnDisk.erase(binId);
         }
-        m_storedOnDisk.erase(binId);
+    }
+    for (const QString &key : volatileKeys) {
+        Shard &s = shard(key);
+        QMutexLocker locker(&s.mutex);
+        s.cache.remove(key);
+    }
+    if (!files.isEmpty()) {
+        // Queued after the pending writes of this clip
+        files.removeDuplicates();
+        QtConcurrent::run(&m_diskThread, [files]() {
+            for (const QString &file : files) {
+                QFile::remove(file);
+            }
+        });
     }
 }
 
 void ThumbnailCache::clearCache()
 {
+    // Don't wait for the disk accesses of the previous project, the queued ones are skipped
     QMutexLocker locker(&m_mutex);
-    m_volatileCache->clear();
+    m_generation++;
+    for (auto &s : m_shards) {
+        QMutexLocker shardLocker(&s->mutex);
+        s->cache.clear();
+    }
+    m_pendingWrites.clear();
+    m_pendingReads.clear();
     m_storedVolatile.clear();
     m_storedOnDisk.clear();
 }
 
+ThumbnailCache::Statistics ThumbnailCache::statistics() const
+{
+    Statistics stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.diskReads = m_diskReads;
+    stats.diskWrites = m_diskWrites;
+    return stats;
+}
+
 // static
 QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
 {
@@ -23,9 +23,13 @@
 
 #include "definitions.h"
 #include <QDir>
+#include <QFuture>
 #include <QUrl>
 #include <QImage>
 #include <QMutex>
+#include <QThreadPool>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -37,6 +41,9 @@
     Note that for the volatile cache uses a custom implementation.
     QCache is not suitable since it operates on pointers and since the object is removed from the cache when accessed.
     KImageCache is not suitable since it lacks a way to remove objects from the cache.
+    The volatile cache is split in shards by key hash, each with its own lock, so that thumbnail requests from several tracks don't wait for each other.
+    Writes and deletions of the persistent cache are done in a dedicated I/O thread, no lock is held while a thumbnail is loaded or saved.
+    Synchronous reads are done in the calling thread so that they don't wait behind the queued writes.
  * Note that this class is a Singleton
  */
 
@@ -44,6 +51,18 @@ class ThumbnailCache
 {
 
 public:
+    /* @brief Usage counters of the cache */
+    struct Statistics
+    {
+        quint64 hits = 0;       // found in the volatile cache
+        quint64 misses = 0;     // not found in the volatile cache
+        quint64 evictions = 0;  // dropped from the volatile cache to respect its size
+        quint64 diskReads = 0;  // loaded from the persistent cache
+        quint64 diskWrites = 0; // saved to the persistent cache
+    };
+
+    ~ThumbnailCache();
+
     // Returns the instance of the Singleton
     static std::unique_ptr<ThumbnailCache> &get();
 
@@ -60,6 +79,11 @@ public:
        @param volatileOnly if true, we only check the volatile cache (no disk access)
     */
     QImage getThumbnail(const QString &binId, int pos, bool volatileOnly = false) const;
+    /* @brief Get a given thumbnail from the cache without blocking on disk access.
+       If the thumbnail is only in the persistent cache, it is loaded in the I/O thread and added to the volatile cache.
+       Returns a null image if the thumbnail is not cached.
+    */
+    QFuture<QImage> requestThumbnail(const QString &binId, int pos) const;
     QImage getAudioThumbnail(const QString &binId, bool volatileOnly = false) const;
     const QUrl getAudioThumbPath(const QString &binId) const;
 
@@ -79,6 +103,9 @@ public:
     /* @brief Reset cache (discarding all thumbs stored in memory) */
     void clearCache();
 
+    /* @brief Returns the usage counters since the cache creation */
+    Statistics statistics() const;
+
 protected:
     // Constructor is protected because class is a Singleton
     ThumbnailCache();
@@ -94,11 +121,42 @@ protected:
     static std::once_flag m_onceFlag; // flag to create the repository only once;
 
     class Cache_t;
-    std::unique_ptr<Cache_t> m_volatileCache;
+    struct Shard;
+    static const int shardCount = 16;
+    std::array<std::unique_ptr<Shard>, shardCount> m_shards;
+    Shard &shard(const QString &key) const;
+    /* @brief Look up the volatile cache, updating the counters */
+    bool getVolatile(const QString &key, QImage &img) const;
+    void insertVolatile(const QString &key, const QImage &img) const;
+    /* @brief Load an image of the persistent cache in the I/O thread, negative positions are audio thumbnails.
+        Concurrent requests for the same image share the load */
+    QFuture<QImage> readFromDisk(const QString &binId, int pos, const QString &key) const;
+    /* @brief Load an image of the persistent cache in the calling thread */
+    QImage readFromDiskNow(const QString &binId, int pos, const QString &key) const;
+    /* @brief Load the image file and record it in the caches, unless the cache was cleared since generation */
+    QImage loadImage(const QString &binId, int pos, const QString &key, const QString &path, int generation) const;
+    /* @brief Save an image in the I/O thread. Until it is written, the image is served from memory */
+    void writeToDisk(const QString &path, const QString &key, const QImage &img);
+
+    // Protects the pending disk accesses and the maps of stored positions
     mutable QMutex m_mutex;
+    // images waiting to be saved in the persistent cache, by key
+    std::unordered_map<QString, QImage> m_pendingWrites;
+    mutable std::unordered_map<QString, QFuture<QImage>> m_pendingReads;
 
     // the following maps keeps track of the positions that we store for each clip in volatile caches.
     // Note that we don't track deletions due to items dropped from the cache. So the maps can contain more items that are currently stored.
-    std::unordered_map<QString, std::vector<int>> m_storedVolatile;
+    mutable std::unordered_map<QString, std::vector<int>> m_storedVolatile;
     mutable std::unordered_map<QString, std::vector<int>> m_storedOnDisk;
+
+    // single thread used for the asynchronous disk accesses, so that writes and deletions keep their order
+    mutable QThreadPool m_diskThread;
+    // incremented when the cache is cleared, the queued disk accesses of the previous project are then skipped
+    std::atomic<int> m_generation{0};
+
+    mutable std::atomic<quint64> m_hits{0};
+    mutable std::atomic<quint64> m_misses{0};
+    mutable std::atomic<quint64> m_evictions{0};
+    mutable std::atomic<quint64> m_diskReads{0};
+    std::atomic<quint64> m_diskWrites{0};
 };
@@ -0,0 +1,189 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "thumbnailproducerpool.hpp"
+#include <QMutexLocker>
+#include <QThread>
+#include <mlt++/MltProducer.h>
+
+std::unique_ptr<ThumbnailProducerPool> ThumbnailProducerPool::instance;
+std::once_flag ThumbnailProducerPool::m_onceFlag;
+
+ThumbnailProducerPool::ThumbnailProducerPool()
+    : m_generation(0)
+    , m_maxPerClip(qBound(2, QThread::idealThreadCount() / 2, 8))
+    , m_maxIdle(qMax(4, QThread::idealThreadCount()))
+{
+}
+
+ThumbnailProducerPool::~ThumbnailProducerPool()
+{
+    clear();
+}
+
+std::unique_ptr<ThumbnailProducerPool> &ThumbnailProducerPool::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new ThumbnailProducerPool()); });
+    return instance;
+}
+
+std::shared_ptr<Mlt::Producer> ThumbnailProducerPool::checkout(const QString &binId, int position, const std::function<Mlt::Producer *()> &create)
+{
+    QMutexLocker lock(&m_mutex);
+    while (true) {
+        ClipEntry &entry = m_clips[binId];
+        if (entry.idle > 0) {
+            // Prefer the producer that decoded the closest frame before position, it can decode forward
+            auto best = m_idle.end();
+            int bestDecoded = -1;
+            for (auto it = m_idle.begin(); it != m_idle.end(); ++it) {
+                if (it->binId != binId) {
+                    continue;
+                }
+                int decoded = it->producer->get("_kdenlive_decoded") ? it->producer->get_int("_kdenlive_decoded") : -1;
+                if (best == m_idle.end() || (decoded <= position && decoded > bestDecoded)) {
+                    best = it;
+                    bestDecoded = decoded <= position ? decoded : -1;
+                }
+            }
+            Mlt::Producer *producer = best->producer.release();
+            m_idle.erase(best);
+            entry.idle--;
+            entry.inUse++;
+            int generation = entry.generation;
+            return std::shared_ptr<Mlt::Producer>(producer, [binId, generation](Mlt::Producer *p) { get()->release(binId, generation, p); });
+        }
+        if (entry.inUse < m_maxPerClip) {
+            entry.inUse++;
+            int generation = entry.generation;
+            lock.unlock();
+            Mlt::Producer *producer = create();
+            if (producer == nullptr || !producer->is_valid()) {
+                delete producer;
+                release(binId, generation, nullptr);
+                return nullptr;
+            }
+            return std::shared_ptr<Mlt::Producer>(producer, [binId, generation](Mlt::Producer *p) { get()->release(binId, generation, p); });
+        }
+        m_returned.wait(&m_mutex);
+    }
+}
+
+void ThumbnailProducerPool::release(const QString &binId, int generation, Mlt::Producer *producer)
+{
+    std::unique_ptr<Mlt::Producer> deleted;
+    std::list<Idle> evicted;
+    {
+        QMutexLocker lock(&m_mutex);
+        auto it = m_clips.find(binId);
+        if (it == m_clips.end()) {
+            deleted.reset(producer);
+        } else {
+            ClipEntry &entry = it->second;
+            entry.inUse--;
+            if (producer == nullptr || generation != entry.generation) {
+                deleted.reset(producer);
+            } else {
+                m_idle.push_front({binId, std::unique_ptr<Mlt::Producer>(producer)});
+                entry.idle++;
+                evicted = evict();
+            }
+            if (entry.inUse == 0 && entry.idle == 0) {
+                m_clips.erase(it);
+            }
+        }
+        m_returned.wakeAll();
+    }
+    // Producers are deleted once the lock is released, closing a decoder may take some time
+}
+
+std::list<ThumbnailProducerPool::Idle> ThumbnailProducerPool::evict()
+{
+    std::list<Idle> evicted;
+    while ((int)m_idle.size() > m_maxIdle) {
+        auto it = m_clips.find(m_idle.back().binId);
+        if (it != m_clips.end()) {
+            it->second.idle--;
+            if (it->second.inUse == 0 && it->second.idle == 0) {
+                m_clips.erase(it);
+            }
+        }
+        evicted.splice(evicted.begin(), m_idle, std::prev(m_idle.end()));
+    }
+    return evicted;
+}
+
+void ThumbnailProducerPool::invalidateClip(const QString &binId)
+{
+    std::list<Idle> dropped;
+    {
+        QMutexLocker lock(&m_mutex);
+        auto it = m_clips.find(binId);
+        if (it == m_clips.end()) {
+            return;
+        }
+        for (auto idle = m_idle.begin(); idle != m_idle.end();) {
+            auto current = idle++;
+            if (current->binId == binId) {
+                dropped.splice(dropped.end(), m_idle, current);
+            }
+        }
+        if (it->second.inUse == 0) {
+            m_clips.erase(it);
+        } else {
+            it->second.idle = 0;
+            it->second.generation = ++m_generation;
+        }
+    }
+}
+
+void ThumbnailProducerPool::clear()
+{
+    std::list<Idle> dropped;
+    {
+        QMutexLocker lock(&m_mutex);
+        dropped.swap(m_idle);
+        for (auto it = m_clips.begin(); it != m_clips.end();) {
+            it->second.idle = 0;
+            if (it->second.inUse == 0) {
+                it = m_clips.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+int ThumbnailProducerPool::maxPerClip() const
+{
+    return m_maxPerClip;
+}
+
+int ThumbnailProducerPool::maxIdle() const
+{
+    return m_maxIdle;
+}
+
+int ThumbnailProducerPool::idleCount() const
+{
+    QMutexLocker lock(&m_mutex);
+    return (int)m_idle.size();
+}
@@ -0,0 +1,102 @@
+/*
+Copyright (C) 2020  Kdenlive contributors
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Mlt {
+class Producer;
+}
+
+/** @brief This class keeps the producers used to extract thumbnails of the bin clips.
+    A producer is checked out by a thumbnail request and returned to the pool when its last reference is released, so that
+    concurrent requests never seek the same producer. Each clip has at most maxPerClip() producers, further requests wait
+    for one to be returned. Idle producers of all clips are kept in a LRU list limited to maxIdle() items.
+ * Note that this class is a Singleton
+ */
+class ThumbnailProducerPool
+{
+
+public:
+    ~ThumbnailProducerPool();
+
+    // Returns the instance of the Singleton
+    static std::unique_ptr<ThumbnailProducerPool> &get();
+
+    /* @brief Get a producer for the thumbnails of a clip, released to the pool when the returned pointer is destroyed.
+       @param binId is the id of the clip
+       @param position is the first frame that will be extracted, an idle producer that decoded a frame just before it is preferred
+       @param create builds a new producer when no idle one is available, it is called without holding the pool lock
+     */
+    std::shared_ptr<Mlt::Producer> checkout(const QString &binId, int position, const std::function<Mlt::Producer *()> &create);
+
+    /* @brief Drop the producers of a clip, the ones in use are deleted when they are returned */
+    void invalidateClip(const QString &binId);
+
+    /* @brief Drop all idle producers */
+    void clear();
+
+    int maxPerClip() const;
+    int maxIdle() const;
+    /* @brief Returns the number of idle producers */
+    int idleCount() const;
+
+protected:
+    // Constructor is protected because class is a Singleton
+    ThumbnailProducerPool();
+
+    static std::unique_ptr<ThumbnailProducerPool> instance;
+    static std::once_flag m_onceFlag; // flag to create the pool only once;
+
+    struct Idle
+    {
+        QString binId;
+        std::unique_ptr<Mlt::Producer> producer;
+    };
+    struct ClipEntry
+    {
+        int inUse = 0;
+        int idle = 0;
+        int generation = 0;
+    };
+
+    void release(const QString &binId, int generation, Mlt::Producer *producer);
+    /* @brief Remove the idle producers over the limit, returns them to be deleted without holding the lock */
+    std::list<Idle> evict();
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_returned;
+    // most recently returned first
+    std::list<Idle> m_idle;
+    std::unordered_map<QString, ClipEntry> m_clips;
+    // incremented on each invalidation, producers of an older generation are not reused
+    int m_generation;
+    int m_maxPerClip;
+    int m_maxIdle;
+};
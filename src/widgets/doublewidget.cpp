@@ -41,6 +41,8 @@ DoubleWidget::DoubleWidget(const QString &name, double value, double min, double
     }
     m_dragVal->setValue(value * factor, false);
     connect(m_dragVal, &DragValue::valueChanged, this, &DoubleWidget::slotSetValue);
+    connect(m_dragVal, &DragValue::dragStarted, this, &DoubleWidget::dragStarted);
+    connect(m_dragVal, &DragValue::dragFinished, this, &DoubleWidget::dragFinished);
 }
 
 bool DoubleWidget::hasEditFocus() const
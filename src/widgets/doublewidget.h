@@ -82,6 +82,9 @@ signals:
 
     // same signal as valueChanged, but add an extra boolean to tell if user is dragging value or not
     void valueChanging(double, bool);
+    /** @brief Emitted when the user starts and stops dragging the value */
+    void dragStarted();
+    void dragFinished();
 };
 
 #endif
@@ -109,6 +109,8 @@ DragValue::DragValue(const QString &label, double defaultValue, int decimals, do
     }
     connect(m_label, SIGNAL(valueChanged(double, bool)), this, SLOT(setValueFromProgress(double, bool)));
     connect(m_label, &CustomLabel::resetValue, this, &DragValue::slotReset);
+    connect(m_label, &CustomLabel::dragStarted, this, &DragValue::dragStarted);
+    connect(m_label, &CustomLabel::dragFinished, this, &DragValue::dragFinished);
     setLayout(l);
     if (m_intEdit) {
         m_label->setMaximumHeight(m_intEdit->sizeHint().height());
@@ -444,6 +446,7 @@ void CustomLabel::mouseMoveEvent(QMouseEvent *e)
     if (m_dragStartPosition != QPoint(-1, -1)) {
         if (!m_dragMode && (e->pos() - m_dragStartPosition).manhattanLength() >= QApplication::startDragDistance()) {
             m_dragMode = true;
+            emit dragStarted();
             m_dragLastPosition = e->pos();
             e->accept();
             return;
@@ -512,7 +515,10 @@ void CustomLabel::mouseReleaseEvent(QMouseEvent *e)
         m_dragLastPosition = m_dragStartPosition;
         e->accept();
     }
-    m_dragMode = false;
+    if (m_dragMode) {
+        m_dragMode = false;
+        emit dragFinished();
+    }
 }
 
 void CustomLabel::wheelEvent(QWheelEvent *e)
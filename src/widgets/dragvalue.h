@@ -61,6 +61,9 @@ signals:
     void valueChanged(double, bool);
     void setInTimeline();
     void resetValue();
+    /** @brief Emitted when the user starts and stops dragging the value */
+    void dragStarted();
+    void dragFinished();
 };
 
 /**
@@ -124,6 +127,9 @@ public slots:
 signals:
     void valueChanged(double value, bool final = true);
     void inTimeline(int);
+    /** @brief Emitted when the user starts and stops dragging the value */
+    void dragStarted();
+    void dragFinished();
 
     /*
      * Private
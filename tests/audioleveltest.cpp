@@ -0,0 +1,154 @@
+#include "test_utils.hpp"
+#include "audiomixer/audiolevelanalyzer.hpp"
+#include "lib/audio/audioLevelReducer.h"
+#include "monitor/scopes/dataqueue.h"
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace {
+// Interleaved s16le samples of a signal whose level changes at every frame
+QByteArray makeSamples(int channels, int samples)
+{
+    QByteArray pcm(samples * channels * 2, Qt::Uninitialized);
+    auto *data = reinterpret_cast<qint16 *>(pcm.data());
+    for (int i = 0; i < samples * channels; ++i) {
+        data[i] = qint16((i * 7919) % 65536 - 32768);
+    }
+    return pcm;
+}
+} // namespace
+
+TEST_CASE("Streaming audio level reduction", "[AudioLevelReducer]")
+{
+    const int channels = 2;
+    const int frequency = 48000;
+    // 10 seconds and a half frame at 25fps
+    const int frames = 250;
+    const QByteArray pcm = makeSamples(channels, frames * (frequency / 25) + frequency / 50);
+
+    AudioLevelReducer onePass(channels, frequency, 25.);
+    onePass.addData(pcm);
+    onePass.finish();
+    // The incomplete last frame gets a level
+    REQUIRE(onePass.frameCount() == frames + 1);
+    const QVector<uint8_t> reference = onePass.levels();
+    REQUIRE(reference.size() == (frames + 1) * channels);
+
+    SECTION("Fixed chunks")
+    {
+        AudioLevelReducer reducer(channels, frequency, 25.);
+        const int chunkSize = 65536;
+        for (int pos = 0; pos < pcm.size(); pos += chunkSize) {
+            reducer.addData(pcm.mid(pos, chunkSize));
+        }
+        reducer.finish();
+        REQUIRE(reducer.levels() == reference);
+    }
+
+    SECTION("Chunks splitting the samples")
+    {
+        AudioLevelReducer reducer(channels, frequency, 25.);
+        int pos = 0;
+        int step = 1;
+        while (pos < pcm.size()) {
+            reducer.addData(pcm.mid(pos, step));
+            pos += step;
+            step = step % 4099 + 3;
+        }
+        reducer.finish();
+        REQUIRE(reducer.levels() == reference);
+    }
+
+    SECTION("Frame rate that is not a divisor of the sampling rate")
+    {
+        AudioLevelReducer single(channels, frequency, 30000. / 1001.);
+        single.addData(pcm);
+        single.finish();
+        AudioLevelReducer chunked(channels, frequency, 30000. / 1001.);
+        for (int pos = 0; pos < pcm.size(); pos += 1001) {
+            chunked.addData(pcm.mid(pos, 1001));
+        }
+        chunked.finish();
+        REQUIRE(chunked.frameCount() == single.frameCount());
+        REQUIRE(chunked.levels() == single.levels());
+    }
+}
+
+TEST_CASE("Mixer level analysis", "[AudioLevelAnalyzer]")
+{
+    AudioLevelAnalyzer analyzer(25.);
+    const QVector<double> silence(2, 0.);
+    const QVector<double> loud(2, 1.);
+
+    SECTION("Peak hold and decay")
+    {
+        // A loud frame is held for one second, then falls
+        REQUIRE(analyzer.process(0, loud).peaks == loud);
+        for (int pos = 1; pos <= 25; ++pos) {
+            AudioLevelRecord record = analyzer.process(pos, silence);
+            REQUIRE(record.position == pos);
+            REQUIRE(record.levels == silence);
+            REQUIRE(record.peaks == loud);
+        }
+        AudioLevelRecord falling = analyzer.process(26, silence);
+        REQUIRE(falling.peaks[0] < 1.);
+        REQUIRE(falling.peaks[0] > 0.);
+        REQUIRE(falling.rms[0] == 0.);
+        // One full scale frame out of the 27 in the window so far
+        REQUIRE(falling.loudness == Approx(10 * std::log10(1. / 27)).epsilon(0.001));
+        REQUIRE(analyzer.process(27, silence).peaks[0] < falling.peaks[0]);
+    }
+
+    SECTION("Seek and pause")
+    {
+        analyzer.process(0, loud);
+        analyzer.process(1, silence);
+        // Seeking restarts the history
+        AudioLevelRecord seeked = analyzer.process(100, silence);
+        REQUIRE(seeked.peaks == silence);
+        REQUIRE(seeked.loudness == -100.);
+        // A paused frame keeps its values
+        AudioLevelRecord paused = analyzer.process(100, loud);
+        REQUIRE(paused.levels == silence);
+        REQUIRE(paused.peaks == silence);
+        // Unless the analyzer was reset
+        analyzer.reset();
+        REQUIRE(analyzer.process(100, loud).peaks == loud);
+    }
+
+    SECTION("Records handed to the GUI thread")
+    {
+        // Same setup as MixerWidget: the MLT thread analyses the levels of each frame and queues them,
+        // the GUI thread drains the queue when a frame is displayed
+        const int channels = 6;
+        const int frames = 250;
+        DataQueue<AudioLevelRecord> queue(8, DataQueue<AudioLevelRecord>::OverflowModeWait);
+        std::atomic<bool> running(true);
+        int received = 0;
+        bool ordered = true;
+        std::thread gui([&]() {
+            int last = -1;
+            AudioLevelRecord record;
+            while (running || queue.count() > 0) {
+                while (queue.tryPop(record)) {
+                    ordered = ordered && record.position == last + 1 && record.levels.size() == channels;
+                    last = record.position;
+                    received++;
+                }
+                std::this_thread::yield();
+            }
+        });
+        QVector<double> amplitudes(channels);
+        for (int pos = 0; pos < frames; ++pos) {
+            for (int i = 0; i < channels; ++i) {
+                amplitudes[i] = 0.5 * (1 + std::sin(pos * 0.1 + i));
+            }
+            queue.push(analyzer.process(pos, amplitudes));
+        }
+        running = false;
+        gui.join();
+        REQUIRE(received == frames);
+        REQUIRE(ordered);
+    }
+}
@@ -0,0 +1,783 @@
+#include "test_utils.hpp"
+#include "abstractmodel/abstracttreemodel.hpp"
+#include "abstractmodel/treeitem.hpp"
+#include "audiomixer/audiolevelanalyzer.hpp"
+#include "bin/projectsortproxymodel.h"
+#include "doc/kthumb.h"
+#include "jobs/jobscheduler.h"
+#include "jobs/scenedetector.hpp"
+#include "lib/audio/audioLevelReducer.h"
+#include "lib/audio/audioPeakFile.h"
+#include "monitor/scopes/dataqueue.h"
+#include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <mlt++/MltPlaylist.h>
+#include <atomic>
+#include <thread>
+
+using namespace fakeit;
+Mlt::Profile profile_benchmark;
+
+// Benchmarks are hidden by default, run them with: runTests "[Benchmark]"
+
+TEST_CASE("Bin id lookups on a large bin", "[.][Benchmark]")
+{
+    Logger::clear();
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    const int clipCount = 10000;
+    std::vector<QString> binIds;
+    binIds.reserve(clipCount);
+    for (int i = 0; i < clipCount; ++i) {
+        binIds.push_back(createProducer(profile_benchmark, "red", binModel));
+    }
+
+    // The results of the lookups are checked in the regular bin tests
+    BENCHMARK("getClipByBinID")
+    {
+        for (const QString &binId : binIds) {
+            binModel->getClipByBinID(binId);
+        }
+    }
+    BENCHMARK("getItemByBinId / hasClip")
+    {
+        for (const QString &binId : binIds) {
+            binModel->getItemByBinId(binId);
+            binModel->hasClip(binId);
+        }
+    }
+    BENCHMARK("getAudioLevelsByBinID")
+    {
+        for (const QString &binId : binIds) {
+            binModel->getAudioLevelsByBinID(binId);
+        }
+    }
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Bin search on a large bin", "[.][Benchmark]")
+{
+    Logger::clear();
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    // 100 folders of 100 sub folders
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    for (int i = 0; i < 100; ++i) {
+        QString sceneId;
+        REQUIRE(binModel->requestAddFolder(sceneId, QStringLiteral("Scene %1").arg(i), binModel->getRootFolder()->clipId(), undo, redo));
+        for (int j = 0; j < 100; ++j) {
+            QString shotId;
+            REQUIRE(binModel->requestAddFolder(shotId, QStringLiteral("Shot %1_%2").arg(i).arg(j), sceneId, undo, redo));
+        }
+    }
+    ProjectSortProxyModel proxy;
+    proxy.setSourceModel(binModel.get());
+    // Visible items, expanding every folder like a tree view would
+    std::function<int(const QModelIndex &)> visibleItems = [&](const QModelIndex &parent) {
+        int count = proxy.rowCount(parent);
+        int total = count;
+        for (int i = 0; i < count; ++i) {
+            total += visibleItems(proxy.index(i, 0, parent));
+        }
+        return total;
+    };
+    const QString search = QStringLiteral("shot 42_7");
+
+    BENCHMARK("Typing a search string")
+    {
+        for (int i = 1; i <= search.size(); ++i) {
+            proxy.slotSetSearchString(search.left(i));
+            visibleItems(QModelIndex());
+        }
+        proxy.slotSetSearchString(QString());
+    }
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Range queries on a large track", "[.][Benchmark]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+    std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_benchmark, guideModel, undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId = createProducer(profile_benchmark, "red", binModel);
+    int tid = TrackModel::construct(timeline);
+
+    const int clipCount = 20000;
+    const int length = 20;
+    std::vector<int> clipIds;
+    clipIds.reserve(clipCount);
+    for (int i = 0; i < clipCount; ++i) {
+        int cid = -1;
+        REQUIRE(timeline->requestClipInsertion(binId, tid, i * length, cid, false));
+        clipIds.push_back(cid);
+    }
+
+    // The results of the queries are checked in the regular model tests
+    BENCHMARK("getItemsInRange")
+    {
+        for (int i = 0; i < clipCount; i += 10) {
+            timeline->getItemsInRange(tid, i * length + 1, (i + 2) * length);
+        }
+    }
+    BENCHMARK("getRowfromClip")
+    {
+        auto track = timeline->getTrackById_const(tid);
+        for (int i = 0; i < clipCount; ++i) {
+            track->getRowfromClip(clipIds[(size_t)i]);
+        }
+    }
+    BENCHMARK("Move and resize in the middle of the track")
+    {
+        int cid = clipIds[clipCount / 2];
+        int pos = timeline->getClipPosition(cid);
+        timeline->requestItemResize(cid, length - 5, false, false);
+        timeline->requestItemResize(cid, length, false, false);
+        timeline->requestItemResize(cid, length - 5, true, false);
+        timeline->requestClipMove(cid, tid, pos + 5);
+        timeline->requestClipMove(cid, tid, pos);
+        timeline->requestItemResize(cid, length, true, false);
+    }
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Dragging a large group", "[.][Benchmark]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+    std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_benchmark, guideModel, undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId = createProducer(profile_benchmark, "red", binModel);
+    int tid1 = TrackModel::construct(timeline);
+    int tid2 = TrackModel::construct(timeline);
+
+    // 500 clips spread on two tracks with gaps, and an obstacle after them
+    const int clipCount = 500;
+    const int length = 20;
+    std::unordered_set<int> clipIds;
+    int first = -1;
+    for (int i = 0; i < clipCount; ++i) {
+        int cid = -1;
+        REQUIRE(timeline->requestClipInsertion(binId, i % 2 == 0 ? tid1 : tid2, 1000 + i * length, cid, false));
+        clipIds.insert(cid);
+        if (first == -1) {
+            first = cid;
+        }
+    }
+    int groupEnd = 1000 + clipCount * length;
+    int obstacle = -1;
+    REQUIRE(timeline->requestClipInsertion(binId, tid2, groupEnd + 200, obstacle, false));
+    REQUIRE(timeline->requestClipsGroup(clipIds, false) > -1);
+    const std::unordered_set<int> selection = timeline->getMoveSelection(first);
+    REQUIRE(selection.size() == (size_t)clipCount);
+
+    BENCHMARK("Feasibility of 100 drag positions")
+    {
+        for (int step = 0; step < 100; ++step) {
+            int delta = step * 5 - 250;
+            REQUIRE(timeline->canMoveItems(selection, delta) == (delta <= 200));
+        }
+    }
+    REQUIRE(timeline->getFreeSlide(selection, true) == 200);
+    REQUIRE(timeline->getFreeSlide(selection, false) == 1000);
+
+    BENCHMARK("Drag the group over 20 positions")
+    {
+        int pos = 1000;
+        for (int step = 1; step <= 20; ++step) {
+            pos = timeline->suggestClipMove(first, tid1, 1000 + step * 15, -1);
+        }
+        // The group stops on the obstacle
+        REQUIRE(pos == 1200);
+        REQUIRE(timeline->suggestClipMove(first, tid1, 1000, -1) == 1000);
+    }
+    REQUIRE(timeline->getClipPosition(first) == 1000);
+    REQUIRE(timeline->checkConsistency());
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Timeline producer cloning", "[.][Benchmark]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId = createProducerWithSound(profile_benchmark, binModel);
+    auto clip = binModel->getClipByBinID(binId);
+    Mlt::Producer &master = *clip->originalProducer().get();
+
+    auto structural = ProjectClip::cloneProducerStructure(profile_benchmark, master, true);
+    REQUIRE(structural != nullptr);
+    REQUIRE(structural->is_valid());
+    REQUIRE(QString(structural->get("mlt_service")) == QString(master.get("mlt_service")));
+    REQUIRE(structural->get_length() == master.get_length());
+
+    const int cloneCount = 500;
+    BENCHMARK("Clone through xml")
+    {
+        for (int i = 0; i < cloneCount; ++i) {
+            REQUIRE(ProjectClip::cloneProducerXml(profile_benchmark, master)->is_valid());
+        }
+    }
+    BENCHMARK("Structural clone")
+    {
+        for (int i = 0; i < cloneCount; ++i) {
+            REQUIRE(ProjectClip::cloneProducerStructure(profile_benchmark, master, true)->is_valid());
+        }
+    }
+
+    // Synthetic project: many clips spread over many tracks, each track requiring its own producers
+    const int trackCount = 16;
+    const int clipsPerTrack = 50;
+    BENCHMARK("Open a synthetic project")
+    {
+        std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_benchmark, guideModel, undoStack);
+        std::vector<QString> binIds;
+        for (int i = 0; i < clipsPerTrack; ++i) {
+            binIds.push_back(createProducerWithSound(profile_benchmark, binModel));
+        }
+        for (int t = 0; t < trackCount; ++t) {
+            int tid = TrackModel::construct(timeline, -1, -1, QString(), t % 2 == 1);
+            for (int i = 0; i < clipsPerTrack; ++i) {
+                int cid = -1;
+                REQUIRE(timeline->requestClipInsertion(binIds[(size_t)i], tid, i * 10, cid, false));
+            }
+        }
+        REQUIRE(timeline->getClipsCount() >= trackCount * clipsPerTrack);
+    }
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Streaming audio level reduction", "[.][Benchmark]")
+{
+    // Ten minutes of stereo 48kHz audio at 25fps, fed in chunks as ffmpeg would write them to its stdout
+    const int channels = 2;
+    const int frequency = 48000;
+    const int frames = 25 * 600;
+    const int chunkSize = 65536;
+    QByteArray pcm(frames * (frequency / 25) * channels * 2, Qt::Uninitialized);
+    auto *samples = reinterpret_cast<qint16 *>(pcm.data());
+    for (int i = 0; i < pcm.size() / 2; ++i) {
+        samples[i] = qint16((i * 7919) % 65536 - 32768);
+    }
+
+    // The results are checked in the regular audio level tests
+    BENCHMARK("Reduce in fixed chunks")
+    {
+        AudioLevelReducer reducer(channels, frequency, 25.);
+        for (int pos = 0; pos < pcm.size(); pos += chunkSize) {
+            reducer.addData(pcm.mid(pos, chunkSize));
+        }
+        reducer.finish();
+    }
+}
+
+TEST_CASE("Waveform reads from a peak file", "[.][Benchmark]")
+{
+    // Two hours of stereo levels at 25fps
+    const int channels = 2;
+    const int frames = 25 * 7200;
+    QVector<uint8_t> levels(frames * channels);
+    for (int i = 0; i < levels.size(); ++i) {
+        levels[i] = uint8_t((i * 31) % 256);
+    }
+    QTemporaryDir dir;
+    const QString path = dir.filePath(QStringLiteral("levels.peaks"));
+    BENCHMARK("Write peak file")
+    {
+        REQUIRE(AudioPeakFile::write(path, levels, channels));
+    }
+    std::shared_ptr<AudioPeakFile> peaks = AudioPeakFile::open(path);
+    REQUIRE(peaks != nullptr);
+    REQUIRE(peaks->frameCount() == frames);
+    REQUIRE(peaks->levels() == levels);
+
+    // Draw 1000 pixels of the whole clip, as the timeline does when zoomed out
+    const int pixels = 1000;
+    const int framesPerPixel = frames / pixels;
+    int level = peaks->levelForSpan(framesPerPixel);
+    REQUIRE(level == 2);
+    BENCHMARK("Zoomed out waveform from pyramid")
+    {
+        for (int p = 0; p < pixels; ++p) {
+            for (int c = 0; c < channels; ++c) {
+                uint8_t expected = 0;
+                if (p % 100 == 0) {
+                    for (int f = p * framesPerPixel; f < (p + 1) * framesPerPixel; ++f) {
+                        expected = qMax(expected, levels.at(f * channels + c));
+                    }
+                    REQUIRE(peaks->peak(level, c, p * framesPerPixel, (p + 1) * framesPerPixel - 1) >= expected);
+                } else {
+                    peaks->peak(level, c, p * framesPerPixel, (p + 1) * framesPerPixel - 1);
+                }
+            }
+        }
+    }
+    REQUIRE(AudioPeakFile::open(dir.filePath(QStringLiteral("missing.peaks"))) == nullptr);
+}
+
+TEST_CASE("Scope frame queues", "[.][Benchmark]")
+{
+    // Same setup as ScopeWidget: the render thread pushes each displayed frame to every active scope,
+    // each scope pops them from its refresh thread. Frames carry the time at which they were pushed.
+    const int scopes = 3;
+    std::vector<std::unique_ptr<DataQueue<qint64>>> queues;
+    for (int i = 0; i < scopes; ++i) {
+        queues.emplace_back(new DataQueue<qint64>(3, DataQueue<qint64>::OverflowModeDiscardOldest));
+    }
+    QElapsedTimer clock;
+    clock.start();
+    std::atomic<bool> running(true);
+    std::atomic<qint64> maxLatency(0);
+    std::atomic<int> received(0);
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < scopes; ++i) {
+        consumers.emplace_back([&, i]() {
+            qint64 pushed;
+            while (running) {
+                while (queues[size_t(i)]->tryPop(pushed)) {
+                    qint64 latency = clock.nsecsElapsed() - pushed;
+                    qint64 previous = maxLatency;
+                    while (latency > previous && !maxLatency.compare_exchange_weak(previous, latency)) {
+                    }
+                    received++;
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    // Unpaced: cost of a push while the consumers keep reading
+    BENCHMARK("Push a frame to three scopes")
+    {
+        for (int frame = 0; frame < 100000; ++frame) {
+            for (auto &queue : queues) {
+                queue->push(clock.nsecsElapsed());
+            }
+        }
+    }
+
+    // Paced at 60fps for one second, once the consumers emptied the queues
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    maxLatency = 0;
+    received = 0;
+    qint64 maxPush = 0;
+    for (int frame = 0; frame < 60; ++frame) {
+        qint64 start = clock.nsecsElapsed();
+        for (auto &queue : queues) {
+            queue->push(clock.nsecsElapsed());
+        }
+        maxPush = qMax(maxPush, clock.nsecsElapsed() - start);
+        std::this_thread::sleep_for(std::chrono::microseconds(16667));
+    }
+    running = false;
+    for (auto &consumer : consumers) {
+        consumer.join();
+    }
+    qDebug() << "60fps with" << scopes << "scopes: longest push" << maxPush / 1000 << "us, longest latency" << maxLatency / 1000 << "us, received"
+             << received << "frames";
+    REQUIRE(received == 60 * scopes);
+
+    // Overflow modes
+    DataQueue<int> oldest(2, DataQueue<int>::OverflowModeDiscardOldest);
+    DataQueue<int> newest(2, DataQueue<int>::OverflowModeDiscardNewest);
+    for (int i = 0; i < 3; ++i) {
+        oldest.push(i);
+        newest.push(i);
+    }
+    int value;
+    REQUIRE(oldest.count() == 2);
+    REQUIRE(oldest.pop() == 1);
+    REQUIRE(oldest.pop() == 2);
+    REQUIRE_FALSE(oldest.tryPop(value));
+    REQUIRE(newest.pop() == 0);
+    REQUIRE(newest.pop() == 1);
+    REQUIRE_FALSE(newest.tryPop(value));
+}
+
+TEST_CASE("Clip job scheduler", "[.][Benchmark]")
+{
+    // A burst of background jobs followed by clip loading, as when importing a folder with proxies enabled
+    JobScheduler scheduler(4);
+    std::atomic<int> proxyRunning(0);
+    std::atomic<int> maxProxyRunning(0);
+    std::atomic<int> loadsDone(0);
+    std::atomic<int> proxiesDoneBeforeLoads(0);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 20; ++i) {
+        scheduler.enqueue(i, AbstractClipJob::PROXYJOB, [&]() {
+            int running = ++proxyRunning;
+            int previous = maxProxyRunning;
+            while (running > previous && !maxProxyRunning.compare_exchange_weak(previous, running)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (loadsDone < 100) {
+                proxiesDoneBeforeLoads++;
+            }
+            --proxyRunning;
+        });
+    }
+    std::atomic<qint64> lastLoad(0);
+    for (int i = 0; i < 100; ++i) {
+        scheduler.enqueue(100 + i, AbstractClipJob::LOADJOB, [&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (++loadsDone == 100) {
+                lastLoad = timer.elapsed();
+            }
+        });
+    }
+    REQUIRE(scheduler.cancel(19) == 1);
+    while (true) {
+        auto stats = scheduler.stats();
+        if (stats[AbstractClipJob::PROXYJOB].done == 19 && stats[AbstractClipJob::LOADJOB].done == 100) {
+            REQUIRE(stats[AbstractClipJob::PROXYJOB].peakQueued == 20);
+            REQUIRE(stats[AbstractClipJob::PROXYJOB].queued == 0);
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    qDebug() << "100 clips loaded after" << lastLoad << "ms, all jobs done after" << timer.elapsed() << "ms," << proxiesDoneBeforeLoads
+             << "proxies finished before the last clip loaded";
+    REQUIRE(maxProxyRunning <= 2);
+    // Proxies cannot take all the threads, so loading clips does not wait for them
+    REQUIRE(proxiesDoneBeforeLoads < 19);
+
+    BENCHMARK("Schedule 10000 short tasks")
+    {
+        std::atomic<int> done(0);
+        for (int i = 0; i < 10000; ++i) {
+            scheduler.enqueue(i, i % 2 == 0 ? AbstractClipJob::THUMBJOB : AbstractClipJob::LOADJOB, [&done]() { done++; });
+        }
+        while (done < 10000) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+TEST_CASE("Concurrent thumbnail cache lookups", "[.][Benchmark]")
+{
+    // Same access pattern as the timeline: several QML image threads reading thumbnails of the same clips
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId = createProducer(profile_benchmark, "red", binModel);
+    auto &cache = ThumbnailCache::get();
+    cache->clearCache();
+    const int positions = 1000;
+    QImage img(64, 36, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::red);
+    for (int i = 0; i < positions; ++i) {
+        cache->storeThumbnail(binId, i, img, false);
+    }
+    const int threads = 8;
+    ThumbnailCache::Statistics before = cache->statistics();
+    BENCHMARK("8 threads reading 1000 thumbnails")
+    {
+        std::vector<std::thread> readers;
+        for (int t = 0; t < threads; ++t) {
+            readers.emplace_back([&cache, &binId, t]() {
+                for (int i = 0; i < positions; ++i) {
+                    cache->getThumbnail(binId, (i + t * 97) % positions, true);
+                }
+            });
+        }
+        for (auto &reader : readers) {
+            reader.join();
+        }
+    }
+    ThumbnailCache::Statistics stats = cache->statistics();
+    qDebug() << "Thumbnail cache: hits" << stats.hits - before.hits << "misses" << stats.misses - before.misses << "evictions"
+             << stats.evictions - before.evictions;
+    REQUIRE(stats.misses == before.misses);
+    REQUIRE(stats.evictions == before.evictions);
+    REQUIRE(cache->getThumbnail(binId, positions, true).isNull());
+    cache->invalidateThumbsForClip(binId, false);
+    REQUIRE(cache->getThumbnail(binId, 0, true).isNull());
+
+    cache->clearCache();
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Thumbnail producer pool", "[.][Benchmark]")
+{
+    // Several QML image threads extracting thumbnails of the same clip
+    auto &pool = ThumbnailProducerPool::get();
+    pool->clear();
+    const QString binId = QStringLiteral("pool");
+    std::atomic<int> created{0};
+    auto create = [&created]() {
+        created++;
+        return new Mlt::Producer(profile_benchmark, "noise");
+    };
+    const int threads = 8;
+    const int thumbs = 50;
+    const int width = profile_benchmark.width() / 4;
+    const int height = profile_benchmark.height() / 4;
+
+    std::shared_ptr<Mlt::Producer> shared(create());
+    QMutex sharedMutex;
+    BENCHMARK("8 threads sharing one producer")
+    {
+        std::vector<std::thread> readers;
+        for (int t = 0; t < threads; ++t) {
+            readers.emplace_back([&, t]() {
+                for (int i = 0; i < thumbs; ++i) {
+                    QMutexLocker lock(&sharedMutex);
+                    shared->seek(t * thumbs + i);
+                    QScopedPointer<Mlt::Frame> frame(shared->get_frame());
+                    KThumb::getFrame(frame.data(), width, height);
+                }
+            });
+        }
+        for (auto &reader : readers) {
+            reader.join();
+        }
+    }
+    shared.reset();
+
+    // The behaviour of the pool is checked in the regular thumbnail tests
+    created = 0;
+    BENCHMARK("8 threads using the producer pool")
+    {
+        std::vector<std::thread> readers;
+        for (int t = 0; t < threads; ++t) {
+            readers.emplace_back([&, t]() {
+                for (int i = 0; i < thumbs; ++i) {
+                    std::shared_ptr<Mlt::Producer> producer = pool->checkout(binId, t * thumbs + i, create);
+                    producer->seek(t * thumbs + i);
+                    QScopedPointer<Mlt::Frame> frame(producer->get_frame());
+                    KThumb::getFrame(frame.data(), width, height);
+                }
+            });
+        }
+        for (auto &reader : readers) {
+            reader.join();
+        }
+    }
+    qDebug() << "Producer pool created" << created << "producers for" << threads << "threads";
+    pool->clear();
+}
+
+TEST_CASE("Thumbnail extraction from long GOP footage", "[.][Benchmark]")
+{
+    // Encode 20 seconds of H.264 with a keyframe every 10 seconds
+    QTemporaryDir dir;
+    const QString path = dir.filePath(QStringLiteral("longgop.mp4"));
+    const int frames = 500;
+    {
+        Mlt::Producer source(profile_benchmark, "noise");
+        source.set_in_and_out(0, frames - 1);
+        Mlt::Consumer encoder(profile_benchmark, "avformat", path.toUtf8().constData());
+        encoder.set("vcodec", "libx264");
+        encoder.set("preset", "ultrafast");
+        encoder.set("g", 250);
+        encoder.set("an", 1);
+        encoder.set("real_time", -1);
+        encoder.set("terminate_on_pause", 1);
+        if (!encoder.is_valid()) {
+            WARN("avformat consumer not available, skipping");
+            return;
+        }
+        encoder.connect(source);
+        encoder.run();
+    }
+    Mlt::Producer producer(profile_benchmark, path.toUtf8().constData());
+    if (!producer.is_valid() || producer.get_length() < frames) {
+        WARN("libx264 encoding not available, skipping");
+        return;
+    }
+    // One thumbnail every 12 frames, as the clip job requests them on a zoomed in timeline
+    std::vector<int> positions;
+    for (int i = 0; i < 40; ++i) {
+        positions.push_back(i * 12);
+    }
+    const int width = profile_benchmark.width() / 4;
+    const int height = profile_benchmark.height() / 4;
+    QElapsedTimer timer;
+
+    timer.start();
+    for (int pos : positions) {
+        producer.seek(pos);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        REQUIRE(!KThumb::getFrame(frame.data(), width, height).isNull());
+    }
+    qint64 seeking = timer.elapsed();
+
+    int extracted = 0;
+    producer.set("_kdenlive_decoded", -1);
+    timer.restart();
+    KThumb::extractFrames(producer, positions, KThumb::sequentialDecodeGap(QStringLiteral("h264"), profile_benchmark.fps()),
+                          [&](int, Mlt::Frame *frame) {
+                              REQUIRE(!KThumb::getFrame(frame, width, height).isNull());
+                              extracted++;
+                              return true;
+                          });
+    qint64 sequential = timer.elapsed();
+    REQUIRE(extracted == int(positions.size()));
+    qDebug() << "Thumbnail extraction per frame: seeking" << double(seeking) / positions.size() << "ms, sequential"
+             << double(sequential) / positions.size() << "ms";
+}
+
+TEST_CASE("Tree model with a large flat folder", "[.][Benchmark]")
+{
+    // Same access pattern as a QTreeView showing a bin folder with many clips
+    auto model = AbstractTreeModel::construct();
+    const int childCount = 50000;
+    std::vector<std::shared_ptr<TreeItem>> items;
+    items.reserve(childCount);
+    for (int i = 0; i < childCount; ++i) {
+        items.push_back(model->getRoot()->appendChild(QList<QVariant>{QString::number(i)}));
+    }
+    auto folder = model->getRoot()->appendChild(QList<QVariant>{QStringLiteral("folder")});
+    auto sub = folder->appendChild(QList<QVariant>{QStringLiteral("sub")});
+
+    BENCHMARK("index() for every row")
+    {
+        for (int i = 0; i < childCount; ++i) {
+            REQUIRE(model->index(i, 0).isValid());
+        }
+    }
+    BENCHMARK("getIndexFromItem / parent() for every row")
+    {
+        for (const auto &item : items) {
+            QModelIndex ix = model->getIndexFromItem(item);
+            REQUIRE_FALSE(model->parent(ix).isValid());
+        }
+        REQUIRE(model->parent(model->getIndexFromItem(sub)).row() == childCount);
+    }
+    BENCHMARK("Remove the first row, then query all rows")
+    {
+        auto root = model->getRoot();
+        auto item = root->child(0);
+        root->removeChild(item);
+        for (int i = 0; i < root->childCount(); ++i) {
+            REQUIRE(root->child(i)->row() == i);
+        }
+        REQUIRE(root->appendChild(item));
+        REQUIRE(item->row() == childCount + 1);
+    }
+    REQUIRE(model->checkConsistency());
+    REQUIRE(sub->row() == 0);
+}
+
+TEST_CASE("Scene detection", "[.][Benchmark]")
+{
+    // Shots of 100 frames, alternating colours
+    const QStringList colours = {QStringLiteral("red"), QStringLiteral("blue"), QStringLiteral("green"), QStringLiteral("white")};
+    const int shots = 20;
+    const int shotLength = 100;
+    auto createProducer = [&]() {
+        auto *playlist = new Mlt::Playlist(profile_benchmark);
+        for (int i = 0; i < shots; ++i) {
+            Mlt::Producer shot(profile_benchmark, QStringLiteral("color:%1").arg(colours.at(i % colours.size())).toUtf8().constData());
+            shot.set("length", shotLength);
+            playlist->append(shot, 0, shotLength - 1);
+        }
+        return std::unique_ptr<Mlt::Producer>(playlist);
+    };
+    const int frames = shots * shotLength;
+    std::atomic<bool> canceled{false};
+    auto progress = [](int) {};
+    QElapsedTimer timer;
+
+    // The results are checked in the regular scene detection tests
+    timer.start();
+    SceneDetector::detect(createProducer, 0, frames - 1, 1, progress, canceled);
+    qint64 singleTime = timer.elapsed();
+    for (int segments : {2, 3, 7, SceneDetector::segmentCount(frames)}) {
+        timer.restart();
+        SceneDetector::detect(createProducer, 0, frames - 1, segments, progress, canceled);
+        qint64 splitTime = timer.elapsed();
+        qDebug() << "Scene detection on" << frames << "frames:" << singleTime << "ms in one segment," << splitTime << "ms in" << segments << "segments";
+    }
+}
+
+TEST_CASE("Mixer level metering", "[.][Benchmark]")
+{
+    // Same setup as MixerWidget: the MLT thread analyses the levels of each frame and queues them,
+    // the GUI thread drains the queue when a frame is displayed
+    const int channels = 6;
+    const int frames = 25 * 60;
+    DataQueue<AudioLevelRecord> queue(38, DataQueue<AudioLevelRecord>::OverflowModeDiscardOldest);
+    std::atomic<bool> running(true);
+    std::thread gui([&]() {
+        AudioLevelRecord record;
+        while (running || queue.count() > 0) {
+            while (queue.tryPop(record)) {
+            }
+            std::this_thread::yield();
+        }
+    });
+    AudioLevelAnalyzer analyzer(25.);
+    QVector<double> amplitudes(channels);
+    BENCHMARK("Analyse and queue one minute of 5.1 audio")
+    {
+        analyzer.reset();
+        for (int pos = 0; pos < frames; ++pos) {
+            for (int i = 0; i < channels; ++i) {
+                amplitudes[i] = 0.5 * (1 + std::sin(pos * 0.1 + i));
+            }
+            queue.push(analyzer.process(pos, amplitudes));
+        }
+    }
+    running = false;
+    gui.join();
+    // The analysis and the handoff are checked in the regular audio level tests
+}
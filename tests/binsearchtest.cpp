@@ -0,0 +1,264 @@
+#include "test_utils.hpp"
+#include "bin/projectsortproxymodel.h"
+
+using namespace fakeit;
+Mlt::Profile profile_binsearch;
+
+namespace {
+QString addClip(const std::shared_ptr<ProjectItemModel> &binModel, const QString &name, const QString &parentId, const QString &tags = QString(),
+                int rating = 0)
+{
+    std::shared_ptr<Mlt::Producer> producer = std::make_shared<Mlt::Producer>(profile_binsearch, "color", "red");
+    producer->set("length", 20);
+    producer->set("out", 19);
+    producer->set("kdenlive:clipname", name.toUtf8().constData());
+    producer->set("kdenlive:tags", tags.toUtf8().constData());
+    producer->set("kdenlive:rating", rating);
+    REQUIRE(producer->is_valid());
+
+    QString binId = QString::number(binModel->getFreeClipId());
+    auto binClip = ProjectClip::construct(binId, QIcon(), binModel, producer);
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    REQUIRE(binModel->addItem(binClip, parentId, undo, redo));
+    return binId;
+}
+} // namespace
+
+TEST_CASE("Bin search and filters", "[ProjectSortProxyModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    // 3 scenes of 4 shots, each shot holding a take rated 1 to 4 and tagged red every other shot.
+    // The root also holds 4 interviews tagged blue and 4 beauty shots rated 5
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    std::vector<QString> sceneIds;
+    std::vector<std::vector<QString>> shotIds(3);
+    std::vector<std::vector<QString>> takeIds(3);
+    const QString rootId = binModel->getRootFolder()->clipId();
+    for (int i = 0; i < 3; ++i) {
+        QString sceneId;
+        REQUIRE(binModel->requestAddFolder(sceneId, QStringLiteral("Scene %1").arg(i), rootId, undo, redo));
+        sceneIds.push_back(sceneId);
+        for (int j = 0; j < 4; ++j) {
+            QString shotId;
+            REQUIRE(binModel->requestAddFolder(shotId, QStringLiteral("Shot %1_%2").arg(i).arg(j), sceneId, undo, redo));
+            shotIds[i].push_back(shotId);
+            const QString tags = j % 2 == 0 ? QStringLiteral("#ff0000") : QString();
+            takeIds[i].push_back(addClip(binModel, QStringLiteral("Take %1_%2").arg(i).arg(j), shotId, tags, j + 1));
+        }
+    }
+    std::vector<QString> interviewIds;
+    for (int i = 0; i < 4; ++i) {
+        interviewIds.push_back(addClip(binModel, QStringLiteral("Interview %1").arg(i), rootId, QStringLiteral("#0000ff")));
+        addClip(binModel, QStringLiteral("Beauty %1").arg(i), rootId, QString(), 5);
+    }
+
+    ProjectSortProxyModel proxy;
+    proxy.setSourceModel(binModel.get());
+    // Visible items, expanding every folder like a tree view would
+    std::function<int(const QModelIndex &)> visibleItems = [&](const QModelIndex &parent) {
+        int count = proxy.rowCount(parent);
+        int total = count;
+        for (int i = 0; i < count; ++i) {
+            total += visibleItems(proxy.index(i, 0, parent));
+        }
+        return total;
+    };
+    REQUIRE(visibleItems(QModelIndex()) == 35);
+
+    SECTION("Search strings")
+    {
+        // Matches are shown with their parent folders
+        proxy.slotSetSearchString(QStringLiteral("shot 1_2"));
+        REQUIRE(visibleItems(QModelIndex()) == 2);
+        proxy.slotSetSearchString(QStringLiteral("SHOT 1_2"));
+        REQUIRE(visibleItems(QModelIndex()) == 2);
+        // Shot 1_2, its take and Scene 1
+        proxy.slotSetSearchString(QStringLiteral("1_2"));
+        REQUIRE(visibleItems(QModelIndex()) == 3);
+        proxy.slotSetSearchString(QStringLiteral("2_1"));
+        REQUIRE(visibleItems(QModelIndex()) == 3);
+        proxy.slotSetSearchString(QStringLiteral("interview"));
+        REQUIRE(visibleItems(QModelIndex()) == 4);
+        proxy.slotSetSearchString(QStringLiteral("no such clip"));
+        REQUIRE(visibleItems(QModelIndex()) == 0);
+        proxy.slotSetSearchString(QString());
+        REQUIRE(visibleItems(QModelIndex()) == 35);
+    }
+
+    SECTION("Search strings shorter than 3 characters")
+    {
+        // The 3 shots and takes ending with _3, and the 3 scenes
+        proxy.slotSetSearchString(QStringLiteral("_3"));
+        REQUIRE(visibleItems(QModelIndex()) == 9);
+        proxy.slotSetSearchString(QStringLiteral("y "));
+        REQUIRE(visibleItems(QModelIndex()) == 4);
+        // Typing the string one character at a time, the scenes only show as parents
+        proxy.slotSetSearchString(QStringLiteral("t"));
+        REQUIRE(visibleItems(QModelIndex()) == 35);
+        proxy.slotSetSearchString(QStringLiteral("ta"));
+        REQUIRE(visibleItems(QModelIndex()) == 12 + 12 + 3);
+        proxy.slotSetSearchString(QStringLiteral("tak"));
+        REQUIRE(visibleItems(QModelIndex()) == 12 + 12 + 3);
+    }
+
+    SECTION("Tag, rating and type filters")
+    {
+        // Red takes of the even shots
+        proxy.slotSetFilters({QStringLiteral("#ff0000")}, 0, 0);
+        REQUIRE(visibleItems(QModelIndex()) == 6 + 6 + 3);
+        proxy.slotSetFilters({QStringLiteral("#0000ff")}, 0, 0);
+        REQUIRE(visibleItems(QModelIndex()) == 4);
+        proxy.slotSetFilters({QStringLiteral("#ff0000"), QStringLiteral("#0000ff")}, 0, 0);
+        REQUIRE(visibleItems(QModelIndex()) == 0);
+
+        proxy.slotSetFilters({}, 5, 0);
+        REQUIRE(visibleItems(QModelIndex()) == 4);
+        proxy.slotSetFilters({}, 2, 0);
+        REQUIRE(visibleItems(QModelIndex()) == 3 + 3 + 3);
+        proxy.slotSetFilters({QStringLiteral("#ff0000")}, 3, 0);
+        REQUIRE(visibleItems(QModelIndex()) == 3 + 3 + 3);
+        proxy.slotSetFilters({QStringLiteral("#ff0000")}, 2, 0);
+        REQUIRE(visibleItems(QModelIndex()) == 0);
+
+        proxy.slotSetFilters({}, 0, ClipType::Color);
+        REQUIRE(visibleItems(QModelIndex()) == 35);
+        proxy.slotSetFilters({}, 0, ClipType::Image);
+        REQUIRE(visibleItems(QModelIndex()) == 0);
+
+        // Filters and search string combine
+        proxy.slotSetFilters({QStringLiteral("#ff0000")}, 0, ClipType::Color);
+        proxy.slotSetSearchString(QStringLiteral("take 2_"));
+        REQUIRE(visibleItems(QModelIndex()) == 2 + 2 + 1);
+
+        // Changing the tags of an item updates the result
+        proxy.slotSetSearchString(QString());
+        auto interview = binModel->getItemByBinId(interviewIds.front());
+        interview->setTags(QStringLiteral("#ff0000;#0000ff"));
+        QModelIndex ix = binModel->getIndexFromItem(interview);
+        emit binModel->dataChanged(ix, ix, {AbstractProjectItem::DataTag});
+        REQUIRE(visibleItems(QModelIndex()) == 6 + 6 + 3 + 1);
+
+        proxy.slotClearSearchFilters();
+        REQUIRE(visibleItems(QModelIndex()) == 35);
+    }
+
+    SECTION("Rename")
+    {
+        proxy.slotSetSearchString(QStringLiteral("shot 1_2"));
+        REQUIRE(visibleItems(QModelIndex()) == 2);
+        auto folder = binModel->getFolderByBinId(shotIds[2][1]);
+        REQUIRE(folder != nullptr);
+        REQUIRE(binModel->requestRenameFolder_lambda(folder, QStringLiteral("Shot 1_2 bis"))());
+        // Scene 2 now shows too, with the renamed folder
+        REQUIRE(visibleItems(QModelIndex()) == 4);
+        proxy.slotSetSearchString(QStringLiteral("shot 2_1"));
+        REQUIRE(visibleItems(QModelIndex()) == 0);
+        REQUIRE(binModel->requestRenameFolder_lambda(folder, QStringLiteral("Shot 2_1"))());
+        REQUIRE(visibleItems(QModelIndex()) == 2);
+    }
+
+    SECTION("Delete")
+    {
+        proxy.slotSetSearchString(QStringLiteral("1_2"));
+        REQUIRE(visibleItems(QModelIndex()) == 3);
+        REQUIRE(binModel->requestBinClipDeletion(binModel->getItemByBinId(takeIds[1][2]), undo, redo));
+        REQUIRE(visibleItems(QModelIndex()) == 2);
+        // Deleting a folder removes its content from the results
+        REQUIRE(binModel->requestBinClipDeletion(binModel->getItemByBinId(sceneIds[1]), undo, redo));
+        REQUIRE(visibleItems(QModelIndex()) == 0);
+        proxy.slotSetSearchString(QStringLiteral("take"));
+        REQUIRE(visibleItems(QModelIndex()) == 8 + 8 + 2);
+        proxy.slotSetSearchString(QString());
+        REQUIRE(visibleItems(QModelIndex()) == 35 - 9);
+    }
+
+    SECTION("Insert into a nested folder")
+    {
+        proxy.slotSetSearchString(QStringLiteral("1_2"));
+        REQUIRE(visibleItems(QModelIndex()) == 3);
+        addClip(binModel, QStringLiteral("Take 1_2 extra"), shotIds[1][2], QStringLiteral("#ff0000"), 4);
+        REQUIRE(visibleItems(QModelIndex()) == 4);
+        QString folderId;
+        REQUIRE(binModel->requestAddFolder(folderId, QStringLiteral("Alternate 1_2"), shotIds[1][2], undo, redo));
+        REQUIRE(visibleItems(QModelIndex()) == 5);
+        addClip(binModel, QStringLiteral("Take 1_2 alternate"), folderId);
+        REQUIRE(visibleItems(QModelIndex()) == 6);
+
+        // A match deep in a folder that did not match brings its parents
+        proxy.slotSetSearchString(QStringLiteral("alternate"));
+        REQUIRE(visibleItems(QModelIndex()) == 4);
+        proxy.slotSetSearchString(QString());
+        // Takes of the last shots and the new take
+        proxy.slotSetFilters({}, 4, 0);
+        REQUIRE(visibleItems(QModelIndex()) == 4 + 4 + 3);
+    }
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Bin id lookups", "[ProjectItemModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    const QString rootId = binModel->getRootFolder()->clipId();
+    QString folderId;
+    REQUIRE(binModel->requestAddFolder(folderId, QStringLiteral("Folder"), rootId, undo, redo));
+    std::vector<QString> binIds;
+    for (int i = 0; i < 20; ++i) {
+        binIds.push_back(addClip(binModel, QStringLiteral("Clip %1").arg(i), i % 2 == 0 ? rootId : folderId));
+    }
+    for (const QString &binId : binIds) {
+        REQUIRE(binModel->getClipByBinID(binId) != nullptr);
+        REQUIRE(binModel->getClipByBinID(binId)->clipId() == binId);
+        REQUIRE(binModel->getItemByBinId(binId) != nullptr);
+        REQUIRE(binModel->hasClip(binId));
+        REQUIRE_FALSE(binModel->isIdFree(binId));
+    }
+
+    // The index follows the type of the item
+    REQUIRE(binModel->getFolderByBinId(folderId) != nullptr);
+    REQUIRE(binModel->getClipByBinID(folderId) == nullptr);
+    REQUIRE_FALSE(binModel->hasClip(folderId));
+    REQUIRE(binModel->getFolderByBinId(binIds.front()) == nullptr);
+
+    SECTION("Deleted clips are removed from the index")
+    {
+        REQUIRE(binModel->requestBinClipDeletion(binModel->getItemByBinId(binIds.back()), undo, redo));
+        REQUIRE_FALSE(binModel->hasClip(binIds.back()));
+        REQUIRE(binModel->getClipByBinID(binIds.back()) == nullptr);
+        REQUIRE(binModel->isIdFree(binIds.back()));
+        REQUIRE(binModel->hasClip(binIds.front()));
+    }
+
+    SECTION("Deleting a folder removes its clips from the index")
+    {
+        REQUIRE(binModel->requestBinClipDeletion(binModel->getItemByBinId(folderId), undo, redo));
+        REQUIRE(binModel->getFolderByBinId(folderId) == nullptr);
+        for (size_t i = 0; i < binIds.size(); ++i) {
+            REQUIRE(binModel->hasClip(binIds[i]) == (i % 2 == 0));
+        }
+    }
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
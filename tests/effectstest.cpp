@@ -11,6 +11,7 @@
 #include "definitions.h"
 #define private public
 #define protected public
+#include "assets/model/assetcommand.hpp"
 #include "core.h"
 #include "effects/effectsrepository.hpp"
 #include "effects/effectstack/model/effectitemmodel.hpp"
@@ -81,6 +82,55 @@ TEST_CASE("Effects stack", "[Effects]")
         REQUIRE(model->rowCount() == 1);
     }
 
+    SECTION("Bin clip changes change the timeline content hash")
+    {
+        const QByteArray before = timeline->getVideoContentHash(100, 125);
+        REQUIRE(timeline->getVideoContentHash(100, 125) == before);
+
+        // A bin effect changes the rendered frames of every instance
+        REQUIRE(model->appendEffect(anEffect));
+        const QByteArray withEffect = timeline->getVideoContentHash(100, 125);
+        REQUIRE(withEffect != before);
+        undoStack->undo();
+        REQUIRE(model->rowCount() == 0);
+        REQUIRE(timeline->getVideoContentHash(100, 125) == before);
+
+        // So do the producer properties of the bin clip
+        clip->setProducerProperty(QStringLiteral("force_colorspace"), 601);
+        REQUIRE(timeline->getVideoContentHash(100, 125) != before);
+        clip->setProducerProperty(QStringLiteral("force_colorspace"), QString());
+        REQUIRE(timeline->getVideoContentHash(100, 125) == before);
+    }
+
+    SECTION("Parameter changes of a gesture are merged")
+    {
+        REQUIRE(model->appendEffect(anEffect));
+        auto effect = std::static_pointer_cast<EffectItemModel>(model->getEffectStackRow(0));
+        QModelIndex ix = effect->index(0, 0);
+        int count = undoStack->count();
+
+        // A drag produces a single undo entry
+        effect->beginGesture();
+        for (int i = 0; i < 10; ++i) {
+            undoStack->push(new AssetCommand(effect, ix, QString::number(100 + i)));
+        }
+        effect->endGesture();
+        REQUIRE(undoStack->count() == count + 1);
+        REQUIRE(effect->data(ix, AssetParameterModel::ValueRole).toString() == QStringLiteral("109"));
+
+        // The next drag gets its own entry even if it follows immediately
+        effect->beginGesture();
+        undoStack->push(new AssetCommand(effect, ix, QStringLiteral("50")));
+        undoStack->push(new AssetCommand(effect, ix, QStringLiteral("60")));
+        effect->endGesture();
+        REQUIRE(undoStack->count() == count + 2);
+
+        undoStack->undo();
+        REQUIRE(effect->data(ix, AssetParameterModel::ValueRole).toString() == QStringLiteral("109"));
+        undoStack->undo();
+        REQUIRE(effect->data(ix, AssetParameterModel::ValueRole).toString() == QStringLiteral("75"));
+    }
+
     SECTION("Create cut with fade in")
     {
         auto clipModel = timeline->getClipPtr(cid1)->m_effectStack;
@@ -251,6 +251,23 @@ TEST_CASE("Keyframe model", "[KeyframeModel]")
         undoStack->undo();
         state1(6.1);
     }
+
+    SECTION("Interpolation")
+    {
+        REQUIRE(model->addKeyframe(GenTime(1.), KeyframeType::Linear, 10));
+        REQUIRE(model->addKeyframe(GenTime(2.), KeyframeType::Curve, 20));
+        REQUIRE(model->addKeyframe(GenTime(3.), KeyframeType::Linear, 0));
+        REQUIRE(model->getInterpolatedValue(30).toDouble() == Approx(12.));
+
+        // The parsed keyframes follow the modifications
+        REQUIRE(model->updateKeyframe(GenTime(2.), 40));
+        REQUIRE(model->getInterpolatedValue(30).toDouble() == Approx(16.));
+        undoStack->undo();
+        REQUIRE(model->getInterpolatedValue(30).toDouble() == Approx(12.));
+        REQUIRE(model->removeKeyframe(GenTime(2.)));
+        REQUIRE(model->getInterpolatedValue(50).toDouble() == Approx(5.));
+        REQUIRE(check_anim_identity(model));
+    }
     pCore->m_projectManager = nullptr;
     Logger::print_trace();
 }
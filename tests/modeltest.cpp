@@ -2067,3 +2067,172 @@ TEST_CASE("Operations under locked tracks", "[Locked]")
     pCore->m_projectManager = nullptr;
     Logger::print_trace();
 }
+
+TEST_CASE("Suggested clip moves", "[Model]")
+{
+    Logger::clear();
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    TimelineItemModel tim(&profile_model, undoStack);
+    Mock<TimelineItemModel> timMock(tim);
+    auto timeline = std::shared_ptr<TimelineItemModel>(&timMock.get(), [](...) {});
+    TimelineItemModel::finishConstruct(timeline, guideModel);
+
+    RESET(timMock);
+
+    QString binId = createProducer(profile_model, "red", binModel, 20);
+
+    int tid1 = TrackModel::construct(timeline);
+    int tid2 = TrackModel::construct(timeline);
+    int cid1 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    int cid2 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    int cid3 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+
+    // cid1 on [0, 20[ and an obstacle on [30, 50[ of the same track, cid3 on [0, 20[ of the other track
+    REQUIRE(timeline->requestClipMove(cid1, tid1, 0));
+    REQUIRE(timeline->requestClipMove(cid2, tid1, 30));
+    REQUIRE(timeline->requestClipMove(cid3, tid2, 0));
+    REQUIRE(timeline->checkConsistency());
+
+    SECTION("Single clip jumps over an obstacle")
+    {
+        REQUIRE(timeline->suggestClipMove(cid1, tid1, 60, -1, 0) == 60);
+        REQUIRE(timeline->getClipPosition(cid1) == 60);
+        REQUIRE(timeline->getClipTrackId(cid1) == tid1);
+        // And back before it
+        REQUIRE(timeline->suggestClipMove(cid1, tid1, 5, -1, 0) == 5);
+        REQUIRE(timeline->getClipPosition(cid1) == 5);
+        REQUIRE(timeline->checkConsistency());
+    }
+    SECTION("Single clip slides to an obstacle")
+    {
+        REQUIRE(timeline->suggestClipMove(cid1, tid1, 40, -1, 0) == 10);
+        REQUIRE(timeline->getClipPosition(cid1) == 10);
+        REQUIRE(timeline->checkConsistency());
+    }
+    SECTION("Group jumps over an obstacle")
+    {
+        REQUIRE(timeline->requestClipsGroup({cid1, cid3}) > -1);
+        REQUIRE(timeline->suggestClipMove(cid1, tid1, 60, -1, 0) == 60);
+        REQUIRE(timeline->getClipPosition(cid1) == 60);
+        REQUIRE(timeline->getClipPosition(cid3) == 60);
+        REQUIRE(timeline->getClipTrackId(cid1) == tid1);
+        REQUIRE(timeline->getClipTrackId(cid3) == tid2);
+        REQUIRE(timeline->getClipPosition(cid2) == 30);
+        REQUIRE(timeline->checkConsistency());
+    }
+    SECTION("Group slides to an obstacle")
+    {
+        REQUIRE(timeline->requestClipsGroup({cid1, cid3}) > -1);
+        REQUIRE(timeline->suggestClipMove(cid1, tid1, 40, -1, 0) == 10);
+        REQUIRE(timeline->getClipPosition(cid1) == 10);
+        REQUIRE(timeline->getClipPosition(cid3) == 10);
+        // Dragging it from the clip on the free track gives the same result
+        REQUIRE(timeline->suggestClipMove(cid3, tid2, 35, -1, 0) == 10);
+        REQUIRE(timeline->getClipPosition(cid1) == 10);
+        REQUIRE(timeline->checkConsistency());
+    }
+    SECTION("Nothing moves on a locked track")
+    {
+        timeline->setTrackLockedState(tid1, true);
+        REQUIRE(timeline->suggestClipMove(cid1, tid1, 60, -1, 0) == 0);
+        REQUIRE(timeline->suggestClipMove(cid1, tid1, 5, -1, 0) == 0);
+        REQUIRE(timeline->getClipPosition(cid1) == 0);
+
+        // A group with a clip on the locked track stays in place too
+        timeline->setTrackLockedState(tid1, false);
+        REQUIRE(timeline->requestClipsGroup({cid1, cid3}) > -1);
+        timeline->setTrackLockedState(tid1, true);
+        REQUIRE(timeline->suggestClipMove(cid3, tid2, 60, -1, 0) == 0);
+        REQUIRE(timeline->getClipPosition(cid1) == 0);
+        REQUIRE(timeline->getClipPosition(cid3) == 0);
+        REQUIRE(timeline->checkConsistency());
+    }
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Range queries follow the edits", "[Model]")
+{
+    Logger::clear();
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    TimelineItemModel tim(&profile_model, undoStack);
+    Mock<TimelineItemModel> timMock(tim);
+    auto timeline = std::shared_ptr<TimelineItemModel>(&timMock.get(), [](...) {});
+    TimelineItemModel::finishConstruct(timeline, guideModel);
+
+    RESET(timMock);
+
+    QString binId = createProducer(profile_model, "red", binModel, 20);
+    int tid = TrackModel::construct(timeline);
+
+    // 100 contiguous clips of 20 frames
+    const int clipCount = 100;
+    const int length = 20;
+    std::vector<int> clipIds;
+    for (int i = 0; i < clipCount; ++i) {
+        int cid = -1;
+        REQUIRE(timeline->requestClipInsertion(binId, tid, i * length, cid, false));
+        clipIds.push_back(cid);
+    }
+    // The end of the range is excluded
+    auto track = timeline->getTrackById_const(tid);
+    for (int i = 0; i < clipCount; ++i) {
+        REQUIRE(track->getRowfromClip(clipIds[(size_t)i]) == i);
+        REQUIRE(timeline->getItemsInRange(tid, i * length, i * length + 1) == std::unordered_set<int>({clipIds[(size_t)i]}));
+        REQUIRE(timeline->getItemsInRange(tid, i * length + 1, (i + 1) * length) == std::unordered_set<int>({clipIds[(size_t)i]}));
+        if (i + 1 < clipCount) {
+            REQUIRE(timeline->getItemsInRange(tid, i * length + 1, (i + 2) * length) ==
+                    std::unordered_set<int>({clipIds[(size_t)i], clipIds[(size_t)i + 1]}));
+        }
+    }
+    REQUIRE(timeline->getItemsInRange(tid, clipCount * length + 1, -1).empty());
+    REQUIRE(timeline->getItemsInRange(tid, 0, -1).size() == (size_t)clipCount);
+
+    // Resize and move a clip in the middle of the track
+    int cid = clipIds[clipCount / 2];
+    int pos = timeline->getClipPosition(cid);
+    REQUIRE(timeline->requestItemResize(cid, length - 5, false, false) == length - 5);
+    REQUIRE(timeline->getClipPosition(cid) == pos + 5);
+    REQUIRE(timeline->getItemsInRange(tid, pos, pos + 5).empty());
+    REQUIRE(timeline->getItemsInRange(tid, pos - 1, pos + 6) == std::unordered_set<int>({clipIds[clipCount / 2 - 1], cid}));
+    REQUIRE(timeline->requestItemResize(cid, length - 10, true, false) == length - 10);
+    REQUIRE(timeline->getItemsInRange(tid, pos + 15, pos + 20).empty());
+    REQUIRE(timeline->requestClipMove(cid, tid, pos + 10));
+    REQUIRE(timeline->getItemsInRange(tid, pos + length - 1, pos + length) == std::unordered_set<int>({cid}));
+    REQUIRE(timeline->getItemsInRange(tid, pos, pos + 10).empty());
+    REQUIRE(track->getRowfromClip(cid) == clipCount / 2);
+
+    // Deleting a clip shifts the rows of the following ones
+    REQUIRE(timeline->requestItemDeletion(clipIds.front()));
+    REQUIRE(timeline->getItemsInRange(tid, 0, length).empty());
+    REQUIRE(track->getRowfromClip(clipIds[1]) == 0);
+    REQUIRE(track->getRowfromClip(clipIds.back()) == clipCount - 2);
+    undoStack->undo();
+    REQUIRE(timeline->getItemsInRange(tid, 0, length) == std::unordered_set<int>({clipIds.front()}));
+    REQUIRE(track->getRowfromClip(clipIds.back()) == clipCount - 1);
+    REQUIRE(timeline->checkConsistency());
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
@@ -0,0 +1,66 @@
+#include "test_utils.hpp"
+#include "dialogs/renderwidget.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryFile>
+#include <QTreeWidget>
+
+TEST_CASE("Render queue restored in the next session", "[RenderQueue]")
+{
+    KConfigGroup group(KSharedConfig::openConfig(), "RenderQueue");
+    const QString previousQueue = group.readEntry("jobs", QString());
+
+    // The playlists of the jobs must exist to be restored
+    QTemporaryFile firstPlaylist;
+    QTemporaryFile secondPlaylist;
+    QTemporaryFile thirdPlaylist;
+    REQUIRE(firstPlaylist.open());
+    REQUIRE(secondPlaylist.open());
+    REQUIRE(thirdPlaylist.open());
+    QJsonArray queue;
+    const QStringList playlists = {firstPlaylist.fileName(), secondPlaylist.fileName(), thirdPlaylist.fileName()};
+    for (int i = 0; i < playlists.size(); ++i) {
+        QJsonObject job;
+        job.insert(QLatin1String("parameters"),
+                   QJsonArray::fromStringList({QStringLiteral("-pid:1"), playlists.at(i), QStringLiteral("/tmp/render%1.mp4").arg(i)}));
+        job.insert(QLatin1String("priority"), i);
+        queue.append(job);
+    }
+    group.writeEntry("jobs", QString::fromUtf8(QJsonDocument(queue).toJson(QJsonDocument::Compact)));
+
+    QTreeWidget runningJobs;
+    runningJobs.setColumnCount(2);
+    RenderWidget::restoreRenderQueue(&runningJobs);
+    REQUIRE(runningJobs.topLevelItemCount() == 3);
+    // Restoring again does not duplicate the jobs
+    RenderWidget::restoreRenderQueue(&runningJobs);
+    REQUIRE(runningJobs.topLevelItemCount() == 3);
+
+    // The first job was started and the second one is rendering, only the last one is still waiting
+    auto *first = static_cast<RenderJobItem *>(runningJobs.topLevelItem(0));
+    auto *second = static_cast<RenderJobItem *>(runningJobs.topLevelItem(1));
+    REQUIRE(first->status() == WAITINGJOB);
+    first->setStatus(STARTINGJOB);
+    second->setStatus(RUNNINGJOB);
+    RenderWidget::saveRenderQueue(&runningJobs);
+
+    QTreeWidget nextSession;
+    nextSession.setColumnCount(2);
+    RenderWidget::restoreRenderQueue(&nextSession);
+    REQUIRE(nextSession.topLevelItemCount() == 1);
+    REQUIRE(nextSession.topLevelItem(0)->text(1) == QStringLiteral("/tmp/render2.mp4"));
+
+    // Once every job is started, nothing is restored
+    static_cast<RenderJobItem *>(runningJobs.topLevelItem(2))->setStatus(STARTINGJOB);
+    RenderWidget::saveRenderQueue(&runningJobs);
+    QTreeWidget emptySession;
+    emptySession.setColumnCount(2);
+    RenderWidget::restoreRenderQueue(&emptySession);
+    REQUIRE(emptySession.topLevelItemCount() == 0);
+
+    group.writeEntry("jobs", previousQueue);
+}
@@ -0,0 +1,71 @@
+#include "test_utils.hpp"
+#include "jobs/scenedetector.hpp"
+#include <mlt++/MltPlaylist.h>
+
+Mlt::Profile profile_scenes;
+
+namespace {
+// Shots of shotLength frames, alternating colours
+std::unique_ptr<Mlt::Producer> createShots(int shots, int shotLength)
+{
+    const QStringList colours = {QStringLiteral("red"), QStringLiteral("blue"), QStringLiteral("green"), QStringLiteral("white")};
+    auto *playlist = new Mlt::Playlist(profile_scenes);
+    for (int i = 0; i < shots; ++i) {
+        Mlt::Producer shot(profile_scenes, QStringLiteral("color:%1").arg(colours.at(i % colours.size())).toUtf8().constData());
+        shot.set("length", shotLength);
+        playlist->append(shot, 0, shotLength - 1);
+    }
+    return std::unique_ptr<Mlt::Producer>(playlist);
+}
+} // namespace
+
+TEST_CASE("Scene detection", "[SceneDetector]")
+{
+    const int shots = 6;
+    const int shotLength = 25;
+    const int frames = shots * shotLength;
+    auto createProducer = [&]() { return createShots(shots, shotLength); };
+    std::vector<int> expected;
+    for (int i = 1; i < shots; ++i) {
+        expected.push_back(i * shotLength);
+    }
+    std::atomic<bool> canceled{false};
+    int lastProcessed = 0;
+    bool ordered = true;
+    auto progress = [&](int processed) {
+        ordered = ordered && processed >= lastProcessed;
+        lastProcessed = processed;
+    };
+
+    SECTION("One segment")
+    {
+        REQUIRE(SceneDetector::detect(createProducer, 0, frames - 1, 1, progress, canceled) == expected);
+        REQUIRE(ordered);
+        REQUIRE(lastProcessed == frames - 1);
+    }
+
+    SECTION("The result does not depend on the number of segments")
+    {
+        // Segments of 25 frames start on a cut, the cut must be found by comparing with the frame before the segment
+        for (int segments : {2, 3, 6, 7, SceneDetector::segmentCount(frames)}) {
+            lastProcessed = 0;
+            ordered = true;
+            REQUIRE(SceneDetector::detect(createProducer, 0, frames - 1, segments, progress, canceled) == expected);
+            REQUIRE(ordered);
+            REQUIRE(lastProcessed == frames - 1);
+        }
+    }
+
+    SECTION("Only the cuts of the range are reported")
+    {
+        REQUIRE(SceneDetector::detect(createProducer, 40, 110, 2, progress, canceled) == std::vector<int>({50, 75, 100}));
+        // A range starting on a cut does not report it
+        REQUIRE(SceneDetector::detect(createProducer, 50, 74, 2, progress, canceled).empty());
+    }
+
+    SECTION("Canceled detection")
+    {
+        canceled = true;
+        REQUIRE(SceneDetector::detect(createProducer, 0, frames - 1, 3, progress, canceled).size() < expected.size());
+    }
+}
@@ -0,0 +1,72 @@
+/* Standalone benchmark for the colour scope generators.
+   Feeds synthetic UHD frames to each generator and prints the frames per second it sustains.
+   Usage: scopesBenchmark [frames] */
+
+#include "scopes/colorscopes/histogramgenerator.h"
+#include "scopes/colorscopes/rgbparadegenerator.h"
+#include "scopes/colorscopes/vectorscopegenerator.h"
+#include "scopes/colorscopes/waveformgenerator.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QTextStream>
+#include <functional>
+
+namespace {
+QImage syntheticFrame(int seed)
+{
+    // Gradients with some noise, so that all scope bins get hit
+    QImage frame(3840, 2160, QImage::Format_RGB32);
+    quint32 noise = quint32(seed) * 2654435761u + 1;
+    for (int y = 0; y < frame.height(); ++y) {
+        auto *line = reinterpret_cast<QRgb *>(frame.scanLine(y));
+        for (int x = 0; x < frame.width(); ++x) {
+            noise = noise * 1664525u + 1013904223u;
+            int n = int(noise >> 28);
+            line[x] = qRgb((x * 255 / frame.width() + n) & 0xff, (y * 255 / frame.height() + n) & 0xff, ((x + y + seed) / 24 + n) & 0xff);
+        }
+    }
+    return frame;
+}
+
+void run(QTextStream &out, const QString &name, int frames, const std::function<QImage()> &generate)
+{
+    // Warm up the thread pool
+    generate();
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < frames; ++i) {
+        generate();
+    }
+    qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+    out << name << ": " << QString::number(1000. * frames / elapsed, 'f', 1) << " fps (" << elapsed / frames << " ms/frame)" << endl;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    const int frames = argc > 1 ? qMax(1, QString(argv[1]).toInt()) : 20;
+    QTextStream out(stdout);
+    const QImage frame = syntheticFrame(0);
+    const QSize scopeSize(720, 405);
+
+    WaveformGenerator waveform;
+    RGBParadeGenerator parade;
+    HistogramGenerator histogram;
+    VectorscopeGenerator vectorscope;
+    run(out, QStringLiteral("Waveform"), frames,
+        [&]() { return waveform.calculateWaveform(scopeSize, frame, WaveformGenerator::PaintMode_Green, true, WaveformGenerator::Rec_709); });
+    run(out, QStringLiteral("RGB Parade"), frames, [&]() { return parade.calculateRGBParade(scopeSize, frame, RGBParadeGenerator::PaintMode_RGB, true, true); });
+    run(out, QStringLiteral("Histogram"), frames, [&]() {
+        return histogram.calculateHistogram(scopeSize, frame,
+                                            HistogramGenerator::ComponentY | HistogramGenerator::ComponentR | HistogramGenerator::ComponentG |
+                                                HistogramGenerator::ComponentB | HistogramGenerator::ComponentSum,
+                                            HistogramGenerator::Rec_709, false);
+    });
+    run(out, QStringLiteral("Vectorscope"), frames, [&]() {
+        return vectorscope.calculateVectorscope(scopeSize, frame, 1.f, VectorscopeGenerator::PaintMode_Green2, VectorscopeGenerator::ColorSpace_YPbPr, false);
+    });
+    return 0;
+}
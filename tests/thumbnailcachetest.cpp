@@ -0,0 +1,148 @@
+#include "test_utils.hpp"
+#include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
+#include <QThread>
+#include <atomic>
+#include <thread>
+
+using namespace fakeit;
+Mlt::Profile profile_thumbcache;
+
+TEST_CASE("Volatile thumbnail cache", "[ThumbnailCache]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId = createProducer(profile_thumbcache, "red", binModel);
+    auto &cache = ThumbnailCache::get();
+    cache->clearCache();
+
+    SECTION("Small thumbnails")
+    {
+        QImage img(64, 36, QImage::Format_ARGB32_Premultiplied);
+        img.fill(Qt::red);
+        for (int i = 0; i < 100; ++i) {
+            cache->storeThumbnail(binId, i, img, false);
+        }
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(cache->hasThumbnail(binId, i, true));
+            REQUIRE(cache->getThumbnail(binId, i, true) == img);
+        }
+        REQUIRE_FALSE(cache->hasThumbnail(binId, 100, true));
+    }
+    SECTION("Thumbnails larger than a shard")
+    {
+        // 1.2 MB, more than the share of one shard of the cache
+        QImage img(640, 480, QImage::Format_RGB32);
+        img.fill(Qt::blue);
+        REQUIRE(img.sizeInBytes() > 1000000);
+        cache->storeThumbnail(binId, 0, img, false);
+        REQUIRE(cache->hasThumbnail(binId, 0, true));
+        REQUIRE(cache->getThumbnail(binId, 0, true) == img);
+
+        // Filling the cache with large images evicts the oldest ones, the last one is always kept
+        ThumbnailCache::Statistics before = cache->statistics();
+        for (int i = 1; i < 40; ++i) {
+            cache->storeThumbnail(binId, i, img, false);
+            REQUIRE(cache->getThumbnail(binId, i, true) == img);
+        }
+        ThumbnailCache::Statistics stats = cache->statistics();
+        REQUIRE(stats.evictions > before.evictions);
+    }
+
+    cache->clearCache();
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Thumbnail producer pool", "[ThumbnailProducerPool]")
+{
+    auto &pool = ThumbnailProducerPool::get();
+    pool->clear();
+    const QString binId = QStringLiteral("pool");
+    std::atomic<int> created{0};
+    auto create = [&created]() {
+        created++;
+        return new Mlt::Producer(profile_thumbcache, "noise");
+    };
+
+    SECTION("Producers are reused and bounded per clip")
+    {
+        std::vector<std::shared_ptr<Mlt::Producer>> producers;
+        for (int i = 0; i < pool->maxPerClip(); ++i) {
+            producers.push_back(pool->checkout(binId, i, create));
+            REQUIRE(producers.back() != nullptr);
+        }
+        REQUIRE(created == pool->maxPerClip());
+        REQUIRE(pool->idleCount() == 0);
+
+        // Another request waits until a producer is returned
+        std::atomic<bool> done{false};
+        std::thread waiting([&]() {
+            std::shared_ptr<Mlt::Producer> producer = pool->checkout(binId, 0, create);
+            done = producer != nullptr;
+        });
+        QThread::msleep(100);
+        REQUIRE_FALSE(done);
+        producers.pop_back();
+        waiting.join();
+        REQUIRE(done);
+        REQUIRE(created == pool->maxPerClip());
+        producers.clear();
+        REQUIRE(pool->idleCount() == pool->maxPerClip());
+    }
+
+    SECTION("Producer closest before the requested position")
+    {
+        std::shared_ptr<Mlt::Producer> early = pool->checkout(binId, 0, create);
+        std::shared_ptr<Mlt::Producer> late = pool->checkout(binId, 0, create);
+        early->set("_kdenlive_decoded", 10);
+        late->set("_kdenlive_decoded", 100);
+        Mlt::Producer *earlyProducer = early.get();
+        Mlt::Producer *lateProducer = late.get();
+        early.reset();
+        late.reset();
+        REQUIRE(pool->checkout(binId, 150, create).get() == lateProducer);
+        REQUIRE(pool->checkout(binId, 50, create).get() == earlyProducer);
+        REQUIRE(created == 2);
+    }
+
+    SECTION("An invalidated clip gets new producers")
+    {
+        std::shared_ptr<Mlt::Producer> idle = pool->checkout(binId, 0, create);
+        std::shared_ptr<Mlt::Producer> kept = pool->checkout(binId, 0, create);
+        idle.reset();
+        REQUIRE(pool->idleCount() == 1);
+        pool->invalidateClip(binId);
+        REQUIRE(pool->idleCount() == 0);
+        // The producer in use is not returned to the pool
+        kept.reset();
+        REQUIRE(pool->idleCount() == 0);
+        int before = created;
+        REQUIRE(pool->checkout(binId, 0, create) != nullptr);
+        REQUIRE(created == before + 1);
+    }
+
+    SECTION("Least recently used idle producers are evicted")
+    {
+        const int clips = pool->maxIdle() + 4;
+        for (int i = 0; i < clips; ++i) {
+            REQUIRE(pool->checkout(QString::number(i), 0, create) != nullptr);
+        }
+        REQUIRE(created == clips);
+        REQUIRE(pool->idleCount() == pool->maxIdle());
+        // The last clips are still pooled, the first ones were evicted
+        REQUIRE(pool->checkout(QString::number(clips - 1), 0, create) != nullptr);
+        REQUIRE(created == clips);
+        REQUIRE(pool->checkout(QStringLiteral("0"), 0, create) != nullptr);
+        REQUIRE(created == clips + 1);
+    }
+    pool->clear();
+    REQUIRE(pool->idleCount() == 0);
+}
@@ -0,0 +1,212 @@
+#include "test_utils.hpp"
+#include "undohelper.hpp"
+
+using namespace fakeit;
+
+namespace {
+// A command that is not functional: it cannot release anything when discarded
+class CounterCommand : public QUndoCommand
+{
+public:
+    explicit CounterCommand(int &counter)
+        : m_counter(counter)
+    {
+        setText(QStringLiteral("Count"));
+    }
+    void undo() override { m_counter--; }
+    void redo() override { m_counter++; }
+
+private:
+    int &m_counter;
+};
+
+qint64 totalFootprint(const std::shared_ptr<DocUndoStack> &undoStack)
+{
+    qint64 total = 0;
+    for (int i = undoStack->discardedCount(); i < undoStack->count(); ++i) {
+        total += DocUndoStack::footprint(undoStack->command(i));
+    }
+    return total;
+}
+} // namespace
+
+TEST_CASE("Undo history memory budget", "[DocUndoStack]")
+{
+    GenTime::setFps(pCore->getCurrentFps());
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> model = std::make_shared<MarkerListModel>(undoStack, nullptr);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    When(Method(pmMock, getGuideModel)).AlwaysReturn(model);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    // Functional operation adding delta to value, applied before being pushed like the models do
+    int value = 0;
+    auto pushOperation = [&](int delta, qint64 sizeHint = 0) {
+        value += delta;
+        Fun undo = [&value, delta]() {
+            value -= delta;
+            return true;
+        };
+        Fun redo = [&value, delta]() {
+            value += delta;
+            return true;
+        };
+        auto *command = new FunctionalUndoCommand(undo, redo, QStringLiteral("Add %1").arg(delta));
+        command->setSizeHint(sizeHint);
+        undoStack->push(command);
+    };
+
+    SECTION("Editing session")
+    {
+        REQUIRE(model->addMarker(GenTime(0), QLatin1String("0"), 0));
+        qint64 budget = 100 * DocUndoStack::footprint(undoStack->command(0));
+        undoStack->setMemoryBudget(budget);
+
+        // Scripted editing session, keeping the state after each operation
+        QStringList states;
+        states << model->toJson();
+        for (int i = 1; i < 10000; ++i) {
+            if (i % 3 == 2) {
+                REQUIRE(model->removeMarker(GenTime((i - 1) % 50)));
+            } else {
+                REQUIRE(model->addMarker(GenTime(i % 50), QString::number(i), i % 5));
+            }
+            states << model->toJson();
+            REQUIRE(undoStack->memoryUsage() <= budget);
+        }
+        REQUIRE(undoStack->count() == 10000);
+        REQUIRE(undoStack->discardedCount() > 9800);
+        REQUIRE(undoStack->memoryUsage() == totalFootprint(undoStack));
+
+        // Recent operations can still be undone
+        for (int i = 0; i < 50; ++i) {
+            undoStack->undo();
+            REQUIRE(model->toJson() == states.at(9998 - i));
+        }
+        // Undo stops at the oldest state that can be restored
+        for (int i = 0; i < 200; ++i) {
+            undoStack->undo();
+        }
+        REQUIRE(undoStack->index() == undoStack->discardedCount());
+        REQUIRE(model->toJson() == states.at(undoStack->discardedCount() - 1));
+        while (undoStack->canRedo()) {
+            undoStack->redo();
+        }
+        REQUIRE(model->toJson() == states.last());
+        REQUIRE(undoStack->memoryUsage() <= budget);
+
+        // A new operation keeps the budget
+        REQUIRE(model->addMarker(GenTime(60), QLatin1String("last"), 1));
+        REQUIRE(undoStack->memoryUsage() <= budget);
+    }
+
+    SECTION("Size hints and redo branch")
+    {
+        const qint64 mega = 1024 * 1024;
+        pushOperation(1);
+        const qint64 small = undoStack->memoryUsage();
+        REQUIRE(small < mega);
+        pushOperation(2, mega);
+        REQUIRE(undoStack->memoryUsage() > small + mega);
+        REQUIRE(undoStack->memoryUsage() == totalFootprint(undoStack));
+
+        // The undone operation is dropped from the usage when a new one replaces it
+        undoStack->undo();
+        REQUIRE(value == 1);
+        pushOperation(3);
+        REQUIRE(undoStack->count() == 2);
+        REQUIRE(undoStack->memoryUsage() < mega);
+        REQUIRE(undoStack->memoryUsage() == totalFootprint(undoStack));
+
+        // Large operations push the old ones out
+        undoStack->setMemoryBudget(3 * mega);
+        for (int i = 0; i < 5; ++i) {
+            pushOperation(10, mega);
+            REQUIRE(undoStack->memoryUsage() <= 3 * mega);
+        }
+        REQUIRE(value == 54);
+        REQUIRE(undoStack->discardedCount() == 5);
+        REQUIRE(undoStack->memoryUsage() == totalFootprint(undoStack));
+        for (int i = 0; i < 5; ++i) {
+            undoStack->undo();
+        }
+        REQUIRE(undoStack->index() == 5);
+        REQUIRE(value == 34);
+    }
+
+    SECTION("Commands that cannot release their data")
+    {
+        int counter = 0;
+        for (int i = 0; i < 5; ++i) {
+            undoStack->push(new CounterCommand(counter));
+        }
+        REQUIRE(counter == 5);
+        const qint64 usage = undoStack->memoryUsage();
+        REQUIRE(usage == totalFootprint(undoStack));
+
+        // They are discarded but cannot release anything, so undoing them still works
+        undoStack->setMemoryBudget(usage / 2);
+        REQUIRE(undoStack->discardedCount() == 4);
+        REQUIRE(undoStack->memoryUsage() == usage / 5);
+        REQUIRE(undoStack->memoryUsage() == totalFootprint(undoStack));
+
+        // Undoing past the discarded ones is bounced back, leaving the state unchanged
+        undoStack->undo();
+        REQUIRE(counter == 4);
+        REQUIRE(undoStack->index() == 4);
+        undoStack->undo();
+        REQUIRE(counter == 4);
+        REQUIRE(undoStack->index() == undoStack->discardedCount());
+        undoStack->redo();
+        REQUIRE(counter == 5);
+    }
+
+    SECTION("Macros")
+    {
+        undoStack->beginMacro(QStringLiteral("Macro"));
+        pushOperation(1);
+        pushOperation(2);
+        undoStack->endMacro();
+        REQUIRE(value == 3);
+        REQUIRE(undoStack->count() == 1);
+        REQUIRE(undoStack->command(0)->childCount() == 2);
+        REQUIRE(undoStack->memoryUsage() == totalFootprint(undoStack));
+
+        pushOperation(10);
+        pushOperation(10);
+        REQUIRE(value == 23);
+        REQUIRE(undoStack->memoryUsage() == totalFootprint(undoStack));
+
+        // The functional children of the macro release their data
+        const qint64 usage = undoStack->memoryUsage();
+        undoStack->setMemoryBudget(usage - 1);
+        REQUIRE(undoStack->discardedCount() == 1);
+        REQUIRE(undoStack->memoryUsage() < usage - 1);
+        REQUIRE(undoStack->memoryUsage() == totalFootprint(undoStack));
+
+        undoStack->undo();
+        undoStack->undo();
+        REQUIRE(value == 3);
+        // Undoing the discarded macro runs none of its functors
+        undoStack->undo();
+        REQUIRE(value == 3);
+        REQUIRE(undoStack->index() == 1);
+        while (undoStack->canRedo()) {
+            undoStack->redo();
+        }
+        REQUIRE(value == 23);
+
+        // A macro opened over a redo branch replaces it in the usage
+        undoStack->undo();
+        undoStack->beginMacro(QStringLiteral("Other macro"));
+        pushOperation(5);
+        undoStack->endMacro();
+        REQUIRE(value == 18);
+        REQUIRE(undoStack->count() == 3);
+        REQUIRE(undoStack->memoryUsage() == totalFootprint(undoStack));
+    }
+    pCore->m_projectManager = nullptr;
+}